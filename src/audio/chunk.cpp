@@ -1,4 +1,5 @@
 #include "chunk.h"
+#include "memory/memorytracker.h"
 #include "debug/assert.h"
 
 namespace flat::audio
@@ -8,6 +9,10 @@ Chunk::Chunk(const std::string& filename)
 {
     m_chunk = Mix_LoadWAV(filename.c_str());
     FLAT_ASSERT(m_chunk != nullptr);
+    if (m_chunk != nullptr)
+    {
+        FLAT_TRACK_ALLOCATION(memory::MemoryTag::AUDIO, m_chunk->alen);
+    }
 //TODO error checking
 //    if(!m_chunk) {
 //        std::cout <<"Mix_LoadWAV: " << Mix_GetError() << std::endl;
@@ -16,6 +21,10 @@ Chunk::Chunk(const std::string& filename)
 
 Chunk::~Chunk()
 {
+    if (m_chunk != nullptr)
+    {
+        FLAT_TRACK_FREE(memory::MemoryTag::AUDIO, m_chunk->alen);
+    }
     Mix_FreeChunk(m_chunk);
 }
 
@@ -0,0 +1,346 @@
+#ifndef FLAT_CONTAINERS_CHUNKEDPOOL_H
+#define FLAT_CONTAINERS_CHUNKEDPOOL_H
+
+#include <vector>
+#include <memory>
+#include <mutex>
+#include <algorithm>
+#include <utility>
+
+#include "containers/pool.h"
+#include "memory/memory.h"
+#include "debug/assert.h"
+
+namespace flat
+{
+namespace containers
+{
+
+// pool growing by chunks of ChunkSize objects, objects never move once created
+// create and destroy are not thread safe, threads sharing a pool must go through a ThreadCache each
+template <class T, unsigned int ChunkSize = 64>
+class ChunkedPool
+{
+	static_assert(ChunkSize > 0, "empty chunks");
+
+public:
+	class ThreadCache;
+
+public:
+	ChunkedPool() :
+		m_head(nullptr),
+		m_numAllocatedObjects(0),
+		m_numThreadCaches(0)
+	{
+
+	}
+
+	ChunkedPool(const ChunkedPool&) = delete;
+	ChunkedPool(ChunkedPool&&) = delete;
+
+	~ChunkedPool()
+	{
+		FLAT_ASSERT(m_numAllocatedObjects == 0);
+		FLAT_ASSERT(m_numThreadCaches == 0);
+	}
+
+	void operator=(const ChunkedPool&) = delete;
+
+	inline size_t getNumAllocatedObjects() const { return m_numAllocatedObjects; }
+	inline size_t getNumChunks() const { return m_chunks.size(); }
+	inline size_t getCapacity() const { return m_chunks.size() * ChunkSize; }
+
+	template <typename... ConstructorArgs>
+	T* create(ConstructorArgs&&... constructorArgs)
+	{
+		if (m_head == nullptr)
+		{
+			addChunk();
+		}
+		PoolEntry<T>* entry = m_head;
+		m_head = m_head->next;
+		++m_numAllocatedObjects;
+		return construct(entry, std::forward<ConstructorArgs>(constructorArgs)...);
+	}
+
+	void destroy(T* object)
+	{
+		FLAT_ASSERT(findChunk(reinterpret_cast<const PoolEntry<T>*>(object)) != nullptr);
+		PoolEntry<T>* entry = release(object);
+		entry->next = m_head;
+		m_head = entry;
+		--m_numAllocatedObjects;
+	}
+
+	// releases the chunks with no live object, single threaded only: no thread cache must be attached to the pool
+	void shrink_to_fit();
+
+private:
+	struct alignas(FLAT_CACHE_LINE_SIZE) Chunk
+	{
+		PoolEntry<T> entries[ChunkSize];
+	};
+
+	template <typename... ConstructorArgs>
+	static T* construct(PoolEntry<T>* entry, ConstructorArgs&&... constructorArgs)
+	{
+		T* object = reinterpret_cast<T*>(&entry->objectData);
+		FLAT_INIT_MEMORY(object, sizeof(T));
+		new (object) T(std::forward<ConstructorArgs>(constructorArgs)...);
+		return object;
+	}
+
+	PoolEntry<T>* release(T* object)
+	{
+		FLAT_ASSERT(object != nullptr);
+		PoolEntry<T>* entry = reinterpret_cast<PoolEntry<T>*>(object);
+		object->~T();
+		FLAT_WIPE_MEMORY(object, sizeof(T));
+		return entry;
+	}
+
+	void addChunk();
+	const Chunk* findChunk(const PoolEntry<T>* entry) const;
+	// same as findChunk, safe while other threads grow the pool
+	bool ownsEntry(const PoolEntry<T>* entry);
+
+	// moves up to count entries from the pool's free list to the thread cache's one
+	unsigned int acquireEntries(PoolEntry<T>*& head, unsigned int count);
+	// gives back a null terminated list of count entries
+	void releaseEntries(PoolEntry<T>* head, PoolEntry<T>* tail, unsigned int count);
+
+	void attachThreadCache();
+	void detachThreadCache();
+
+private:
+	std::vector<std::unique_ptr<Chunk>> m_chunks;
+	PoolEntry<T>* m_head;
+	size_t m_numAllocatedObjects;
+	unsigned int m_numThreadCaches;
+	std::mutex m_mutex;
+};
+
+// per thread free list refilled and drained by batches so that the pool's lock is only taken once every BatchSize
+// creations or destructions, objects can be destroyed through a different cache than the one that created them
+template <class T, unsigned int ChunkSize>
+class ChunkedPool<T, ChunkSize>::ThreadCache
+{
+public:
+	static constexpr unsigned int BatchSize = ChunkSize < 32 ? ChunkSize : 32;
+
+public:
+	ThreadCache(ChunkedPool& pool) :
+		m_pool(pool),
+		m_head(nullptr),
+		m_numEntries(0)
+	{
+		m_pool.attachThreadCache();
+	}
+
+	ThreadCache(const ThreadCache&) = delete;
+	ThreadCache(ThreadCache&&) = delete;
+
+	~ThreadCache()
+	{
+		flush();
+		m_pool.detachThreadCache();
+	}
+
+	void operator=(const ThreadCache&) = delete;
+
+	template <typename... ConstructorArgs>
+	T* create(ConstructorArgs&&... constructorArgs)
+	{
+		if (m_head == nullptr)
+		{
+			m_numEntries = m_pool.acquireEntries(m_head, BatchSize);
+		}
+		PoolEntry<T>* entry = m_head;
+		m_head = m_head->next;
+		--m_numEntries;
+		return ChunkedPool::construct(entry, std::forward<ConstructorArgs>(constructorArgs)...);
+	}
+
+	void destroy(T* object)
+	{
+		FLAT_ASSERT(m_pool.ownsEntry(reinterpret_cast<const PoolEntry<T>*>(object)));
+		PoolEntry<T>* entry = m_pool.release(object);
+		entry->next = m_head;
+		m_head = entry;
+		++m_numEntries;
+
+		// keep a batch for the next creations and give the rest back
+		if (m_numEntries >= BatchSize * 2)
+		{
+			PoolEntry<T>* tail = m_head;
+			for (unsigned int i = 1; i < BatchSize; ++i)
+			{
+				tail = tail->next;
+			}
+			PoolEntry<T>* kept = tail->next;
+			tail->next = nullptr;
+			m_pool.releaseEntries(m_head, tail, BatchSize);
+			m_head = kept;
+			m_numEntries -= BatchSize;
+		}
+	}
+
+	// gives all the cached entries back to the pool
+	void flush()
+	{
+		if (m_head == nullptr)
+		{
+			return;
+		}
+		PoolEntry<T>* tail = m_head;
+		while (tail->next != nullptr)
+		{
+			tail = tail->next;
+		}
+		m_pool.releaseEntries(m_head, tail, m_numEntries);
+		m_head = nullptr;
+		m_numEntries = 0;
+	}
+
+private:
+	ChunkedPool& m_pool;
+	PoolEntry<T>* m_head;
+	unsigned int m_numEntries;
+};
+
+template <class T, unsigned int ChunkSize>
+void ChunkedPool<T, ChunkSize>::shrink_to_fit()
+{
+	// entries cached by other threads would not be counted as free, and their chunk could be released under them
+	FLAT_ASSERT_MSG(m_numThreadCaches == 0, "Cannot shrink a chunked pool while thread caches are attached");
+	if (m_chunks.empty())
+	{
+		return;
+	}
+
+	// count the free entries of each chunk
+	std::sort(m_chunks.begin(), m_chunks.end(), [](const std::unique_ptr<Chunk>& a, const std::unique_ptr<Chunk>& b) { return a.get() < b.get(); });
+	auto getChunkIndex = [this](const PoolEntry<T>* entry)
+	{
+		auto it = std::upper_bound(m_chunks.begin(), m_chunks.end(), entry, [](const PoolEntry<T>* entry, const std::unique_ptr<Chunk>& chunk) { return entry < chunk->entries; });
+		FLAT_ASSERT(it != m_chunks.begin());
+		return static_cast<size_t>(it - m_chunks.begin()) - 1;
+	};
+	std::vector<unsigned int> numFreeEntries(m_chunks.size(), 0);
+	for (const PoolEntry<T>* entry = m_head; entry != nullptr; entry = entry->next)
+	{
+		++numFreeEntries[getChunkIndex(entry)];
+	}
+
+	// unlink the entries of the empty chunks then release them
+	PoolEntry<T>** previousNext = &m_head;
+	for (PoolEntry<T>* entry = m_head; entry != nullptr; entry = entry->next)
+	{
+		if (numFreeEntries[getChunkIndex(entry)] != ChunkSize)
+		{
+			*previousNext = entry;
+			previousNext = &entry->next;
+		}
+	}
+	*previousNext = nullptr;
+
+	size_t numKeptChunks = 0;
+	for (size_t i = 0; i < m_chunks.size(); ++i)
+	{
+		if (numFreeEntries[i] != ChunkSize)
+		{
+			m_chunks[numKeptChunks++] = std::move(m_chunks[i]);
+		}
+	}
+	m_chunks.resize(numKeptChunks);
+	m_chunks.shrink_to_fit();
+}
+
+template <class T, unsigned int ChunkSize>
+void ChunkedPool<T, ChunkSize>::addChunk()
+{
+	FLAT_ASSERT(m_head == nullptr);
+	m_chunks.push_back(std::make_unique<Chunk>());
+	PoolEntry<T>* entries = m_chunks.back()->entries;
+	for (unsigned int i = 0; i < ChunkSize - 1; ++i)
+	{
+		entries[i].next = &entries[i + 1];
+	}
+	entries[ChunkSize - 1].next = nullptr;
+	m_head = &entries[0];
+}
+
+template <class T, unsigned int ChunkSize>
+const typename ChunkedPool<T, ChunkSize>::Chunk* ChunkedPool<T, ChunkSize>::findChunk(const PoolEntry<T>* entry) const
+{
+	for (const std::unique_ptr<Chunk>& chunk : m_chunks)
+	{
+		if (chunk->entries <= entry && entry < chunk->entries + ChunkSize)
+		{
+			return chunk.get();
+		}
+	}
+	return nullptr;
+}
+
+template <class T, unsigned int ChunkSize>
+bool ChunkedPool<T, ChunkSize>::ownsEntry(const PoolEntry<T>* entry)
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+	return findChunk(entry) != nullptr;
+}
+
+template <class T, unsigned int ChunkSize>
+unsigned int ChunkedPool<T, ChunkSize>::acquireEntries(PoolEntry<T>*& head, unsigned int count)
+{
+	FLAT_ASSERT(count > 0);
+	std::lock_guard<std::mutex> lock(m_mutex);
+	if (m_head == nullptr)
+	{
+		addChunk();
+	}
+	head = m_head;
+	PoolEntry<T>* tail = m_head;
+	unsigned int numEntries = 1;
+	while (numEntries < count && tail->next != nullptr)
+	{
+		tail = tail->next;
+		++numEntries;
+	}
+	m_head = tail->next;
+	tail->next = nullptr;
+	m_numAllocatedObjects += numEntries;
+	return numEntries;
+}
+
+template <class T, unsigned int ChunkSize>
+void ChunkedPool<T, ChunkSize>::releaseEntries(PoolEntry<T>* head, PoolEntry<T>* tail, unsigned int count)
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+	tail->next = m_head;
+	m_head = head;
+	FLAT_ASSERT(m_numAllocatedObjects >= count);
+	m_numAllocatedObjects -= count;
+}
+
+template <class T, unsigned int ChunkSize>
+void ChunkedPool<T, ChunkSize>::attachThreadCache()
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+	++m_numThreadCaches;
+}
+
+template <class T, unsigned int ChunkSize>
+void ChunkedPool<T, ChunkSize>::detachThreadCache()
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+	FLAT_ASSERT(m_numThreadCaches > 0);
+	--m_numThreadCaches;
+}
+
+} // containers
+} // flat
+
+#endif // FLAT_CONTAINERS_CHUNKEDPOOL_H
+
+
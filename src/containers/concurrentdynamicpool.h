@@ -0,0 +1,292 @@
+#ifndef FLAT_CONTAINERS_CONCURRENTDYNAMICPOOL_H
+#define FLAT_CONTAINERS_CONCURRENTDYNAMICPOOL_H
+
+#include <cstdlib>
+#include <cstdint>
+#include <atomic>
+#include <utility>
+
+#include "memory/memory.h"
+#include "debug/assert.h"
+
+namespace flat
+{
+namespace containers
+{
+
+// DynamicPool that can be used from several threads at once
+// the free entries are kept as chains of up to MagazineSize entries in a lock-free stack (Treiber stack), the head
+// is tagged with a counter incremented on each change so that a compare exchange fails if the head was popped and
+// pushed back in between (ABA)
+// threads allocating a lot should use a Magazine each, it takes and gives back whole chains with a single compare exchange
+class ConcurrentDynamicPool
+{
+public:
+	static constexpr unsigned int MagazineSize = 32;
+
+	class Magazine;
+
+public:
+	ConcurrentDynamicPool() :
+		m_head(0),
+		m_buffer(nullptr),
+		m_nextEntries(nullptr),
+		m_nextChains(nullptr),
+		m_size(0),
+		m_objectSize(0)
+#ifdef FLAT_DEBUG
+		, m_numAllocatedObjects(0)
+#endif
+	{
+
+	}
+
+	ConcurrentDynamicPool(const ConcurrentDynamicPool&) = delete;
+	ConcurrentDynamicPool(ConcurrentDynamicPool&&) = delete;
+
+	~ConcurrentDynamicPool()
+	{
+		FLAT_ASSERT(m_numAllocatedObjects == 0);
+		free(m_buffer);
+		delete[] m_nextEntries;
+		delete[] m_nextChains;
+	}
+
+	void operator=(const ConcurrentDynamicPool&) = delete;
+
+	template <class T, unsigned int StaticSize>
+	void init()
+	{
+		init(sizeof(T), StaticSize);
+	}
+
+	// not thread safe
+	void init(size_t objectSize, size_t size)
+	{
+		FLAT_ASSERT(m_buffer == nullptr);
+		FLAT_ASSERT(objectSize > 0 && size > 0 && size < NULL_INDEX);
+		m_size = size;
+		m_objectSize = objectSize;
+		m_buffer = malloc(size * objectSize);
+		m_nextEntries = new std::atomic<std::uint32_t>[size];
+		m_nextChains = new std::atomic<std::uint32_t>[size];
+
+		// chains of MagazineSize consecutive entries, the first chain on top of the stack
+		for (size_t i = 0; i < size; ++i)
+		{
+			const bool isChainEnd = (i + 1) % MagazineSize == 0 || i + 1 == size;
+			m_nextEntries[i].store(isChainEnd ? NULL_INDEX : static_cast<std::uint32_t>(i + 1), std::memory_order_relaxed);
+			const size_t nextChain = i + MagazineSize;
+			m_nextChains[i].store(i % MagazineSize == 0 && nextChain < size ? static_cast<std::uint32_t>(nextChain) : NULL_INDEX, std::memory_order_relaxed);
+		}
+		m_head.store(makeHead(0, 0), std::memory_order_release);
+	}
+
+	template <class T, typename... ConstructorArgs>
+	T* create(ConstructorArgs&&... constructorArgs)
+	{
+		FLAT_ASSERT(sizeof(T) == m_objectSize);
+		const std::uint32_t chain = popChain();
+		if (chain == NULL_INDEX)
+		{
+			FLAT_ASSERT_MSG(false, "Concurrent pool exhausted (%d objects)", static_cast<int>(m_size));
+			return nullptr;
+		}
+
+		// keep the first entry and give the rest of the chain back
+		const std::uint32_t rest = m_nextEntries[chain].load(std::memory_order_relaxed);
+		if (rest != NULL_INDEX)
+		{
+			pushChain(rest);
+		}
+		return construct<T>(chain, std::forward<ConstructorArgs>(constructorArgs)...);
+	}
+
+	template <class T>
+	void destroy(T* object)
+	{
+		FLAT_ASSERT(sizeof(T) == m_objectSize);
+		const std::uint32_t index = release(object);
+		m_nextEntries[index].store(NULL_INDEX, std::memory_order_relaxed);
+		pushChain(index);
+	}
+
+private:
+	static constexpr std::uint32_t NULL_INDEX = 0xFFFFFFFF;
+
+	static inline std::uint64_t makeHead(std::uint32_t tag, std::uint32_t index) { return (static_cast<std::uint64_t>(tag) << 32) | index; }
+	static inline std::uint32_t getTag(std::uint64_t head) { return static_cast<std::uint32_t>(head >> 32); }
+	static inline std::uint32_t getIndex(std::uint64_t head) { return static_cast<std::uint32_t>(head); }
+
+	inline void* getEntry(std::uint32_t index) const
+	{
+		return static_cast<unsigned char*>(m_buffer) + static_cast<size_t>(index) * m_objectSize;
+	}
+
+	std::uint32_t getIndex(const void* entry) const
+	{
+		const std::ptrdiff_t offset = static_cast<const unsigned char*>(entry) - static_cast<const unsigned char*>(m_buffer);
+		const bool isAligned = offset % m_objectSize == 0;
+		FLAT_ASSERT(offset >= 0 && static_cast<size_t>(offset) < m_size * m_objectSize && isAligned);
+		return static_cast<std::uint32_t>(offset / m_objectSize);
+	}
+
+	template <class T, typename... ConstructorArgs>
+	T* construct(std::uint32_t index, ConstructorArgs&&... constructorArgs)
+	{
+		T* object = static_cast<T*>(getEntry(index));
+		FLAT_INIT_MEMORY(object, sizeof(T));
+		new (object) T(std::forward<ConstructorArgs>(constructorArgs)...);
+		FLAT_DEBUG_ONLY(m_numAllocatedObjects.fetch_add(1, std::memory_order_relaxed);)
+		return object;
+	}
+
+	template <class T>
+	std::uint32_t release(T* object)
+	{
+		FLAT_ASSERT(object != nullptr);
+		const std::uint32_t index = getIndex(object);
+		object->~T();
+		FLAT_WIPE_MEMORY(object, sizeof(T));
+		FLAT_DEBUG_ONLY(m_numAllocatedObjects.fetch_sub(1, std::memory_order_relaxed);)
+		return index;
+	}
+
+	std::uint32_t popChain()
+	{
+		std::uint64_t head = m_head.load(std::memory_order_acquire);
+		while (getIndex(head) != NULL_INDEX)
+		{
+			// the chain might be popped by another thread meanwhile, the tag makes the exchange fail in that case
+			const std::uint32_t nextChain = m_nextChains[getIndex(head)].load(std::memory_order_relaxed);
+			if (m_head.compare_exchange_weak(head, makeHead(getTag(head) + 1, nextChain), std::memory_order_acquire, std::memory_order_acquire))
+			{
+				return getIndex(head);
+			}
+		}
+		return NULL_INDEX;
+	}
+
+	void pushChain(std::uint32_t chain)
+	{
+		std::uint64_t head = m_head.load(std::memory_order_relaxed);
+		do
+		{
+			m_nextChains[chain].store(getIndex(head), std::memory_order_relaxed);
+		}
+		while (!m_head.compare_exchange_weak(head, makeHead(getTag(head) + 1, chain), std::memory_order_release, std::memory_order_relaxed));
+	}
+
+private:
+	// on its own cache line as every thread writes it
+	alignas(FLAT_CACHE_LINE_SIZE) std::atomic<std::uint64_t> m_head;
+	alignas(FLAT_CACHE_LINE_SIZE) void* m_buffer;
+	std::atomic<std::uint32_t>* m_nextEntries;
+	std::atomic<std::uint32_t>* m_nextChains;
+	size_t m_size;
+	size_t m_objectSize;
+	FLAT_DEBUG_ONLY(std::atomic<size_t> m_numAllocatedObjects;)
+};
+
+// per thread stack of free entries, must only be used by one thread at a time
+// objects can be destroyed through a different magazine than the one that created them
+class ConcurrentDynamicPool::Magazine
+{
+public:
+	Magazine(ConcurrentDynamicPool& pool) :
+		m_pool(pool),
+		m_head(NULL_INDEX),
+		m_numEntries(0)
+	{
+
+	}
+
+	Magazine(const Magazine&) = delete;
+	Magazine(Magazine&&) = delete;
+
+	~Magazine()
+	{
+		flush();
+	}
+
+	void operator=(const Magazine&) = delete;
+
+	template <class T, typename... ConstructorArgs>
+	T* create(ConstructorArgs&&... constructorArgs)
+	{
+		FLAT_ASSERT(sizeof(T) == m_pool.m_objectSize);
+		if (m_head == NULL_INDEX)
+		{
+			m_head = m_pool.popChain();
+			if (m_head == NULL_INDEX)
+			{
+				FLAT_ASSERT_MSG(false, "Concurrent pool exhausted (%d objects)", static_cast<int>(m_pool.m_size));
+				return nullptr;
+			}
+			m_numEntries = getChainSize(m_head);
+		}
+
+		const std::uint32_t index = m_head;
+		m_head = m_pool.m_nextEntries[index].load(std::memory_order_relaxed);
+		--m_numEntries;
+		return m_pool.construct<T>(index, std::forward<ConstructorArgs>(constructorArgs)...);
+	}
+
+	template <class T>
+	void destroy(T* object)
+	{
+		FLAT_ASSERT(sizeof(T) == m_pool.m_objectSize);
+		const std::uint32_t index = m_pool.release(object);
+		m_pool.m_nextEntries[index].store(m_head, std::memory_order_relaxed);
+		m_head = index;
+		++m_numEntries;
+
+		// keep a full magazine for the next creations and give the other one back
+		if (m_numEntries >= MagazineSize * 2)
+		{
+			std::uint32_t tail = m_head;
+			for (unsigned int i = 1; i < MagazineSize; ++i)
+			{
+				tail = m_pool.m_nextEntries[tail].load(std::memory_order_relaxed);
+			}
+			const std::uint32_t chain = m_pool.m_nextEntries[tail].load(std::memory_order_relaxed);
+			m_pool.m_nextEntries[tail].store(NULL_INDEX, std::memory_order_relaxed);
+			m_pool.pushChain(chain);
+			m_numEntries = MagazineSize;
+		}
+	}
+
+	// gives all the cached entries back to the pool
+	void flush()
+	{
+		if (m_head != NULL_INDEX)
+		{
+			m_pool.pushChain(m_head);
+			m_head = NULL_INDEX;
+			m_numEntries = 0;
+		}
+	}
+
+private:
+	unsigned int getChainSize(std::uint32_t chain) const
+	{
+		unsigned int size = 0;
+		for (; chain != NULL_INDEX; chain = m_pool.m_nextEntries[chain].load(std::memory_order_relaxed))
+		{
+			++size;
+		}
+		return size;
+	}
+
+private:
+	ConcurrentDynamicPool& m_pool;
+	std::uint32_t m_head;
+	unsigned int m_numEntries;
+};
+
+} // containers
+} // flat
+
+#endif // FLAT_CONTAINERS_CONCURRENTDYNAMICPOOL_H
+
+
@@ -0,0 +1,338 @@
+#ifndef FLAT_CONTAINERS_DYNAMICBITSET_H
+#define FLAT_CONTAINERS_DYNAMICBITSET_H
+
+#include <vector>
+#include <cstddef>
+#include <cstdint>
+
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+
+#include "containers/bitaccessor.h"
+
+#include "debug/assert.h"
+
+namespace flat
+{
+namespace containers
+{
+
+// bits packed in 64 bit words, for dirty flags, visibility masks or layer masks
+// the bits past the size are always 0 so that counting and whole mask operations work on entire words
+class DynamicBitset
+{
+	public:
+		using Word = std::uint64_t;
+		static constexpr size_t BITS_PER_WORD = 64;
+		static constexpr size_t NPOS = static_cast<size_t>(-1);
+
+	public:
+		DynamicBitset() :
+			m_size(0)
+		{
+
+		}
+
+		explicit DynamicBitset(size_t size, bool value = false) :
+			m_size(0)
+		{
+			resize(size, value);
+		}
+
+		// new bits are set to value
+		void resize(size_t size, bool value = false);
+		inline void clear() { m_words.clear(); m_size = 0; }
+		inline void reserve(size_t size) { m_words.reserve(getNumWords(size)); }
+
+		inline size_t getSize() const { return m_size; }
+		inline bool isEmpty() const { return m_size == 0; }
+
+		inline bool test(size_t index) const
+		{
+			FLAT_ASSERT(index < m_size);
+			return (m_words[index / BITS_PER_WORD] & getMask(index)) != 0;
+		}
+
+		inline void set(size_t index)
+		{
+			FLAT_ASSERT(index < m_size);
+			m_words[index / BITS_PER_WORD] |= getMask(index);
+		}
+
+		inline void set(size_t index, bool value)
+		{
+			if (value)
+			{
+				set(index);
+			}
+			else
+			{
+				reset(index);
+			}
+		}
+
+		inline void reset(size_t index)
+		{
+			FLAT_ASSERT(index < m_size);
+			m_words[index / BITS_PER_WORD] &= ~getMask(index);
+		}
+
+		inline void flip(size_t index)
+		{
+			FLAT_ASSERT(index < m_size);
+			m_words[index / BITS_PER_WORD] ^= getMask(index);
+		}
+
+		// sets the bit and returns its previous value, to mark visited elements
+		inline bool testAndSet(size_t index)
+		{
+			FLAT_ASSERT(index < m_size);
+			Word& word = m_words[index / BITS_PER_WORD];
+			const Word mask = getMask(index);
+			const bool previousValue = (word & mask) != 0;
+			word |= mask;
+			return previousValue;
+		}
+
+		void setAll();
+		void resetAll();
+
+		inline bool operator[](size_t index) const { return test(index); }
+
+		// same proxy as Array<bool>, the words are read as bytes which requires a little endian platform
+		inline BitAccessor operator[](size_t index)
+		{
+			FLAT_ASSERT(index < m_size);
+			return BitAccessor(reinterpret_cast<char*>(m_words.data()), static_cast<unsigned int>(index / 8), static_cast<unsigned char>(index % 8));
+		}
+
+		// number of set bits
+		size_t count() const;
+		bool any() const;
+		inline bool none() const { return !any(); }
+
+		// index of the first set bit at or after index, NPOS if there is none
+		size_t findFirst() const { return findNext(0); }
+		size_t findNext(size_t index) const;
+
+		// calls func(index) for each set bit in increasing order
+		template <typename Func>
+		void eachSetBit(Func func) const;
+
+		// whole mask operations, both bitsets must have the same size
+		DynamicBitset& operator&=(const DynamicBitset& other);
+		DynamicBitset& operator|=(const DynamicBitset& other);
+		DynamicBitset& operator^=(const DynamicBitset& other);
+		DynamicBitset& andNot(const DynamicBitset& other);
+
+		bool operator==(const DynamicBitset& other) const { return m_size == other.m_size && m_words == other.m_words; }
+		bool operator!=(const DynamicBitset& other) const { return !(*this == other); }
+
+		inline const Word* getWords() const { return m_words.data(); }
+		inline Word* getWords() { return m_words.data(); }
+		inline size_t getNumWords() const { return m_words.size(); }
+
+		static int popCount(Word word);
+		static int countTrailingZeros(Word word);
+
+	private:
+		static inline size_t getNumWords(size_t size) { return (size + BITS_PER_WORD - 1) / BITS_PER_WORD; }
+		static inline Word getMask(size_t index) { return Word(1) << (index % BITS_PER_WORD); }
+
+		// resets the bits past the size in the last word
+		void clearUnusedBits();
+
+	private:
+		std::vector<Word> m_words;
+		size_t m_size;
+};
+
+inline void DynamicBitset::resize(size_t size, bool value)
+{
+	const size_t previousSize = m_size;
+	m_words.resize(getNumWords(size), value ? ~Word(0) : Word(0));
+	m_size = size;
+
+	if (value && size > previousSize && previousSize % BITS_PER_WORD != 0)
+	{
+		// the unused bits of the previous last word were 0
+		m_words[previousSize / BITS_PER_WORD] |= ~Word(0) << (previousSize % BITS_PER_WORD);
+	}
+	clearUnusedBits();
+}
+
+inline void DynamicBitset::setAll()
+{
+	for (Word& word : m_words)
+	{
+		word = ~Word(0);
+	}
+	clearUnusedBits();
+}
+
+inline void DynamicBitset::resetAll()
+{
+	for (Word& word : m_words)
+	{
+		word = 0;
+	}
+}
+
+inline size_t DynamicBitset::count() const
+{
+	size_t numSetBits = 0;
+	for (Word word : m_words)
+	{
+		numSetBits += popCount(word);
+	}
+	return numSetBits;
+}
+
+inline bool DynamicBitset::any() const
+{
+	for (Word word : m_words)
+	{
+		if (word != 0)
+		{
+			return true;
+		}
+	}
+	return false;
+}
+
+inline size_t DynamicBitset::findNext(size_t index) const
+{
+	if (index >= m_size)
+	{
+		return NPOS;
+	}
+
+	size_t wordIndex = index / BITS_PER_WORD;
+	Word word = m_words[wordIndex] & (~Word(0) << (index % BITS_PER_WORD));
+	while (word == 0)
+	{
+		if (++wordIndex == m_words.size())
+		{
+			return NPOS;
+		}
+		word = m_words[wordIndex];
+	}
+	return wordIndex * BITS_PER_WORD + countTrailingZeros(word);
+}
+
+template <typename Func>
+inline void DynamicBitset::eachSetBit(Func func) const
+{
+	const size_t numWords = m_words.size();
+	for (size_t wordIndex = 0; wordIndex < numWords; ++wordIndex)
+	{
+		// clear the lowest set bit until the word is empty
+		for (Word word = m_words[wordIndex]; word != 0; word &= word - 1)
+		{
+			func(wordIndex * BITS_PER_WORD + countTrailingZeros(word));
+		}
+	}
+}
+
+// plain word loops, the compiler vectorizes them
+inline DynamicBitset& DynamicBitset::operator&=(const DynamicBitset& other)
+{
+	FLAT_ASSERT(m_size == other.m_size);
+	const size_t numWords = m_words.size();
+	Word* words = m_words.data();
+	const Word* otherWords = other.m_words.data();
+	for (size_t i = 0; i < numWords; ++i)
+	{
+		words[i] &= otherWords[i];
+	}
+	return *this;
+}
+
+inline DynamicBitset& DynamicBitset::operator|=(const DynamicBitset& other)
+{
+	FLAT_ASSERT(m_size == other.m_size);
+	const size_t numWords = m_words.size();
+	Word* words = m_words.data();
+	const Word* otherWords = other.m_words.data();
+	for (size_t i = 0; i < numWords; ++i)
+	{
+		words[i] |= otherWords[i];
+	}
+	return *this;
+}
+
+inline DynamicBitset& DynamicBitset::operator^=(const DynamicBitset& other)
+{
+	FLAT_ASSERT(m_size == other.m_size);
+	const size_t numWords = m_words.size();
+	Word* words = m_words.data();
+	const Word* otherWords = other.m_words.data();
+	for (size_t i = 0; i < numWords; ++i)
+	{
+		words[i] ^= otherWords[i];
+	}
+	return *this;
+}
+
+inline DynamicBitset& DynamicBitset::andNot(const DynamicBitset& other)
+{
+	FLAT_ASSERT(m_size == other.m_size);
+	const size_t numWords = m_words.size();
+	Word* words = m_words.data();
+	const Word* otherWords = other.m_words.data();
+	for (size_t i = 0; i < numWords; ++i)
+	{
+		words[i] &= ~otherWords[i];
+	}
+	return *this;
+}
+
+inline int DynamicBitset::popCount(Word word)
+{
+#if defined(__GNUC__)
+	return __builtin_popcountll(word);
+#else
+	// __popcnt64 would require the popcnt instruction
+	word = word - ((word >> 1) & 0x5555555555555555ull);
+	word = (word & 0x3333333333333333ull) + ((word >> 2) & 0x3333333333333333ull);
+	word = (word + (word >> 4)) & 0x0F0F0F0F0F0F0F0Full;
+	return static_cast<int>((word * 0x0101010101010101ull) >> 56);
+#endif
+}
+
+inline int DynamicBitset::countTrailingZeros(Word word)
+{
+	FLAT_ASSERT(word != 0);
+#if defined(_MSC_VER) && defined(_M_X64)
+	unsigned long index;
+	_BitScanForward64(&index, word);
+	return static_cast<int>(index);
+#elif defined(__GNUC__)
+	return __builtin_ctzll(word);
+#else
+	int index = 0;
+	while ((word & 1) == 0)
+	{
+		word >>= 1;
+		++index;
+	}
+	return index;
+#endif
+}
+
+inline void DynamicBitset::clearUnusedBits()
+{
+	const size_t numUsedBits = m_size % BITS_PER_WORD;
+	if (numUsedBits != 0)
+	{
+		m_words.back() &= ~(~Word(0) << numUsedBits);
+	}
+}
+
+} // containers
+} // flat
+
+#endif // FLAT_CONTAINERS_DYNAMICBITSET_H
+
+
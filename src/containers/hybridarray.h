@@ -1,206 +1,283 @@
 #ifndef FLAT_CONTAINERS_HYBRIDARRAY_H
 #define FLAT_CONTAINERS_HYBRIDARRAY_H
 
-#include <vector>
 #include <memory>
 #include <cstring>
+#include <cstdint>
+#include <utility>
+#include <type_traits>
+#include <initializer_list>
+
+#include "memory/memory.h"
+#include "debug/assert.h"
 
 namespace flat
 {
 namespace containers
 {
 
+// vector storing up to StaticSize elements inline, all the elements move to the heap at once when it gets bigger
+// the elements are always contiguous so iterators are plain pointers
 template <class T, int StaticSize>
 class HybridArray
 {
+	static_assert(StaticSize > 0, "use std::vector");
 	static constexpr unsigned int BufferSize = StaticSize * sizeof(T);
-	public:
-		class Iterator
-		{
-			public:
-				Iterator(const HybridArray<T, StaticSize>* array, T* pointer) :
-					m_array(array),
-					m_pointer(pointer)
-				{}
-
-				Iterator& operator++()
-				{
-					++m_pointer;
-					if (m_pointer - reinterpret_cast<const T*>(&m_array->m_buffer[0]) == m_array->m_arrayCount)
-					{
-						if (std::vector<T>* vector = m_array->m_vector.get())
-						{
-							m_pointer = &*vector->begin();
-						}
-					}
-					return *this;
-				}
-
-				T& operator*()
-				{
-					return *m_pointer;
-				}
-
-				T* operator->()
-				{
-					return m_pointer;
-				}
-
-				bool operator==(const Iterator& other)
-				{
-					FLAT_ASSERT(m_array == other.m_array);
-					return m_pointer == other.m_pointer;
-				}
+	// moved with memcpy instead of move construction + destruction
+	static constexpr bool IsTriviallyRelocatable = std::is_trivially_copyable<T>::value;
+	// inline elements are moved one by one, heap storage is stolen
+	static constexpr bool IsNothrowMovable = std::is_nothrow_move_constructible<T>::value;
 
-				bool operator!=(const Iterator& other)
-				{
-					return !(*this == other);
-				}
+	public:
+		using Iterator = T*;
+		using ConstIterator = const T*;
 
-			private:
-				const HybridArray<T, StaticSize>* m_array;
-				T* m_pointer;
-		};
+		using value_type = T;
+		using iterator = Iterator;
+		using const_iterator = ConstIterator;
 
 	public:
 		HybridArray() :
-			m_arrayCount(0)
+			m_data(getBuffer()),
+			m_size(0),
+			m_capacity(StaticSize)
 		{
 			FLAT_INIT_MEMORY(&m_buffer[0], BufferSize);
 		}
 
-		~HybridArray()
+		HybridArray(std::initializer_list<T> values) : HybridArray()
 		{
-			for (unsigned int i = 0; i < m_arrayCount; ++i)
+			reserve(static_cast<unsigned int>(values.size()));
+			for (const T& value : values)
 			{
-				T* object = reinterpret_cast<T*>(&m_buffer[0]) + i;
-				object->~T();
+				add(value);
 			}
+		}
 
+		HybridArray(const HybridArray& other) : HybridArray()
+		{
+			*this = other;
+		}
+
+		HybridArray(HybridArray&& other) noexcept(IsNothrowMovable) : HybridArray()
+		{
+			*this = std::move(other);
+		}
+
+		~HybridArray()
+		{
+			clear();
+			freeHeap();
 			FLAT_WIPE_MEMORY(&m_buffer[0], BufferSize);
 		}
-		
-		bool isInRange(unsigned int index) const
+
+		HybridArray& operator=(const HybridArray& other)
 		{
-			if (const std::vector<T>* vector = m_vector.get())
+			if (this != &other)
 			{
-				FLAT_ASSERT(m_arrayCount == StaticSize);
-				return index < m_arrayCount + vector->size();
+				clear();
+				reserve(other.m_size);
+				if (IsTriviallyRelocatable)
+				{
+					std::memcpy(static_cast<void*>(m_data), other.m_data, other.m_size * sizeof(T));
+				}
+				else
+				{
+					std::uninitialized_copy(other.begin(), other.end(), m_data);
+				}
+				m_size = other.m_size;
 			}
-			return index < m_arrayCount;
+			return *this;
 		}
 
-		int indexOf(const T& object) const
+		HybridArray& operator=(HybridArray&& other) noexcept(IsNothrowMovable)
 		{
-			int index = &object - reinterpret_cast<const T*>(&m_buffer[0]);
-			if (0 <= index && index < m_arrayCount)
-			{
-				return index;
-			}
-			else if (const std::vector<T>* vector = m_vector.get())
+			if (this != &other)
 			{
-				FLAT_ASSERT(m_arrayCount == StaticSize);
-				if (vector->begin() <= &object && &object < vector->end())
+				clear();
+				if (!other.isInline())
+				{
+					// steal the heap storage
+					freeHeap();
+					m_data = other.m_data;
+					m_capacity = other.m_capacity;
+					m_size = other.m_size;
+					other.m_data = other.getBuffer();
+					other.m_capacity = StaticSize;
+					other.m_size = 0;
+				}
+				else
 				{
-					return (&object - vector->begin()) + StaticSize;
+					relocate(other.m_data, other.m_size, m_data);
+					m_size = other.m_size;
+					other.m_size = 0;
 				}
 			}
-			return -1;
+			return *this;
 		}
-		
-		unsigned int getSize() const
+
+		inline bool isInRange(unsigned int index) const { return index < m_size; }
+		inline bool isEmpty() const { return m_size == 0; }
+		inline bool isInline() const { return m_data == getBuffer(); }
+
+		inline unsigned int getSize() const { return m_size; }
+		inline unsigned int getCapacity() const { return m_capacity; }
+
+		inline unsigned int size() const { return m_size; }
+		inline bool empty() const { return m_size == 0; }
+
+		inline T* data() { return m_data; }
+		inline const T* data() const { return m_data; }
+
+		int indexOf(const T& object) const
 		{
-			if (const std::vector<T>* vector = m_vector.get())
+			if (m_data <= &object && &object < m_data + m_size)
 			{
-				FLAT_ASSERT(m_arrayCount == StaticSize);
-				return StaticSize + static_cast<unsigned int>(vector->size());
+				return static_cast<int>(&object - m_data);
 			}
-			return m_arrayCount;
+			return -1;
 		}
-		
+
 		const T& operator[](unsigned int index) const
 		{
 			FLAT_ASSERT(isInRange(index));
-			if (index < m_arrayCount)
-			{
-				return *(reinterpret_cast<const T*>(&m_buffer[0]) + index);
-			}
-			FLAT_ASSERT(m_arrayCount == StaticSize);
-			FLAT_ASSERT(m_vector != nullptr);
-			return (*m_vector.get())[index - StaticSize];
+			return m_data[index];
 		}
-		
+
 		T& operator[](unsigned int index)
 		{
 			FLAT_ASSERT(isInRange(index));
-			if (index < m_arrayCount)
-			{
-				return *(reinterpret_cast<T*>(&m_buffer[0]) + index);
-			}
-			FLAT_ASSERT(m_arrayCount == StaticSize);
-			FLAT_ASSERT(m_vector != nullptr);
-			return (*m_vector.get())[index - StaticSize];
+			return m_data[index];
 		}
-		
+
+		inline T& back() { FLAT_ASSERT(m_size > 0); return m_data[m_size - 1]; }
+		inline const T& back() const { FLAT_ASSERT(m_size > 0); return m_data[m_size - 1]; }
+
 		void memset(int c)
 		{
-			std::memset(m_buffer, c, m_arrayCount);
-			if (const std::vector<T>* vector = m_vector.get())
+			static_assert(std::is_trivially_copyable<T>::value, "memset on a non trivial type");
+			std::memset(static_cast<void*>(m_data), c, m_size * sizeof(T));
+		}
+
+		template <typename... ConstructorArgs>
+		T& add(ConstructorArgs&&... constructorArgs)
+		{
+			if (m_size == m_capacity)
 			{
-				FLAT_ASSERT(m_arrayCount == StaticSize);
-				std::memset(vector->begin(), c, vector->size());
+				// the arguments might reference an element of the array, build the new element before moving the others
+				const unsigned int newCapacity = m_capacity * 2;
+				T* newData = allocate(newCapacity);
+				T* object = new (newData + m_size) T(std::forward<ConstructorArgs>(constructorArgs)...);
+				relocate(m_data, m_size, newData);
+				freeHeap();
+				m_data = newData;
+				m_capacity = newCapacity;
+				++m_size;
+				return *object;
 			}
+			T* object = new (m_data + m_size) T(std::forward<ConstructorArgs>(constructorArgs)...);
+			++m_size;
+			return *object;
 		}
 
 		template <typename... ConstructorArgs>
-		T& add(ConstructorArgs... constructorArgs)
+		inline T& emplace_back(ConstructorArgs&&... constructorArgs) { return add(std::forward<ConstructorArgs>(constructorArgs)...); }
+
+		inline void push_back(const T& value) { add(value); }
+		inline void push_back(T&& value) { add(std::move(value)); }
+
+		void pop_back()
 		{
-			if (m_arrayCount < StaticSize)
+			FLAT_ASSERT(m_size > 0);
+			--m_size;
+			m_data[m_size].~T();
+			FLAT_WIPE_MEMORY(static_cast<void*>(m_data + m_size), sizeof(T));
+		}
+
+		// swaps the element with the last one then removes it
+		void swapRemove(unsigned int index)
+		{
+			FLAT_ASSERT(isInRange(index));
+			if (index != m_size - 1)
 			{
-				T* object = reinterpret_cast<T*>(&m_buffer[0]) + m_arrayCount;
-				new (object) T(constructorArgs...);
-				++m_arrayCount;
-				return *object;
+				m_data[index] = std::move(m_data[m_size - 1]);
 			}
+			pop_back();
+		}
 
-			FLAT_ASSERT(m_arrayCount == StaticSize);
+		void clear()
+		{
+			if (!std::is_trivially_destructible<T>::value)
+			{
+				for (unsigned int i = 0; i < m_size; ++i)
+				{
+					m_data[i].~T();
+				}
+			}
+			FLAT_WIPE_MEMORY(static_cast<void*>(m_data), m_size * sizeof(T));
+			m_size = 0;
+		}
 
-			std::vector<T>* vector = m_vector.get();
-			if (vector == nullptr)
+		void reserve(unsigned int capacity)
+		{
+			if (capacity <= m_capacity)
 			{
-				m_vector = std::make_unique<std::vector<T>>();
-				vector = m_vector.get();
-				vector->reserve(StaticSize / 2);
+				return;
 			}
-			return vector->emplace_back(constructorArgs...);
+			T* newData = allocate(capacity);
+			relocate(m_data, m_size, newData);
+			freeHeap();
+			m_data = newData;
+			m_capacity = capacity;
 		}
 
-		template <typename... ConstructorArgs>
-		void push_back(ConstructorArgs... constructorArgs)
+		inline Iterator begin() { return m_data; }
+		inline Iterator end() { return m_data + m_size; }
+		inline ConstIterator begin() const { return m_data; }
+		inline ConstIterator end() const { return m_data + m_size; }
+
+	private:
+		inline T* getBuffer() { return reinterpret_cast<T*>(&m_buffer[0]); }
+		inline const T* getBuffer() const { return reinterpret_cast<const T*>(&m_buffer[0]); }
+
+		static T* allocate(unsigned int capacity)
 		{
-			add(constructorArgs...);
+			return std::allocator<T>().allocate(capacity);
 		}
 
-		Iterator begin()
+		void freeHeap()
 		{
-			return Iterator(this, reinterpret_cast<T*>(&m_buffer[0]));
+			if (!isInline())
+			{
+				std::allocator<T>().deallocate(m_data, m_capacity);
+				m_data = getBuffer();
+				m_capacity = StaticSize;
+			}
 		}
 
-		Iterator end()
+		// moves count elements to uninitialized memory, the source is left uninitialized
+		static void relocate(T* source, unsigned int count, T* destination)
 		{
-			if (std::vector<T>* vector = m_vector.get())
+			if (IsTriviallyRelocatable)
+			{
+				std::memcpy(static_cast<void*>(destination), source, count * sizeof(T));
+			}
+			else
 			{
-				FLAT_ASSERT(m_arrayCount == StaticSize);
-				T* endPointer = &*vector->end();
-				return Iterator(this, endPointer);
+				for (unsigned int i = 0; i < count; ++i)
+				{
+					new (destination + i) T(std::move(source[i]));
+					source[i].~T();
+				}
 			}
-			return Iterator(this, reinterpret_cast<T*>(&m_buffer[0]) + m_arrayCount);
+			FLAT_WIPE_MEMORY(static_cast<void*>(source), count * sizeof(T));
 		}
-		
+
 	private:
-		std::uint8_t m_buffer[BufferSize];
-		unsigned int m_arrayCount;
-		std::unique_ptr<std::vector<T>> m_vector;
+		T* m_data;
+		unsigned int m_size;
+		unsigned int m_capacity;
+		alignas(T) std::uint8_t m_buffer[BufferSize];
 };
 
 } // containers
@@ -209,4 +286,3 @@ class HybridArray
 #endif // FLAT_CONTAINERS_HYBRIDARRAY_H
 
 
-
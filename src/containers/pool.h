@@ -2,6 +2,8 @@
 #define FLAT_CONTAINERS_POOL_H
 
 #include <array>
+#include <algorithm>
+#include <utility>
 
 #include "memory/memory.h"
 #include "debug/assert.h"
@@ -12,7 +14,7 @@ namespace containers
 {
 
 template <class T>
-union alignas(std::max(alignof(T), alignof(PoolEntry<T>*))) PoolEntry
+union alignas(std::max(alignof(T), alignof(void*))) PoolEntry
 {
 	static_assert(sizeof(T) != 0, "T undeclared?");
 	uint8_t objectData[sizeof(T)];
@@ -42,14 +44,14 @@ public:
 	FLAT_DEBUG_ONLY(inline size_t getNumAllocatedObjects() { return m_numAllocatedObjects; })
 
 	template <typename... ConstructorArgs>
-	T* create(ConstructorArgs... constructorArgs)
+	T* create(ConstructorArgs&&... constructorArgs)
 	{
 		FLAT_ASSERT(m_numAllocatedObjects < StaticSize);
 		FLAT_ASSERT(m_head != nullptr);
 		T* object = reinterpret_cast<T*>(&m_head->objectData);
 		m_head = m_head->next;
 		FLAT_INIT_MEMORY(object, sizeof(T));
-		new (object) T(constructorArgs...);
+		new (object) T(std::forward<ConstructorArgs>(constructorArgs)...);
 		FLAT_DEBUG_ONLY(++m_numAllocatedObjects;)
 		return object;
 	}
@@ -61,7 +63,8 @@ public:
 		FLAT_ASSERT(indexOf(entry) >= 0);
 		object->~T();
 		FLAT_WIPE_MEMORY(object, sizeof(T));
-		setNext(entry, *m_head);
+		// the pool may be full, in which case m_head is null
+		entry.next = m_head;
 		m_head = &entry;
 		FLAT_DEBUG_ONLY(--m_numAllocatedObjects;)
 	}
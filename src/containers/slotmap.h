@@ -0,0 +1,186 @@
+#ifndef FLAT_CONTAINERS_SLOTMAP_H
+#define FLAT_CONTAINERS_SLOTMAP_H
+
+#include <vector>
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+
+#include "debug/assert.h"
+
+namespace flat
+{
+namespace containers
+{
+
+// 32 bit slot index + 32 bit generation, the generation changes each time the slot is reused so that
+// handles to erased values are detected instead of silently pointing to another value
+struct SlotMapHandle
+{
+	std::uint32_t index = 0;
+	std::uint32_t generation = 0; // always odd for a valid handle
+
+	inline bool isNull() const { return generation == 0; }
+	inline bool operator==(const SlotMapHandle& other) const { return index == other.index && generation == other.generation; }
+	inline bool operator!=(const SlotMapHandle& other) const { return !(*this == other); }
+};
+
+// values stored contiguously, erasing moves the last value in place of the erased one
+// insert, erase and lookup are O(1), pointers to values are invalidated by insert and erase but handles are not
+template <class T>
+class SlotMap
+{
+	public:
+		using Handle = SlotMapHandle;
+		using Iterator = typename std::vector<T>::iterator;
+		using ConstIterator = typename std::vector<T>::const_iterator;
+
+	public:
+		SlotMap() :
+			m_freeSlotIndex(NULL_INDEX)
+		{
+
+		}
+
+		template <typename... ConstructorArgs>
+		Handle insert(ConstructorArgs&&... constructorArgs);
+
+		// returns false if the handle is stale
+		bool erase(Handle handle);
+
+		void clear();
+		void reserve(size_t size);
+
+		inline bool isValid(Handle handle) const
+		{
+			// free slots have an even generation
+			return (handle.generation & 1) != 0 && handle.index < m_slots.size() && m_slots[handle.index].generation == handle.generation;
+		}
+
+		// nullptr if the handle is stale
+		inline T* get(Handle handle)
+		{
+			return isValid(handle) ? &m_values[m_slots[handle.index].valueIndex] : nullptr;
+		}
+
+		inline const T* get(Handle handle) const
+		{
+			return isValid(handle) ? &m_values[m_slots[handle.index].valueIndex] : nullptr;
+		}
+
+		// handle of the value at index in the dense storage
+		inline Handle getHandle(size_t valueIndex) const
+		{
+			FLAT_ASSERT(valueIndex < m_values.size());
+			const std::uint32_t slotIndex = m_valueSlots[valueIndex];
+			return Handle{ slotIndex, m_slots[slotIndex].generation };
+		}
+
+		inline size_t getSize() const { return m_values.size(); }
+		inline bool isEmpty() const { return m_values.empty(); }
+
+		inline T* getData() { return m_values.data(); }
+		inline const T* getData() const { return m_values.data(); }
+
+		inline Iterator begin() { return m_values.begin(); }
+		inline Iterator end() { return m_values.end(); }
+		inline ConstIterator begin() const { return m_values.begin(); }
+		inline ConstIterator end() const { return m_values.end(); }
+
+	private:
+		static constexpr std::uint32_t NULL_INDEX = 0xFFFFFFFF;
+
+		struct Slot
+		{
+			std::uint32_t valueIndex; // next free slot when the slot is free
+			std::uint32_t generation; // odd when the slot is used
+		};
+
+	private:
+		std::vector<T> m_values;
+		std::vector<std::uint32_t> m_valueSlots;
+		std::vector<Slot> m_slots;
+		std::uint32_t m_freeSlotIndex;
+};
+
+template <class T>
+template <typename... ConstructorArgs>
+typename SlotMap<T>::Handle SlotMap<T>::insert(ConstructorArgs&&... constructorArgs)
+{
+	std::uint32_t slotIndex;
+	if (m_freeSlotIndex != NULL_INDEX)
+	{
+		slotIndex = m_freeSlotIndex;
+		m_freeSlotIndex = m_slots[slotIndex].valueIndex;
+	}
+	else
+	{
+		FLAT_ASSERT(m_slots.size() < NULL_INDEX);
+		slotIndex = static_cast<std::uint32_t>(m_slots.size());
+		m_slots.push_back({ NULL_INDEX, 0 });
+	}
+
+	m_values.emplace_back(std::forward<ConstructorArgs>(constructorArgs)...);
+	m_valueSlots.push_back(slotIndex);
+
+	Slot& slot = m_slots[slotIndex];
+	slot.valueIndex = static_cast<std::uint32_t>(m_values.size() - 1);
+	++slot.generation;
+	FLAT_ASSERT((slot.generation & 1) == 1);
+	return Handle{ slotIndex, slot.generation };
+}
+
+template <class T>
+bool SlotMap<T>::erase(Handle handle)
+{
+	if (!isValid(handle))
+	{
+		return false;
+	}
+
+	Slot& slot = m_slots[handle.index];
+	const std::uint32_t valueIndex = slot.valueIndex;
+	const std::uint32_t lastValueIndex = static_cast<std::uint32_t>(m_values.size() - 1);
+	if (valueIndex != lastValueIndex)
+	{
+		m_values[valueIndex] = std::move(m_values[lastValueIndex]);
+		m_valueSlots[valueIndex] = m_valueSlots[lastValueIndex];
+		m_slots[m_valueSlots[valueIndex]].valueIndex = valueIndex;
+	}
+	m_values.pop_back();
+	m_valueSlots.pop_back();
+
+	++slot.generation;
+	slot.valueIndex = m_freeSlotIndex;
+	m_freeSlotIndex = handle.index;
+	return true;
+}
+
+template <class T>
+void SlotMap<T>::clear()
+{
+	for (std::uint32_t valueSlot : m_valueSlots)
+	{
+		Slot& slot = m_slots[valueSlot];
+		++slot.generation;
+		slot.valueIndex = m_freeSlotIndex;
+		m_freeSlotIndex = valueSlot;
+	}
+	m_values.clear();
+	m_valueSlots.clear();
+}
+
+template <class T>
+void SlotMap<T>::reserve(size_t size)
+{
+	m_values.reserve(size);
+	m_valueSlots.reserve(size);
+	m_slots.reserve(size);
+}
+
+} // containers
+} // flat
+
+#endif // FLAT_CONTAINERS_SLOTMAP_H
+
+
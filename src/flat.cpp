@@ -16,6 +16,7 @@ Flat::Flat(const std::string& luaPath, const std::string& assetsPath)
 {
 	SDL_Init(SDL_INIT_VIDEO | SDL_INIT_GAMECONTROLLER);
 
+	frameArena = std::make_unique<memory::FrameArena>();
 	time = std::make_unique<time::Time>();
 	video = std::make_unique<video::Video>();
 	audio = std::make_unique<audio::Audio>();
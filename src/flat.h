@@ -6,6 +6,8 @@
 // single header public API
 
 #include "memory/memory.h"
+#include "memory/framearena.h"
+#include "memory/memorytracker.h"
 
 #include "input/input.h"
 #include "input/lua/mouse.h"
@@ -29,6 +31,8 @@
 #include "geometry/circle.h"
 #include "geometry/rectangle.h"
 #include "geometry/grid.h"
+#include "geometry/quadtree.h"
+#include "geometry/broadphase.h"
 #include "geometry/bezier.h"
 #include "geometry/intersection.h"
 
@@ -37,6 +41,7 @@
 #include "video/render.h"
 #include "video/color.h"
 #include "video/filetexture.h"
+#include "video/atlas.h"
 
 // state
 #include "state/state.h"
@@ -65,12 +70,18 @@
 #include "render/spritesynchronizer.h"
 #include "render/heightmap.h"
 #include "render/spritebatch.h"
+#include "render/spriterenderer.h"
+#include "render/staticspritelayer.h"
 #include "render/programsettings.h"
 
 // containers
 #include "containers/pool.h"
 #include "containers/dynamicpool.h"
+#include "containers/chunkedpool.h"
+#include "containers/concurrentdynamicpool.h"
 #include "containers/hybridarray.h"
+#include "containers/dynamicbitset.h"
+#include "containers/slotmap.h"
 
 // resource
 #include "resource/sharedresourcemanager.h"
@@ -119,6 +130,7 @@ class Flat
 		Flat& operator=(const Flat&) = delete;
 
 	public:
+		std::unique_ptr<memory::FrameArena> frameArena;
 		std::unique_ptr<time::Time> time;
 		std::unique_ptr<video::Video> video;
 		std::unique_ptr<audio::Audio> audio;
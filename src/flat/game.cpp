@@ -104,6 +104,9 @@ void Game::loop()
 
 		time->endFrame();
 
+		frameArena->reset();
+		FLAT_TRACK_END_FRAME();
+
 		running = !input->window->isClosed() && !m_stop;
 	}
 }
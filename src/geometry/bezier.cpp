@@ -1,5 +1,10 @@
+#include <cmath>
+#include <algorithm>
+
 #include "bezier.h"
 
+#include "debug/assert.h"
+
 namespace flat
 {
 namespace geometry
@@ -9,47 +14,111 @@ namespace bezier
 
 namespace
 {
-static void computePointPosition(Vector2* result, size_t count, float coefficient)
+Vector2 computePointPosition(const Vector2* controlPoints, size_t numControlPoints, Vector2* buffer, float coefficient)
 {
-	if (count == 1)
+	// de Casteljau, buffer holds numControlPoints - 1 points
+	for (size_t i = 0; i < numControlPoints - 1; ++i)
 	{
-		return;
+		buffer[i] = controlPoints[i] * (1.f - coefficient) + controlPoints[i + 1] * coefficient;
 	}
-
-	for (int i = 0; i < count - 1; ++i)
+	for (size_t count = numControlPoints - 1; count > 1; --count)
 	{
-		result[i] = result[i] * (1.f - coefficient) + result[i + 1] * coefficient;
+		for (size_t i = 0; i < count - 1; ++i)
+		{
+			buffer[i] = buffer[i] * (1.f - coefficient) + buffer[i + 1] * coefficient;
+		}
 	}
-	computePointPosition(result, count - 1, coefficient);
+	return buffer[0];
 }
 
-Vector2 computePointPosition(const std::vector<Vector2>& controlPoints, float coefficient)
+void computeCubicBezier(const Vector2* controlPoints, int numSteps, Vector2* bezierCurve)
 {
-	FLAT_ASSERT(controlPoints.size() > 1);
+	// polynomial form a.t^3 + b.t^2 + c.t + d evaluated with forward differences
+	const Vector2& p0 = controlPoints[0];
+	const Vector2& p1 = controlPoints[1];
+	const Vector2& p2 = controlPoints[2];
+	const Vector2& p3 = controlPoints[3];
+	const Vector2 a = (p1 - p2) * 3.f + p3 - p0;
+	const Vector2 b = (p0 - p1 * 2.f + p2) * 3.f;
+	const Vector2 c = (p1 - p0) * 3.f;
 
-	Vector2* result = static_cast<Vector2*>(alloca(sizeof(Vector2) * (controlPoints.size() - 1)));
-	for (int i = 0; i < controlPoints.size() - 1; ++i)
+	const float h = 1.f / (numSteps - 1);
+	const float h2 = h * h;
+	const float h3 = h2 * h;
+	Vector2 point = p0;
+	Vector2 delta = a * h3 + b * h2 + c * h;
+	Vector2 delta2 = a * (6.f * h3) + b * (2.f * h2);
+	const Vector2 delta3 = a * (6.f * h3);
+	for (int i = 0; i < numSteps - 1; ++i)
 	{
-		result[i] = controlPoints[i] * (1.f - coefficient) + controlPoints[i + 1] * coefficient;
+		bezierCurve[i] = point;
+		point += delta;
+		delta += delta2;
+		delta2 += delta3;
 	}
-	computePointPosition(result, controlPoints.size() - 1, coefficient);
-	return result[0];
+	// no accumulated error on the last point
+	bezierCurve[numSteps - 1] = p3;
 }
 }
 
 void computeBezier(const std::vector<Vector2>& controlPoints, int numSteps, std::vector<Vector2>& bezierCurve)
 {
-	bezierCurve.reserve(numSteps);
+	const size_t previousSize = bezierCurve.size();
+	bezierCurve.resize(previousSize + numSteps);
+	computeBezier(controlPoints.data(), controlPoints.size(), numSteps, bezierCurve.data() + previousSize);
+}
+
+void computeBezier(const Vector2* controlPoints, size_t numControlPoints, int numSteps, Vector2* bezierCurve)
+{
+	FLAT_ASSERT(numControlPoints > 1);
+	FLAT_ASSERT(numSteps > 1);
+
+	if (numControlPoints == 4)
+	{
+		computeCubicBezier(controlPoints, numSteps, bezierCurve);
+		return;
+	}
 
-	std::vector<Vector2> points;
-	points.reserve(controlPoints.size());
+	FLAT_ASSERT(numControlPoints <= MAX_CONTROL_POINTS);
+	Vector2 buffer[MAX_CONTROL_POINTS - 1];
 	for (int i = 0; i < numSteps; ++i)
 	{
-		float coefficient = static_cast<float>(i) / (numSteps - 1);
-		points = controlPoints;
-		Vector2 point = computePointPosition(points, coefficient);
-		bezierCurve.push_back(point);
+		const float coefficient = static_cast<float>(i) / (numSteps - 1);
+		bezierCurve[i] = computePointPosition(controlPoints, numControlPoints, buffer, coefficient);
+	}
+}
+
+int getNumSteps(const Vector2* controlPoints, size_t numControlPoints, float tolerance)
+{
+	FLAT_ASSERT(numControlPoints > 1);
+	FLAT_ASSERT(tolerance > 0.f);
+
+	// the distance to the chord of each segment is bounded by d(d-1)/8 * max|P[i] - 2P[i+1] + P[i+2]| / n^2
+	float maxSecondDifference = 0.f;
+	for (size_t i = 0; i + 2 < numControlPoints; ++i)
+	{
+		const Vector2 secondDifference = controlPoints[i] - controlPoints[i + 1] * 2.f + controlPoints[i + 2];
+		maxSecondDifference = std::max(maxSecondDifference, length(secondDifference));
 	}
+
+	const float degree = static_cast<float>(numControlPoints - 1);
+	const float numSegments = std::ceil(std::sqrt(degree * (degree - 1.f) / 8.f * maxSecondDifference / tolerance));
+	// also guards against NaN and huge values
+	return numSegments < 1.f ? 2 : static_cast<int>(std::min(numSegments, 65536.f)) + 1;
+}
+
+void flattenBezier(const std::vector<Vector2>& controlPoints, float tolerance, std::vector<Vector2>& bezierCurve)
+{
+	const int numSteps = getNumSteps(controlPoints.data(), controlPoints.size(), tolerance);
+	computeBezier(controlPoints, numSteps, bezierCurve);
+}
+
+int flattenBezier(const Vector2* controlPoints, size_t numControlPoints, float tolerance, Vector2* bezierCurve, int maxSteps)
+{
+	FLAT_ASSERT(maxSteps > 1);
+	const int numSteps = std::min(getNumSteps(controlPoints, numControlPoints, tolerance), maxSteps);
+	computeBezier(controlPoints, numControlPoints, numSteps, bezierCurve);
+	return numSteps;
 }
 
 } // bezier
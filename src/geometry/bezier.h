@@ -12,10 +12,29 @@ namespace geometry
 namespace bezier
 {
 
+// the curves evaluated with de Casteljau keep their intermediate points on the stack
+constexpr size_t MAX_CONTROL_POINTS = 16;
+
+// numSteps points evenly spaced on the curve, appended to bezierCurve
 void computeBezier(const std::vector<Vector2>& controlPoints, int numSteps, std::vector<Vector2>& bezierCurve);
 
+// same without allocation, bezierCurve must have room for numSteps points, cubic curves use forward differencing,
+// at most MAX_CONTROL_POINTS control points
+void computeBezier(const Vector2* controlPoints, size_t numControlPoints, int numSteps, Vector2* bezierCurve);
+
+// number of steps so that the polyline never gets further than tolerance from the curve (Wang's formula),
+// straight or short curves get few steps, long and curvy ones get more
+int getNumSteps(const Vector2* controlPoints, size_t numControlPoints, float tolerance);
+
+// adaptive flattening, appended to bezierCurve
+void flattenBezier(const std::vector<Vector2>& controlPoints, float tolerance, std::vector<Vector2>& bezierCurve);
+
+// same without allocation, returns the number of points written: getNumSteps() points clamped to maxSteps,
+// a clamped curve can get further than tolerance from the polyline, call getNumSteps() first to size bezierCurve exactly
+int flattenBezier(const Vector2* controlPoints, size_t numControlPoints, float tolerance, Vector2* bezierCurve, int maxSteps);
+
 } // bezier
 } // geometry
 } // flat
 
-#endif // FLAT_GEOMETRY_BEZIER_H
\ No newline at end of file
+#endif // FLAT_GEOMETRY_BEZIER_H
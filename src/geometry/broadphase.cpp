@@ -0,0 +1,293 @@
+#include <limits>
+#include <algorithm>
+
+#include "geometry/broadphase.h"
+
+#include "containers/dynamicbitset.h"
+#include "debug/assert.h"
+
+namespace flat
+{
+namespace geometry
+{
+
+namespace
+{
+// taller bands have fewer proxies spanning two of them but more candidates per proxy, the cost is flat around 8
+constexpr float BAND_HEIGHT_RATIO = 8.f;
+// the band of a proxy that was never sorted
+constexpr int NO_BAND = std::numeric_limits<int>::min();
+}
+
+Broadphase::Broadphase() :
+	m_bandHeight(0.f),
+	m_inverseBandHeight(0.f),
+	m_hasRemovedProxies(false)
+{
+
+}
+
+int Broadphase::addProxy(const AABB2& aabb, std::uint32_t layer, std::uint32_t mask)
+{
+	FLAT_ASSERT(aabb.isValid());
+	int proxyId;
+	if (m_freeProxyIds.empty())
+	{
+		proxyId = static_cast<int>(m_proxies.size());
+		m_proxies.emplace_back();
+	}
+	else
+	{
+		proxyId = m_freeProxyIds.back();
+		m_freeProxyIds.pop_back();
+	}
+
+	Proxy& proxy = m_proxies[proxyId];
+	proxy.m_aabb = aabb;
+	proxy.m_layer = layer;
+	proxy.m_mask = mask;
+	proxy.m_alive = true;
+
+	// appended at the end, sorted on the next findPairs
+	m_sortedProxies.push_back({ aabb, layer, mask, NO_BAND, proxyId });
+	return proxyId;
+}
+
+void Broadphase::updateProxy(int proxyId, const AABB2& aabb)
+{
+	FLAT_ASSERT(isValidProxy(proxyId));
+	FLAT_ASSERT(aabb.isValid());
+	m_proxies[proxyId].m_aabb = aabb;
+}
+
+void Broadphase::setProxyLayer(int proxyId, std::uint32_t layer, std::uint32_t mask)
+{
+	FLAT_ASSERT(isValidProxy(proxyId));
+	Proxy& proxy = m_proxies[proxyId];
+	proxy.m_layer = layer;
+	proxy.m_mask = mask;
+}
+
+void Broadphase::removeProxy(int proxyId)
+{
+	FLAT_ASSERT(isValidProxy(proxyId));
+	m_proxies[proxyId].m_alive = false;
+	m_freeProxyIds.push_back(proxyId);
+	m_hasRemovedProxies = true;
+}
+
+void Broadphase::clear()
+{
+	m_proxies.clear();
+	m_freeProxyIds.clear();
+	m_sortedProxies.clear();
+	m_movedProxies.clear();
+	m_bands.clear();
+	m_sortedAABBs.clear();
+	m_pairs.clear();
+	m_bandHeight = 0.f;
+	m_inverseBandHeight = 0.f;
+	m_hasRemovedProxies = false;
+}
+
+const std::vector<Broadphase::Pair>& Broadphase::findPairs()
+{
+	updateSortedProxies();
+	sortProxies();
+	updateBands();
+
+	m_pairs.clear();
+	for (size_t bandIndex = 0; bandIndex < m_bands.size(); ++bandIndex)
+	{
+		findPairsInBand(bandIndex);
+	}
+	return m_pairs;
+}
+
+void Broadphase::updateSortedProxies()
+{
+	if (m_hasRemovedProxies)
+	{
+		// a removed id might have been reused by addProxy, in that case only the latest entry is kept
+		containers::DynamicBitset keptProxies(m_proxies.size());
+		for (int i = static_cast<int>(m_sortedProxies.size()) - 1; i >= 0; --i)
+		{
+			SortedProxy& sortedProxy = m_sortedProxies[i];
+			if (!m_proxies[sortedProxy.m_proxyId].m_alive || keptProxies.testAndSet(sortedProxy.m_proxyId))
+			{
+				sortedProxy.m_proxyId = -1;
+			}
+		}
+		m_sortedProxies.erase(
+			std::remove_if(m_sortedProxies.begin(), m_sortedProxies.end(), [](const SortedProxy& sortedProxy) { return sortedProxy.m_proxyId < 0; }),
+			m_sortedProxies.end()
+		);
+		m_hasRemovedProxies = false;
+	}
+
+	float totalHeight = 0.f;
+	for (SortedProxy& sortedProxy : m_sortedProxies)
+	{
+		const Proxy& proxy = m_proxies[sortedProxy.m_proxyId];
+		sortedProxy.m_aabb = proxy.m_aabb;
+		sortedProxy.m_layer = proxy.m_layer;
+		sortedProxy.m_mask = proxy.m_mask;
+		totalHeight += sortedProxy.m_aabb.max.y - sortedProxy.m_aabb.min.y;
+	}
+
+	// hysteresis, a new band height moves every proxy
+	bool bandHeightChanged = false;
+	if (!m_sortedProxies.empty())
+	{
+		const float bandHeight = totalHeight / static_cast<float>(m_sortedProxies.size()) * BAND_HEIGHT_RATIO;
+		if (bandHeight > m_bandHeight * 2.f || bandHeight < m_bandHeight / 2.f)
+		{
+			m_bandHeight = bandHeight;
+			m_inverseBandHeight = bandHeight > 0.f ? 1.f / bandHeight : 0.f;
+			bandHeightChanged = true;
+		}
+	}
+
+	// the proxies staying in their band are kept in place, the others are sorted apart and merged back
+	m_movedProxies.clear();
+	size_t numKeptProxies = 0;
+	for (const SortedProxy& sortedProxy : m_sortedProxies)
+	{
+		const int band = getBand(sortedProxy.m_aabb.min.y);
+		if (band == sortedProxy.m_band && !bandHeightChanged)
+		{
+			m_sortedProxies[numKeptProxies++] = sortedProxy;
+		}
+		else
+		{
+			m_movedProxies.push_back(sortedProxy);
+			m_movedProxies.back().m_band = band;
+		}
+	}
+	m_sortedProxies.resize(numKeptProxies);
+}
+
+void Broadphase::sortProxies()
+{
+	auto compareBandMinX = [](const SortedProxy& a, const SortedProxy& b)
+	{
+		return a.m_band < b.m_band || (a.m_band == b.m_band && a.m_aabb.min.x < b.m_aabb.min.x);
+	};
+
+	for (size_t i = 1; i < m_sortedProxies.size(); ++i)
+	{
+		if (!compareBandMinX(m_sortedProxies[i], m_sortedProxies[i - 1]))
+		{
+			continue;
+		}
+
+		const SortedProxy sortedProxy = m_sortedProxies[i];
+		size_t j = i;
+		do
+		{
+			m_sortedProxies[j] = m_sortedProxies[j - 1];
+			--j;
+		}
+		while (j > 0 && compareBandMinX(sortedProxy, m_sortedProxies[j - 1]));
+		m_sortedProxies[j] = sortedProxy;
+	}
+
+	if (!m_movedProxies.empty())
+	{
+		std::sort(m_movedProxies.begin(), m_movedProxies.end(), compareBandMinX);
+		m_mergeBuffer.resize(m_sortedProxies.size() + m_movedProxies.size());
+		std::merge(m_sortedProxies.begin(), m_sortedProxies.end(), m_movedProxies.begin(), m_movedProxies.end(), m_mergeBuffer.begin(), compareBandMinX);
+		m_sortedProxies.swap(m_mergeBuffer);
+	}
+}
+
+void Broadphase::updateBands()
+{
+	// the AABBs are copied in sorted order so that the sweep reads contiguous memory and tests several AABBs at once
+	const size_t numSortedProxies = m_sortedProxies.size();
+	m_sortedAABBs.resize(numSortedProxies);
+	m_bands.clear();
+	for (size_t i = 0; i < numSortedProxies; ++i)
+	{
+		const SortedProxy& sortedProxy = m_sortedProxies[i];
+		m_sortedAABBs.set(i, sortedProxy.m_aabb);
+
+		if (m_bands.empty() || m_bands.back().m_band != sortedProxy.m_band)
+		{
+			m_bands.push_back({ sortedProxy.m_band, i, i, 0.f });
+		}
+		Band& band = m_bands.back();
+		++band.m_end;
+		band.m_maxWidth = std::max(band.m_maxWidth, sortedProxy.m_aabb.max.x - sortedProxy.m_aabb.min.x);
+	}
+}
+
+void Broadphase::findPairsInBand(size_t bandIndex)
+{
+	auto addPair = [this](const SortedProxy& sortedProxy, size_t otherIndex)
+	{
+		const SortedProxy& otherSortedProxy = m_sortedProxies[otherIndex];
+		if ((sortedProxy.m_layer & otherSortedProxy.m_mask) != 0 && (otherSortedProxy.m_layer & sortedProxy.m_mask) != 0)
+		{
+			const int proxyId = sortedProxy.m_proxyId;
+			const int otherProxyId = otherSortedProxy.m_proxyId;
+			m_pairs.emplace_back(std::min(proxyId, otherProxyId), std::max(proxyId, otherProxyId));
+		}
+	};
+
+	const Band& band = m_bands[bandIndex];
+	// the proxies of the band come by increasing min.x, so does the first candidate of the next band
+	size_t nextBandCursor = bandIndex + 1 < m_bands.size() ? m_bands[bandIndex + 1].m_begin : 0;
+	for (size_t i = band.m_begin; i < band.m_end; ++i)
+	{
+		// the candidates are the next proxies of the band starting before the end of this one
+		const SortedProxy& sortedProxy = m_sortedProxies[i];
+		const AABB2& aabb = sortedProxy.m_aabb;
+		m_sortedAABBs.eachOverlapSortedByMinX(aabb, i + 1, band.m_end, [&addPair, &sortedProxy](size_t j)
+		{
+			addPair(sortedProxy, j);
+		});
+
+		// a proxy starting in a next band is only tested from here, it can start before this one along x
+		const int lastBand = getBand(aabb.max.y);
+		for (size_t nextBandIndex = bandIndex + 1; nextBandIndex < m_bands.size() && m_bands[nextBandIndex].m_band <= lastBand; ++nextBandIndex)
+		{
+			const Band& nextBand = m_bands[nextBandIndex];
+			const float minX = aabb.min.x - nextBand.m_maxWidth;
+			size_t begin;
+			if (nextBandIndex == bandIndex + 1)
+			{
+				while (nextBandCursor < nextBand.m_end && m_sortedProxies[nextBandCursor].m_aabb.min.x < minX)
+				{
+					++nextBandCursor;
+				}
+				begin = nextBandCursor;
+			}
+			else
+			{
+				// only for proxies taller than a band
+				begin = static_cast<size_t>(std::lower_bound(m_sortedProxies.begin() + nextBand.m_begin, m_sortedProxies.begin() + nextBand.m_end, minX,
+					[](const SortedProxy& sortedProxy, float x) { return sortedProxy.m_aabb.min.x < x; }) - m_sortedProxies.begin());
+			}
+			m_sortedAABBs.eachOverlapSortedByMinX(aabb, begin, nextBand.m_end, [&addPair, &sortedProxy](size_t j)
+			{
+				addPair(sortedProxy, j);
+			});
+		}
+	}
+}
+
+int Broadphase::getBand(float y) const
+{
+	// far away coordinates share the first or last band
+	constexpr float maxBand = static_cast<float>(1 << 30);
+	const float band = std::max(std::min(y * m_inverseBandHeight, maxBand), -maxBand);
+	// std::floor is a call without SSE4.1
+	const int truncatedBand = static_cast<int>(band);
+	return band < static_cast<float>(truncatedBand) ? truncatedBand - 1 : truncatedBand;
+}
+
+} // geometry
+} // flat
+
+
@@ -0,0 +1,102 @@
+#ifndef FLAT_GEOMETRY_BROADPHASE_H
+#define FLAT_GEOMETRY_BROADPHASE_H
+
+#include <vector>
+#include <utility>
+#include <cstdint>
+
+#include "misc/aabb2.h"
+#include "misc/aabb2array.h"
+
+namespace flat
+{
+namespace geometry
+{
+
+// sweep and prune along the x axis in horizontal bands a few proxies tall, otherwise every proxy in the
+// same column of the world would be a candidate
+// proxies stay sorted by band then min.x from one findPairs to the next so that the insertion sort only
+// has a few swaps to do when objects move a little between frames
+class Broadphase
+{
+	public:
+		using Pair = std::pair<int, int>;
+		static constexpr std::uint32_t ALL_LAYERS = 0xFFFFFFFF;
+
+	public:
+		Broadphase();
+		~Broadphase() = default;
+
+		// two proxies can overlap if the layer of each one is in the mask of the other
+		int addProxy(const AABB2& aabb, std::uint32_t layer = 1, std::uint32_t mask = ALL_LAYERS);
+		void updateProxy(int proxyId, const AABB2& aabb);
+		void setProxyLayer(int proxyId, std::uint32_t layer, std::uint32_t mask);
+		void removeProxy(int proxyId);
+		void clear();
+
+		// false for an id out of range or already removed
+		inline bool isValidProxy(int proxyId) const { return 0 <= proxyId && proxyId < static_cast<int>(m_proxies.size()) && m_proxies[proxyId].m_alive; }
+
+		inline const AABB2& getProxyAABB(int proxyId) const { return m_proxies[proxyId].m_aabb; }
+		inline int getNumProxies() const { return static_cast<int>(m_proxies.size() - m_freeProxyIds.size()); }
+
+		// overlapping pairs (a < b), each pair is reported once, the buffer is reused by the next call
+		const std::vector<Pair>& findPairs();
+
+	private:
+		struct Proxy
+		{
+			AABB2 m_aabb;
+			std::uint32_t m_layer;
+			std::uint32_t m_mask;
+			bool m_alive;
+		};
+
+		// copied from the proxy so that the passes after the sort read contiguous memory
+		struct SortedProxy
+		{
+			AABB2 m_aabb;
+			std::uint32_t m_layer;
+			std::uint32_t m_mask;
+			int m_band;
+			int m_proxyId;
+		};
+
+		struct Band
+		{
+			int m_band;
+			size_t m_begin;
+			size_t m_end;
+			float m_maxWidth;
+		};
+
+		// moves the new proxies and the ones that changed band to m_movedProxies
+		void updateSortedProxies();
+		void sortProxies();
+		void updateBands();
+		// pairs between the proxies of a band and the ones starting in the next bands they span
+		void findPairsInBand(size_t bandIndex);
+
+		int getBand(float y) const;
+
+	private:
+		std::vector<Proxy> m_proxies;
+		std::vector<int> m_freeProxyIds;
+		std::vector<SortedProxy> m_sortedProxies;
+		std::vector<SortedProxy> m_movedProxies;
+		std::vector<SortedProxy> m_mergeBuffer;
+		std::vector<Band> m_bands;
+		AABB2Array m_sortedAABBs;
+		std::vector<Pair> m_pairs;
+		// only changes when the average height of the proxies does, changing it sorts everything again
+		float m_bandHeight;
+		float m_inverseBandHeight;
+		bool m_hasRemovedProxies;
+};
+
+} // geometry
+} // flat
+
+#endif // FLAT_GEOMETRY_BROADPHASE_H
+
+
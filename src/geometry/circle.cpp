@@ -47,6 +47,7 @@ void Circle::buildCircle()
 		float alpha = static_cast<float>(i) / numVertices * flat::PI * 2.f;
 		m_vertices.emplace_back(m_center.x + std::cos(alpha) * m_radius, m_center.y + std::sin(alpha) * m_radius);
 	}
+	updateAABB();
 }
 
 } // geometry
@@ -2,137 +2,233 @@
 #define FLAT_GEOMETRY_GRID_H
 
 #include <vector>
-
-#include "geometry/quadtree.h"
+#include <utility>
+#include <algorithm>
+#include <numeric>
+#include <execution>
+#include <cmath>
+#include <cstdint>
 
 #include "misc/aabb2.h"
+#include "misc/aabb2array.h"
+#include "debug/assert.h"
 
 namespace flat
 {
 namespace geometry
 {
 
-template <class T>
-using GridCell = QuadTreeCell<T>;
-
+// uniform spatial hash: objects are stored in the cell around their center, queries are inflated by the
+// largest object half size so that objects overlapping several cells are still found
+// a bounded grid splits its AABB in width x height cells and clamps objects outside of it to the border cells,
+// an unbounded grid hashes the cell coordinates into width x height buckets
 template <class T, int width, int height>
 class Grid
 {
 	private:
-		using Cell = GridCell<T>;
+		struct Cell
+		{
+			std::vector<int> m_objectIndices;
+			AABB2Array m_objectAABBs;
+		};
+
+		struct Object
+		{
+			const T* m_object;
+			int m_cellX;
+			int m_cellY;
+			int m_cellIndex;
+			int m_slotIndex; // index in the cell lists
+		};
+
+		struct CellRange
+		{
+			int m_minX;
+			int m_minY;
+			int m_maxX;
+			int m_maxY;
+
+			inline std::int64_t getNumCells() const
+			{
+				return static_cast<std::int64_t>(m_maxX - m_minX + 1) * (m_maxY - m_minY + 1);
+			}
+
+			inline bool isInside(int x, int y) const
+			{
+				return m_minX <= x && x <= m_maxX && m_minY <= y && y <= m_maxY;
+			}
+		};
 
 	public:
-		Grid(const AABB2& aabb);
+		explicit Grid(const AABB2& aabb);
+		explicit Grid(const Vector2& cellSize);
 		~Grid() = default;
 
+		// returns the object index to pass to updateObject and removeObject
 		int addObject(const T* object);
-		int updateObject(const T* object, int previousCellIndex);
-		void removeObject(const T* object);
-		void removeObject(const T* object, int cellIndex);
+		void updateObject(int objectIndex);
+		void removeObject(int objectIndex);
 		void updateAllObjects();
-		void updateAllObjects(std::unordered_map<const T*, int>& objectCellIndices);
 		void clear();
 		void getObjects(const AABB2& aabb, std::vector<const T*>& objects) const;
 		void getObjects(const Vector2& point, std::vector<const T*>& objects) const;
 
+		// batch query: each cell is visited once for all the AABBs, results are (query index, object) pairs
+		void getObjects(const AABB2* aabbs, size_t numAABBs, std::vector<std::pair<int, const T*>>& objects) const;
+
+		inline bool isUnbounded() const { return m_unbounded; }
+		inline const Vector2& getCellSize() const { return m_cellSize; }
+		inline int getNumObjects() const { return static_cast<int>(m_objects.size() - m_freeObjectIndices.size()); }
+
 	private:
-		int  getCellIndex(const Cell& cell) const;
-		Cell& getCell(int cellX, int cellY);
-		const Cell& getCell(int cellX, int cellY) const;
-		Cell& findCellAroundPoint(const Vector2& point);
-		const Cell& findCellAroundPoint(const Vector2& point) const;
-		void getCellPosition(const Cell& cell, int& cellX, int& cellY) const;
-		void updateCellObjects(Cell& cell);
+		void getCellPosition(const Vector2& point, int& cellX, int& cellY) const;
+		void getCellRange(const AABB2& aabb, CellRange& range) const;
+		int getCellIndex(int cellX, int cellY) const;
+
+		void addToCell(int objectIndex, const AABB2& aabb, int cellX, int cellY);
+		void removeFromCell(int objectIndex);
+
+		// calls func(cell, isVisited) for each cell around the range, isVisited(object) filters out the objects
+		// of hashed cells that do not belong to the range or that would be reported twice
+		template <typename Func>
+		void eachCellInRange(const CellRange& range, Func func) const;
 
 		static constexpr int getNumCells();
 
 	private:
 		static constexpr int NUM_CELLS = getNumCells();
-		std::array<Cell, NUM_CELLS> m_cells;
-		AABB2 m_aabb;
+		std::vector<Cell> m_cells;
+		std::vector<Object> m_objects;
+		std::vector<int> m_freeObjectIndices;
+		std::vector<AABB2> m_updatedAABBs;
+		Vector2 m_origin;
 		Vector2 m_cellSize;
+		Vector2 m_maxObjectHalfSize;
+		bool m_unbounded;
 };
 
 template<class T, int width, int height>
 inline Grid<T, width, height>::Grid(const AABB2& aabb) :
-	m_aabb(aabb)
+	m_cells(NUM_CELLS),
+	m_origin(aabb.min),
+	m_cellSize(aabb.getSize().x / width, aabb.getSize().y / height),
+	m_maxObjectHalfSize(0.f, 0.f),
+	m_unbounded(false)
 {
-	AABB2 cellAABB;
-	const float cellWidth = aabb.getSize().x;
-	const float cellHeight = aabb.getSize().x;
-	for (int x = 0; x < width; ++x)
-	{
-		for (int y = 0; y < height; ++y)
-		{
-			Cell& cell = getCell(x, y);
-			cellAABB.min.x = cellWidth * x;
-			cellAABB.max.x = cellAABB.min.x + cellWidth;
-			cellAABB.min.y = cellHeight * y;
-			cellAABB.max.y = cellAABB.min.y + cellHeight;
-			cell.setAABB(cellAABB);
-		}
-	}
-	m_cellSize.x = cellWidth;
-	m_cellSize.y = cellHeight;
+	FLAT_ASSERT(m_cellSize.x > 0.f && m_cellSize.y > 0.f);
 }
 
 template<class T, int width, int height>
-inline int Grid<T, width, height>::addObject(const T* object)
+inline Grid<T, width, height>::Grid(const Vector2& cellSize) :
+	m_cells(NUM_CELLS),
+	m_origin(0.f, 0.f),
+	m_cellSize(cellSize),
+	m_maxObjectHalfSize(0.f, 0.f),
+	m_unbounded(true)
 {
-	const AABB2& aabb = object->getAABB();
-	Cell& cell = findCellAroundPoint(aabb.getCenter());
-	cell.addObject(object);
-	return getCellIndex(cell);
+	FLAT_ASSERT(m_cellSize.x > 0.f && m_cellSize.y > 0.f);
 }
 
 template<class T, int width, int height>
-inline int Grid<T, width, height>::updateObject(const T* object, int previousCellIndex)
+inline int Grid<T, width, height>::addObject(const T* object)
 {
-	Cell& previousCell = m_cells[previousCellIndex];
-	const AABB2& aabb = object->getAABB();
-	Cell& newCell = findCellAroundPoint(aabb.getCenter());
-	if (&newCell != &previousCell)
+	FLAT_ASSERT(object != nullptr);
+	int objectIndex;
+	if (m_freeObjectIndices.empty())
+	{
+		objectIndex = static_cast<int>(m_objects.size());
+		m_objects.emplace_back();
+	}
+	else
 	{
-		previousCell.removeObject(object);
-		newCell.addObject(object);
+		objectIndex = m_freeObjectIndices.back();
+		m_freeObjectIndices.pop_back();
 	}
-	return getCellIndex(newCell);
+	m_objects[objectIndex].m_object = object;
+
+	const AABB2& aabb = object->getAABB();
+	m_maxObjectHalfSize = glm::max(m_maxObjectHalfSize, aabb.getSize() / 2.f);
+	int cellX, cellY;
+	getCellPosition(aabb.getCenter(), cellX, cellY);
+	addToCell(objectIndex, aabb, cellX, cellY);
+	return objectIndex;
 }
 
 template<class T, int width, int height>
-inline void Grid<T, width, height>::removeObject(const T* object)
+inline void Grid<T, width, height>::updateObject(int objectIndex)
 {
-	const AABB2& aabb = object->getAABB();
-	Cell& cell = findCellAroundPoint(aabb.getCenter());
-	cell.removeObject(object);
+	Object& object = m_objects[objectIndex];
+	FLAT_ASSERT(object.m_object != nullptr);
+	const AABB2& aabb = object.m_object->getAABB();
+	m_maxObjectHalfSize = glm::max(m_maxObjectHalfSize, aabb.getSize() / 2.f);
+	int cellX, cellY;
+	getCellPosition(aabb.getCenter(), cellX, cellY);
+	if (cellX == object.m_cellX && cellY == object.m_cellY)
+	{
+		m_cells[object.m_cellIndex].m_objectAABBs.set(object.m_slotIndex, aabb);
+	}
+	else
+	{
+		removeFromCell(objectIndex);
+		addToCell(objectIndex, aabb, cellX, cellY);
+	}
 }
 
 template<class T, int width, int height>
-inline void Grid<T, width, height>::removeObject(const T* object, int cellIndex)
+inline void Grid<T, width, height>::removeObject(int objectIndex)
 {
-	m_cells[cellIndex].removeObject(object);
+	FLAT_ASSERT(m_objects[objectIndex].m_object != nullptr);
+	removeFromCell(objectIndex);
+	m_objects[objectIndex].m_object = nullptr;
+	m_freeObjectIndices.push_back(objectIndex);
 }
 
 template<class T, int width, int height>
 inline void Grid<T, width, height>::updateAllObjects()
 {
-	for (int i = 0; i < NUM_CELLS; ++i)
+	// the AABBs are gathered and the objects that stay in their cell are updated in parallel,
+	// only the objects changing cell are moved sequentially
+	m_updatedAABBs.resize(m_objects.size());
+	std::for_each(std::execution::par, m_objects.begin(), m_objects.end(), [this](const Object& object)
 	{
-		Cell& cell = m_cells[i];
-		updateCellObjects(cell);
-	}
-}
+		const size_t objectIndex = &object - m_objects.data();
+		AABB2& aabb = m_updatedAABBs[objectIndex];
+		if (object.m_object == nullptr)
+		{
+			aabb = AABB2();
+			return;
+		}
 
-template<class T, int width, int height>
-inline void Grid<T, width, height>::updateAllObjects(std::unordered_map<const T*, int>& objectCellIndices)
-{
-	updateAllObjects();
-	for (int i = 0; i < NUM_CELLS; ++i)
+		aabb = object.m_object->getAABB();
+		int cellX, cellY;
+		getCellPosition(aabb.getCenter(), cellX, cellY);
+		if (cellX == object.m_cellX && cellY == object.m_cellY)
+		{
+			// distinct slots, no two objects write the same entry
+			m_cells[object.m_cellIndex].m_objectAABBs.set(object.m_slotIndex, aabb);
+		}
+	});
+
+	m_maxObjectHalfSize = std::transform_reduce(std::execution::par, m_updatedAABBs.begin(), m_updatedAABBs.end(), Vector2(0.f, 0.f),
+		[](const Vector2& a, const Vector2& b) { return glm::max(a, b); },
+		[](const AABB2& aabb) { return aabb.getSize() / 2.f; }
+	);
+
+	for (int objectIndex = 0; objectIndex < static_cast<int>(m_objects.size()); ++objectIndex)
 	{
-		Cell& cell = m_cells[i];
-		for (const T* object : cell.getObjects())
+		const Object& object = m_objects[objectIndex];
+		if (object.m_object == nullptr)
+		{
+			continue;
+		}
+
+		const AABB2& aabb = m_updatedAABBs[objectIndex];
+		int cellX, cellY;
+		getCellPosition(aabb.getCenter(), cellX, cellY);
+		if (cellX != object.m_cellX || cellY != object.m_cellY)
 		{
-			objectCellIndices[object] = i;
+			removeFromCell(objectIndex);
+			addToCell(objectIndex, aabb, cellX, cellY);
 		}
 	}
 }
@@ -140,207 +236,205 @@ inline void Grid<T, width, height>::updateAllObjects(std::unordered_map<const T*
 template<class T, int width, int height>
 inline void Grid<T, width, height>::clear()
 {
-	for (Cell<T>& cell : m_cells)
+	for (Cell& cell : m_cells)
 	{
-		cell.clear();
+		cell.m_objectIndices.clear();
+		cell.m_objectAABBs.clear();
 	}
+	m_objects.clear();
+	m_freeObjectIndices.clear();
+	m_maxObjectHalfSize = Vector2(0.f, 0.f);
 }
 
 template<class T, int width, int height>
 inline void Grid<T, width, height>::getObjects(const AABB2& aabb, std::vector<const T*>& objects) const
 {
-	const float cellHalfWidth = m_cellSize.x / 2.f;
-	const float cellHalfHeight = m_cellSize.y / 2.f;
-
-	Vector2 min = aabb.min;
-	if (min.x < m_aabb.min.x)
-	{
-		min.x = m_aabb.min.x;
-	}
-	else if (min.x > m_aabb.min.x + cellHalfWidth)
+	CellRange range;
+	getCellRange(aabb, range);
+	eachCellInRange(range, [this, &aabb, &objects](const Cell& cell, auto isVisited)
 	{
-		min.x -= cellHalfWidth;
-	}
-
-	if (min.y < m_aabb.min.y)
-	{
-		min.y = m_aabb.min.y;
-	}
-	else if (min.y > m_aabb.min.y + cellHalfHeight)
-	{
-		min.y -= cellHalfHeight;
-	}
-
-	Vector2 max = aabb.max;
-	if (max.x > m_aabb.max.x)
-	{
-		max.x = m_aabb.max.x;
-	}
-	else if (max.x < m_aabb.max.x - cellHalfWidth)
-	{
-		max.x += cellHalfWidth;
-	}
-
-	if (max.y > m_aabb.max.y)
-	{
-		max.y = m_aabb.max.y;
-	}
-	else if (max.y < m_aabb.max.y - cellHalfHeight)
-	{
-		max.y += cellHalfHeight;
-	}
-
-	const Cell& bottomLeftCell = findCellAroundPoint(min);
-	const Cell& topRightCell = findCellAroundPoint(max);
-
-	int minCellX, minCellY, maxCellX, maxCellY;
-	getCellPosition(bottomLeftCell, minCellX, minCellY);
-	getCellPosition(topRightCell, maxCellX, maxCellY);
-
-	for (int x = minCellX; x <= maxCellX; ++x)
-	{
-		for (int y = minCellY; y <= maxCellY; ++y)
+		cell.m_objectAABBs.eachOverlap(aabb, [this, &cell, &objects, &isVisited](size_t slotIndex)
 		{
-			const Cell& cell = getCell(x, y);
-			for (const T* object : cell.getObjects())
+			const Object& object = m_objects[cell.m_objectIndices[slotIndex]];
+			if (isVisited(object))
 			{
-				if (AABB2::overlap(aabb, object->getAABB()))
-				{
-					objects.push_back(object);
-				}
+				objects.push_back(object.m_object);
 			}
-		}
-	}
+		});
+	});
 }
 
 template<class T, int width, int height>
 inline void Grid<T, width, height>::getObjects(const Vector2& point, std::vector<const T*>& objects) const
 {
-	const float cellHalfWidth = m_cellSize.x / 2.f;
-	const float cellHalfHeight = m_cellSize.y / 2.f;
-
-	Vector2 min = point;
-	if (min.x < m_aabb.min.x)
+	CellRange range;
+	getCellRange(AABB2(point, point), range);
+	eachCellInRange(range, [this, &point, &objects](const Cell& cell, auto isVisited)
 	{
-		min.x = m_aabb.min.x;
-	}
-	else if (min.x > m_aabb.min.x + cellHalfWidth)
-	{
-		min.x -= cellHalfWidth;
-	}
+		cell.m_objectAABBs.eachInside(point, [this, &cell, &objects, &isVisited](size_t slotIndex)
+		{
+			const Object& object = m_objects[cell.m_objectIndices[slotIndex]];
+			if (isVisited(object))
+			{
+				objects.push_back(object.m_object);
+			}
+		});
+	});
+}
 
-	if (min.y < m_aabb.min.y)
-	{
-		min.y = m_aabb.min.y;
-	}
-	else if (min.y > m_aabb.min.y + cellHalfHeight)
+template<class T, int width, int height>
+inline void Grid<T, width, height>::getObjects(const AABB2* aabbs, size_t numAABBs, std::vector<std::pair<int, const T*>>& objects) const
+{
+	// bucket the queries by cell (counting sort) so that each cell is visited only once,
+	// a query is listed once per cell and keeps the objects whose cell position is in its range
+	std::vector<CellRange> queryRanges(numAABBs);
+	std::vector<int> cellQueryOffsets(NUM_CELLS + 1, 0);
+	std::vector<int> lastCellQueries(NUM_CELLS, -1);
+	auto eachQueryCell = [this, &queryRanges, &lastCellQueries](int queryIndex, auto func)
 	{
-		min.y -= cellHalfHeight;
-	}
+		eachCellInRange(queryRanges[queryIndex], [this, queryIndex, &lastCellQueries, &func](const Cell& cell, auto)
+		{
+			const int cellIndex = static_cast<int>(&cell - m_cells.data());
+			if (lastCellQueries[cellIndex] != queryIndex)
+			{
+				lastCellQueries[cellIndex] = queryIndex;
+				func(cellIndex);
+			}
+		});
+	};
 
-	Vector2 max = point;
-	if (max.x > m_aabb.max.x)
+	for (int i = 0; i < static_cast<int>(numAABBs); ++i)
 	{
-		max.x = m_aabb.max.x;
-	}
-	else if (max.x < m_aabb.max.x - cellHalfWidth)
-	{
-		max.x += cellHalfWidth;
+		getCellRange(aabbs[i], queryRanges[i]);
+		eachQueryCell(i, [&cellQueryOffsets](int cellIndex) { ++cellQueryOffsets[cellIndex + 1]; });
 	}
 
-	if (max.y > m_aabb.max.y)
+	for (int i = 0; i < NUM_CELLS; ++i)
 	{
-		max.y = m_aabb.max.y;
+		cellQueryOffsets[i + 1] += cellQueryOffsets[i];
 	}
-	else if (max.y < m_aabb.max.y - cellHalfHeight)
+
+	std::vector<int> cellQueries(cellQueryOffsets[NUM_CELLS]);
+	std::vector<int> cellQueryCounts(NUM_CELLS, 0);
+	std::fill(lastCellQueries.begin(), lastCellQueries.end(), -1);
+	for (int i = 0; i < static_cast<int>(numAABBs); ++i)
 	{
-		max.y += cellHalfHeight;
+		eachQueryCell(i, [i, &cellQueries, &cellQueryOffsets, &cellQueryCounts](int cellIndex)
+		{
+			cellQueries[cellQueryOffsets[cellIndex] + cellQueryCounts[cellIndex]++] = i;
+		});
 	}
 
-	const Cell& bottomLeftCell = findCellAroundPoint(min);
-	const Cell& topRightCell = findCellAroundPoint(max);
-
-	int minCellX, minCellY, maxCellX, maxCellY;
-	getCellPosition(bottomLeftCell, minCellX, minCellY);
-	getCellPosition(topRightCell, maxCellX, maxCellY);
-
-	for (int x = minCellX; x <= maxCellX; ++x)
+	for (int cellIndex = 0; cellIndex < NUM_CELLS; ++cellIndex)
 	{
-		for (int y = minCellY; y <= maxCellY; ++y)
+		const int firstQuery = cellQueryOffsets[cellIndex];
+		const int lastQuery = cellQueryOffsets[cellIndex + 1];
+		const Cell& cell = m_cells[cellIndex];
+		if (firstQuery == lastQuery || cell.m_objectIndices.empty())
+		{
+			continue;
+		}
+
+		for (int i = firstQuery; i < lastQuery; ++i)
 		{
-			const Cell& cell = getCell(x, y);
-			for (const T* object : cell.getObjects())
+			const int queryIndex = cellQueries[i];
+			const CellRange& range = queryRanges[queryIndex];
+			cell.m_objectAABBs.eachOverlap(aabbs[queryIndex], [this, queryIndex, &range, &cell, &objects](size_t slotIndex)
 			{
-				if (object->getAABB().isInside(point))
+				const Object& object = m_objects[cell.m_objectIndices[slotIndex]];
+				if (range.isInside(object.m_cellX, object.m_cellY))
 				{
-					objects.push_back(object);
+					objects.emplace_back(queryIndex, object.m_object);
 				}
-			}
+			});
 		}
 	}
 }
 
 template<class T, int width, int height>
-inline int Grid<T, width, height>::getCellIndex(const Cell& cell) const
+inline void Grid<T, width, height>::getCellPosition(const Vector2& point, int& cellX, int& cellY) const
 {
-	return static_cast<int>(&cell - &m_cells[0]);
-}
-
-template<class T, int width, int height>
-inline GridCell<T>& Grid<T, width, height>::getCell(int cellX, int cellY)
-{
-	return m_cells[cellX + width * cellY];
+	cellX = static_cast<int>(std::floor((point.x - m_origin.x) / m_cellSize.x));
+	cellY = static_cast<int>(std::floor((point.y - m_origin.y) / m_cellSize.y));
+	if (!m_unbounded)
+	{
+		cellX = std::clamp(cellX, 0, width - 1);
+		cellY = std::clamp(cellY, 0, height - 1);
+	}
 }
 
 template<class T, int width, int height>
-inline const GridCell<T>& Grid<T, width, height>::getCell(int cellX, int cellY) const
+inline void Grid<T, width, height>::getCellRange(const AABB2& aabb, CellRange& range) const
 {
-	return m_cells[cellX + width * cellY];
+	// objects are stored by their center, any object overlapping the AABB has its center in the inflated AABB
+	getCellPosition(aabb.min - m_maxObjectHalfSize, range.m_minX, range.m_minY);
+	getCellPosition(aabb.max + m_maxObjectHalfSize, range.m_maxX, range.m_maxY);
 }
 
 template<class T, int width, int height>
-inline GridCell<T>& Grid<T, width, height>::findCellAroundPoint(const Vector2& point)
+inline int Grid<T, width, height>::getCellIndex(int cellX, int cellY) const
 {
-	Vector2 gridSize = m_aabb.getSize();
-	int cellX = static_cast<int>((point.x - m_aabb.min.x) / gridSize.x);
-	int cellY = static_cast<int>((point.y - m_aabb.min.y) / gridSize.y);
-	return getCell(cellX, cellY);
+	if (!m_unbounded)
+	{
+		FLAT_ASSERT(0 <= cellX && cellX < width && 0 <= cellY && cellY < height);
+		return cellX + width * cellY;
+	}
+	const std::uint32_t hash = (static_cast<std::uint32_t>(cellX) * 73856093u) ^ (static_cast<std::uint32_t>(cellY) * 19349663u);
+	return static_cast<int>(hash % static_cast<std::uint32_t>(NUM_CELLS));
 }
 
 template<class T, int width, int height>
-inline const GridCell<T>& Grid<T, width, height>::findCellAroundPoint(const Vector2& point) const
+inline void Grid<T, width, height>::addToCell(int objectIndex, const AABB2& aabb, int cellX, int cellY)
 {
-	Vector2 gridSize = m_aabb.getSize();
-	int cellX = static_cast<int>((point.x - m_aabb.min.x) / gridSize.x);
-	int cellY = static_cast<int>((point.y - m_aabb.min.y) / gridSize.y);
-	return getCell(cellX, cellY);
+	Object& object = m_objects[objectIndex];
+	object.m_cellX = cellX;
+	object.m_cellY = cellY;
+	object.m_cellIndex = getCellIndex(cellX, cellY);
+	Cell& cell = m_cells[object.m_cellIndex];
+	object.m_slotIndex = static_cast<int>(cell.m_objectIndices.size());
+	cell.m_objectIndices.push_back(objectIndex);
+	cell.m_objectAABBs.add(aabb);
 }
 
 template<class T, int width, int height>
-inline void Grid<T, width, height>::getCellPosition(const Cell& cell, int& cellX, int& cellY) const
+inline void Grid<T, width, height>::removeFromCell(int objectIndex)
 {
-	int cellIndex = getCellIndex(cell);
-	cellX = cellIndex % width;
-	cellY = cellIndex / width;
+	// swap with the last object of the cell
+	const Object& object = m_objects[objectIndex];
+	Cell& cell = m_cells[object.m_cellIndex];
+	const int lastSlotIndex = static_cast<int>(cell.m_objectIndices.size()) - 1;
+	FLAT_ASSERT(cell.m_objectIndices[object.m_slotIndex] == objectIndex);
+	if (object.m_slotIndex != lastSlotIndex)
+	{
+		const int lastObjectIndex = cell.m_objectIndices[lastSlotIndex];
+		cell.m_objectIndices[object.m_slotIndex] = lastObjectIndex;
+		cell.m_objectAABBs.set(object.m_slotIndex, cell.m_objectAABBs.get(lastSlotIndex));
+		m_objects[lastObjectIndex].m_slotIndex = object.m_slotIndex;
+	}
+	cell.m_objectIndices.pop_back();
+	cell.m_objectAABBs.resize(lastSlotIndex);
 }
 
 template<class T, int width, int height>
-inline void Grid<T, width, height>::updateCellObjects(Cell& cell)
+template <typename Func>
+inline void Grid<T, width, height>::eachCellInRange(const CellRange& range, Func func) const
 {
-	std::vector<const T*>& cellObjects = cell.getObjects();
-	for (std::vector<const T*>::iterator it = cellObjects.begin(); it != cellObjects.end();)
+	if (m_unbounded && range.getNumCells() > NUM_CELLS)
 	{
-		const T* object = *it;
-		const AABB2& aabb = object->getAABB();
-		Cell& newCell = findCellAroundPoint(aabb.getCenter());
-		if (&newCell != &cell)
+		// the range wraps around the buckets, visit each of them once
+		for (const Cell& cell : m_cells)
 		{
-			it = cellObjects.erase(it);
-			newCell.addObject(object);
+			func(cell, [&range](const Object& object) { return range.isInside(object.m_cellX, object.m_cellY); });
 		}
-		else
+		return;
+	}
+
+	for (int y = range.m_minY; y <= range.m_maxY; ++y)
+	{
+		for (int x = range.m_minX; x <= range.m_maxX; ++x)
 		{
-			++it;
+			const Cell& cell = m_cells[getCellIndex(x, y)];
+			func(cell, [x, y](const Object& object) { return object.m_cellX == x && object.m_cellY == y; });
 		}
 	}
 }
@@ -1,4 +1,13 @@
 #include <algorithm>
+#include <cmath>
+
+#if defined(_M_X64) || defined(__x86_64__)
+#define FLAT_INTERSECTION_X86
+#include <immintrin.h>
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+#endif
 
 #include "intersection.h"
 
@@ -8,6 +17,209 @@ namespace geometry
 {
 namespace intersection
 {
+namespace
+{
+
+namespace scalar
+{
+struct Lanes
+{
+	using Float = float;
+	using Mask = bool;
+	static constexpr size_t SIZE = 1;
+
+	static inline Float load(const float* values) { return *values; }
+	static inline void store(float* values, Float value) { *values = value; }
+	static inline void storeMask(bool* values, Mask mask) { *values = mask; }
+	static inline Float set(float value) { return value; }
+	static inline Float add(Float a, Float b) { return a + b; }
+	static inline Float sub(Float a, Float b) { return a - b; }
+	static inline Float mul(Float a, Float b) { return a * b; }
+	static inline Float div(Float a, Float b) { return a / b; }
+	static inline Float min(Float a, Float b) { return b < a ? b : a; }
+	static inline Float max(Float a, Float b) { return a < b ? b : a; }
+	static inline Float sqrt(Float a) { return std::sqrt(a); }
+	static inline Mask less(Float a, Float b) { return a < b; }
+	static inline Mask lessEqual(Float a, Float b) { return a <= b; }
+	static inline Mask greaterEqual(Float a, Float b) { return a >= b; }
+	static inline Mask equal(Float a, Float b) { return a == b; }
+	static inline Mask notEqual(Float a, Float b) { return a != b; }
+	static inline Mask andMask(Mask a, Mask b) { return a && b; }
+	static inline Float select(Mask mask, Float a, Float b) { return mask ? a : b; }
+};
+
+#include "geometry/intersectionkernels.h"
+} // scalar
+
+#ifdef FLAT_INTERSECTION_X86
+
+namespace sse2
+{
+struct Lanes
+{
+	using Float = __m128;
+	using Mask = __m128;
+	static constexpr size_t SIZE = 4;
+
+	static inline Float load(const float* values) { return _mm_loadu_ps(values); }
+	static inline void store(float* values, Float value) { _mm_storeu_ps(values, value); }
+	static inline void storeMask(bool* values, Mask mask)
+	{
+		const int bits = _mm_movemask_ps(mask);
+		for (size_t i = 0; i < SIZE; ++i)
+		{
+			values[i] = ((bits >> i) & 1) != 0;
+		}
+	}
+	static inline Float set(float value) { return _mm_set1_ps(value); }
+	static inline Float add(Float a, Float b) { return _mm_add_ps(a, b); }
+	static inline Float sub(Float a, Float b) { return _mm_sub_ps(a, b); }
+	static inline Float mul(Float a, Float b) { return _mm_mul_ps(a, b); }
+	static inline Float div(Float a, Float b) { return _mm_div_ps(a, b); }
+	static inline Float min(Float a, Float b) { return _mm_min_ps(a, b); }
+	static inline Float max(Float a, Float b) { return _mm_max_ps(a, b); }
+	static inline Float sqrt(Float a) { return _mm_sqrt_ps(a); }
+	static inline Mask less(Float a, Float b) { return _mm_cmplt_ps(a, b); }
+	static inline Mask lessEqual(Float a, Float b) { return _mm_cmple_ps(a, b); }
+	static inline Mask greaterEqual(Float a, Float b) { return _mm_cmpge_ps(a, b); }
+	static inline Mask equal(Float a, Float b) { return _mm_cmpeq_ps(a, b); }
+	static inline Mask notEqual(Float a, Float b) { return _mm_cmpneq_ps(a, b); }
+	static inline Mask andMask(Mask a, Mask b) { return _mm_and_ps(a, b); }
+	static inline Float select(Mask mask, Float a, Float b) { return _mm_or_ps(_mm_and_ps(mask, a), _mm_andnot_ps(mask, b)); }
+};
+
+#include "geometry/intersectionkernels.h"
+} // sse2
+
+// only the functions defined in this block are compiled for AVX2, they are called when the CPU supports it
+#if defined(__clang__)
+#pragma clang attribute push (__attribute__((target("avx2"))), apply_to = function)
+#elif defined(__GNUC__)
+#pragma GCC push_options
+#pragma GCC target("avx2")
+#endif
+
+namespace avx2
+{
+struct Lanes
+{
+	using Float = __m256;
+	using Mask = __m256;
+	static constexpr size_t SIZE = 8;
+
+	static inline Float load(const float* values) { return _mm256_loadu_ps(values); }
+	static inline void store(float* values, Float value) { _mm256_storeu_ps(values, value); }
+	static inline void storeMask(bool* values, Mask mask)
+	{
+		const int bits = _mm256_movemask_ps(mask);
+		for (size_t i = 0; i < SIZE; ++i)
+		{
+			values[i] = ((bits >> i) & 1) != 0;
+		}
+	}
+	static inline Float set(float value) { return _mm256_set1_ps(value); }
+	static inline Float add(Float a, Float b) { return _mm256_add_ps(a, b); }
+	static inline Float sub(Float a, Float b) { return _mm256_sub_ps(a, b); }
+	static inline Float mul(Float a, Float b) { return _mm256_mul_ps(a, b); }
+	static inline Float div(Float a, Float b) { return _mm256_div_ps(a, b); }
+	static inline Float min(Float a, Float b) { return _mm256_min_ps(a, b); }
+	static inline Float max(Float a, Float b) { return _mm256_max_ps(a, b); }
+	static inline Float sqrt(Float a) { return _mm256_sqrt_ps(a); }
+	static inline Mask less(Float a, Float b) { return _mm256_cmp_ps(a, b, _CMP_LT_OQ); }
+	static inline Mask lessEqual(Float a, Float b) { return _mm256_cmp_ps(a, b, _CMP_LE_OQ); }
+	static inline Mask greaterEqual(Float a, Float b) { return _mm256_cmp_ps(a, b, _CMP_GE_OQ); }
+	static inline Mask equal(Float a, Float b) { return _mm256_cmp_ps(a, b, _CMP_EQ_OQ); }
+	static inline Mask notEqual(Float a, Float b) { return _mm256_cmp_ps(a, b, _CMP_NEQ_UQ); }
+	static inline Mask andMask(Mask a, Mask b) { return _mm256_and_ps(a, b); }
+	static inline Float select(Mask mask, Float a, Float b) { return _mm256_blendv_ps(b, a, mask); }
+};
+
+#include "geometry/intersectionkernels.h"
+} // avx2
+
+#if defined(__clang__)
+#pragma clang attribute pop
+#elif defined(__GNUC__)
+#pragma GCC pop_options
+#endif
+
+#else
+
+namespace sse2 = scalar;
+namespace avx2 = scalar;
+
+#endif // FLAT_INTERSECTION_X86
+
+InstructionSet maxInstructionSet = InstructionSet::AVX2;
+
+InstructionSet detectInstructionSet()
+{
+#if defined(FLAT_INTERSECTION_X86)
+#if defined(_MSC_VER)
+	int info[4];
+	__cpuid(info, 0);
+	if (info[0] >= 7)
+	{
+		__cpuid(info, 1);
+		const bool hasAvx = (info[2] & (1 << 28)) != 0;
+		const bool hasOsxsave = (info[2] & (1 << 27)) != 0;
+		__cpuidex(info, 7, 0);
+		const bool hasAvx2 = (info[1] & (1 << 5)) != 0;
+		// the OS must save the AVX registers
+		if (hasAvx && hasOsxsave && hasAvx2 && (_xgetbv(0) & 0x6) == 0x6)
+		{
+			return InstructionSet::AVX2;
+		}
+	}
+	return InstructionSet::SSE2;
+#else
+	__builtin_cpu_init();
+	return __builtin_cpu_supports("avx2") ? InstructionSet::AVX2 : InstructionSet::SSE2;
+#endif
+#else
+	return InstructionSet::SCALAR;
+#endif
+}
+
+InstructionSet getSupportedInstructionSet()
+{
+	static const InstructionSet instructionSet = detectInstructionSet();
+	return instructionSet;
+}
+
+// runs the widest kernel available on as many elements as possible and the scalar kernel on the remaining ones
+template <class Avx2Kernel, class Sse2Kernel, class ScalarKernel>
+void runKernels(size_t count, Avx2Kernel avx2Kernel, Sse2Kernel sse2Kernel, ScalarKernel scalarKernel)
+{
+	size_t scalarBegin = 0;
+	switch (getInstructionSet())
+	{
+		case InstructionSet::AVX2:
+			scalarBegin = count - count % avx2::Lanes::SIZE;
+			avx2Kernel(0, scalarBegin);
+			break;
+		case InstructionSet::SSE2:
+			scalarBegin = count - count % sse2::Lanes::SIZE;
+			sse2Kernel(0, scalarBegin);
+			break;
+		case InstructionSet::SCALAR:
+			break;
+	}
+	scalarKernel(scalarBegin, count);
+}
+
+} // anonymous namespace
+
+InstructionSet getInstructionSet()
+{
+	const InstructionSet supportedInstructionSet = getSupportedInstructionSet();
+	return maxInstructionSet < supportedInstructionSet ? maxInstructionSet : supportedInstructionSet;
+}
+
+void setMaxInstructionSet(InstructionSet instructionSet)
+{
+	maxInstructionSet = instructionSet;
+}
 
 float rectangleToRectangleDistance(const flat::AABB2& a, const flat::AABB2& b, flat::Vector2* direction)
 {
@@ -193,6 +405,86 @@ bool twoLineSegments(const flat::Vector2& start1, const flat::Vector2& end1, con
 	return false;
 }
 
+bool rayToRectangle(const flat::Vector2& origin, const flat::Vector2& direction, float maxDistance, const flat::AABB2& rectangle, float* distance)
+{
+	float minDistance = 0.f;
+	for (int axis = 0; axis < 2; ++axis)
+	{
+		if (direction[axis] == 0.f)
+		{
+			if (origin[axis] < rectangle.min[axis] || origin[axis] > rectangle.max[axis])
+			{
+				return false;
+			}
+		}
+		else
+		{
+			const float inverseDirection = 1.f / direction[axis];
+			float slabEnter = (rectangle.min[axis] - origin[axis]) * inverseDirection;
+			float slabExit = (rectangle.max[axis] - origin[axis]) * inverseDirection;
+			if (slabEnter > slabExit)
+			{
+				std::swap(slabEnter, slabExit);
+			}
+			minDistance = std::max(minDistance, slabEnter);
+			maxDistance = std::min(maxDistance, slabExit);
+			if (minDistance > maxDistance)
+			{
+				return false;
+			}
+		}
+	}
+
+	if (distance != nullptr)
+	{
+		*distance = minDistance;
+	}
+	return true;
+}
+
+float pointToRectangleDistance(const flat::AABB2& rectangle, const flat::Vector2& point)
+{
+	bool isInside;
+	const flat::Vector2 closestPoint = closestPointOnRectangle(rectangle, point, &isInside);
+	return isInside ? 0.f : flat::distance(closestPoint, point);
+}
+
+void rectangleToRectangleDistance(const AABB2Span& a, const AABB2Span& b, size_t count, float* distances, const OutputVector2Span& directions)
+{
+	runKernels(count,
+		[&](size_t begin, size_t end) { avx2::rectangleToRectangleDistance(a, b, begin, end, distances, directions); },
+		[&](size_t begin, size_t end) { sse2::rectangleToRectangleDistance(a, b, begin, end, distances, directions); },
+		[&](size_t begin, size_t end) { scalar::rectangleToRectangleDistance(a, b, begin, end, distances, directions); }
+	);
+}
+
+void closestPointOnRectangle(const AABB2Span& rectangles, const Vector2Span& points, size_t count, const OutputVector2Span& closestPoints, bool* isInside)
+{
+	runKernels(count,
+		[&](size_t begin, size_t end) { avx2::closestPointOnRectangle(rectangles, points, begin, end, closestPoints, isInside); },
+		[&](size_t begin, size_t end) { sse2::closestPointOnRectangle(rectangles, points, begin, end, closestPoints, isInside); },
+		[&](size_t begin, size_t end) { scalar::closestPointOnRectangle(rectangles, points, begin, end, closestPoints, isInside); }
+	);
+}
+
+void circleToRectangleDistance(const AABB2Span& rectangles, const Vector2Span& circleCenters, const float* circleRadii, size_t count, float* distances, const OutputVector2Span& directions)
+{
+	runKernels(count,
+		[&](size_t begin, size_t end) { avx2::circleToRectangleDistance(rectangles, circleCenters, circleRadii, begin, end, distances, directions); },
+		[&](size_t begin, size_t end) { sse2::circleToRectangleDistance(rectangles, circleCenters, circleRadii, begin, end, distances, directions); },
+		[&](size_t begin, size_t end) { scalar::circleToRectangleDistance(rectangles, circleCenters, circleRadii, begin, end, distances, directions); }
+	);
+}
+
+void twoLineSegments(const Vector2Span& starts1, const Vector2Span& ends1, const Vector2Span& starts2, const Vector2Span& ends2, size_t count, bool* intersects, const OutputVector2Span& intersections)
+{
+	runKernels(count,
+		[&](size_t begin, size_t end) { avx2::twoLineSegments(starts1, ends1, starts2, ends2, begin, end, intersects, intersections); },
+		[&](size_t begin, size_t end) { sse2::twoLineSegments(starts1, ends1, starts2, ends2, begin, end, intersects, intersections); },
+		[&](size_t begin, size_t end) { scalar::twoLineSegments(starts1, ends1, starts2, ends2, begin, end, intersects, intersections); }
+	);
+}
+
 } // intersection
 } // geometry
 } // flat
@@ -1,6 +1,8 @@
 #ifndef FLAT_GEOMETRY_INTERSECTION_H
 #define FLAT_GEOMETRY_INTERSECTION_H
 
+#include <cstddef>
+
 #include "misc/vector.h"
 #include "misc/aabb2.h"
 
@@ -18,6 +20,47 @@ float circleToRectangleDistance(const flat::AABB2& rectangle, const flat::Vector
 
 bool twoLineSegments(const flat::Vector2& start1, const flat::Vector2& end1, const flat::Vector2& start2, const flat::Vector2& end2, flat::Vector2& intersection);
 
+// slab test, direction must be normalized, distance is 0 if origin is inside the rectangle
+bool rayToRectangle(const flat::Vector2& origin, const flat::Vector2& direction, float maxDistance, const flat::AABB2& rectangle, float* distance = nullptr);
+float pointToRectangleDistance(const flat::AABB2& rectangle, const flat::Vector2& point);
+
+// batch versions on structures of arrays: element i of every output is the result of the scalar version on element i
+// of every input, the best instruction set available at runtime is used (AVX2, SSE2 or scalar)
+struct Vector2Span
+{
+	const float* x;
+	const float* y;
+};
+
+struct OutputVector2Span
+{
+	float* x = nullptr;
+	float* y = nullptr;
+};
+
+struct AABB2Span
+{
+	Vector2Span min;
+	Vector2Span max;
+};
+
+enum class InstructionSet
+{
+	SCALAR,
+	SSE2,
+	AVX2
+};
+
+// the instruction set used by the batch versions: the best one the CPU supports, up to the maximum
+InstructionSet getInstructionSet();
+// lowers the instruction set of the batch versions to compare or time them, not thread safe
+void setMaxInstructionSet(InstructionSet maxInstructionSet);
+
+void rectangleToRectangleDistance(const AABB2Span& a, const AABB2Span& b, size_t count, float* distances, const OutputVector2Span& directions = OutputVector2Span());
+void closestPointOnRectangle(const AABB2Span& rectangles, const Vector2Span& points, size_t count, const OutputVector2Span& closestPoints, bool* isInside = nullptr);
+void circleToRectangleDistance(const AABB2Span& rectangles, const Vector2Span& circleCenters, const float* circleRadii, size_t count, float* distances, const OutputVector2Span& directions = OutputVector2Span());
+void twoLineSegments(const Vector2Span& starts1, const Vector2Span& ends1, const Vector2Span& starts2, const Vector2Span& ends2, size_t count, bool* intersects, const OutputVector2Span& intersections);
+
 } // intersection
 } // geometry
 } // flat
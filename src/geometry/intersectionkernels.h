@@ -0,0 +1,166 @@
+// no include guard: intersection.cpp includes this file once per instruction set, inside a namespace
+// that defines the Lanes type (SIZE floats processed at once)
+// kernels process [begin, end), end - begin must be a multiple of Lanes::SIZE
+
+using Float = Lanes::Float;
+using Mask = Lanes::Mask;
+
+inline void closestPointOnRectangle(
+	const Float& minX, const Float& minY, const Float& maxX, const Float& maxY, const Float& x, const Float& y,
+	Float& closestX, Float& closestY, Mask& isInside)
+{
+	// same comparisons as the scalar version
+	isInside = Lanes::andMask(
+		Lanes::andMask(Lanes::greaterEqual(x, minX), Lanes::lessEqual(x, maxX)),
+		Lanes::andMask(Lanes::greaterEqual(y, minY), Lanes::lessEqual(y, maxY))
+	);
+
+	// outside: clamp the point
+	closestX = Lanes::min(Lanes::max(x, minX), maxX);
+	closestY = Lanes::min(Lanes::max(y, minY), maxY);
+
+	// inside: move the point to the closest edge
+	const Float toMinX = Lanes::sub(x, minX);
+	const Float toMaxX = Lanes::sub(maxX, x);
+	const Float toMinY = Lanes::sub(y, minY);
+	const Float toMaxY = Lanes::sub(maxY, y);
+	const Mask alongX = Lanes::less(Lanes::min(toMinX, toMaxX), Lanes::min(toMinY, toMaxY));
+	const Float edgeX = Lanes::select(Lanes::less(toMinX, toMaxX), minX, maxX);
+	const Float edgeY = Lanes::select(Lanes::less(toMinY, toMaxY), minY, maxY);
+	closestX = Lanes::select(isInside, Lanes::select(alongX, edgeX, x), closestX);
+	closestY = Lanes::select(isInside, Lanes::select(alongX, y, edgeY), closestY);
+}
+
+inline void normalize(const Float& x, const Float& y, const Float& length, Float& normalizedX, Float& normalizedY)
+{
+	// same as flat::normalize, a null vector stays null
+	const Float zero = Lanes::set(0.f);
+	const Mask isNull = Lanes::equal(length, zero);
+	const Float inverseLength = Lanes::div(Lanes::set(1.f), length);
+	normalizedX = Lanes::select(isNull, zero, Lanes::mul(x, inverseLength));
+	normalizedY = Lanes::select(isNull, zero, Lanes::mul(y, inverseLength));
+}
+
+void rectangleToRectangleDistance(const AABB2Span& a, const AABB2Span& b, size_t begin, size_t end, float* distances, const OutputVector2Span& directions)
+{
+	const Float zero = Lanes::set(0.f);
+	for (size_t i = begin; i < end; i += Lanes::SIZE)
+	{
+		// b.min - a.max when a is before b, b.max - a.min when a is after b, 0 when they overlap
+		const Float differenceX = Lanes::add(
+			Lanes::max(Lanes::sub(Lanes::load(b.min.x + i), Lanes::load(a.max.x + i)), zero),
+			Lanes::min(Lanes::sub(Lanes::load(b.max.x + i), Lanes::load(a.min.x + i)), zero)
+		);
+		const Float differenceY = Lanes::add(
+			Lanes::max(Lanes::sub(Lanes::load(b.min.y + i), Lanes::load(a.max.y + i)), zero),
+			Lanes::min(Lanes::sub(Lanes::load(b.max.y + i), Lanes::load(a.min.y + i)), zero)
+		);
+		const Float length = Lanes::sqrt(Lanes::add(Lanes::mul(differenceX, differenceX), Lanes::mul(differenceY, differenceY)));
+		Lanes::store(distances + i, length);
+
+		if (directions.x != nullptr)
+		{
+			Float directionX;
+			Float directionY;
+			normalize(differenceX, differenceY, length, directionX, directionY);
+			Lanes::store(directions.x + i, directionX);
+			Lanes::store(directions.y + i, directionY);
+		}
+	}
+}
+
+void closestPointOnRectangle(const AABB2Span& rectangles, const Vector2Span& points, size_t begin, size_t end, const OutputVector2Span& closestPoints, bool* isInside)
+{
+	for (size_t i = begin; i < end; i += Lanes::SIZE)
+	{
+		Float closestX;
+		Float closestY;
+		Mask inside;
+		closestPointOnRectangle(
+			Lanes::load(rectangles.min.x + i), Lanes::load(rectangles.min.y + i),
+			Lanes::load(rectangles.max.x + i), Lanes::load(rectangles.max.y + i),
+			Lanes::load(points.x + i), Lanes::load(points.y + i),
+			closestX, closestY, inside
+		);
+		Lanes::store(closestPoints.x + i, closestX);
+		Lanes::store(closestPoints.y + i, closestY);
+
+		if (isInside != nullptr)
+		{
+			Lanes::storeMask(isInside + i, inside);
+		}
+	}
+}
+
+void circleToRectangleDistance(const AABB2Span& rectangles, const Vector2Span& circleCenters, const float* circleRadii, size_t begin, size_t end, float* distances, const OutputVector2Span& directions)
+{
+	const Float zero = Lanes::set(0.f);
+	for (size_t i = begin; i < end; i += Lanes::SIZE)
+	{
+		const Float centerX = Lanes::load(circleCenters.x + i);
+		const Float centerY = Lanes::load(circleCenters.y + i);
+		Float closestX;
+		Float closestY;
+		Mask inside;
+		closestPointOnRectangle(
+			Lanes::load(rectangles.min.x + i), Lanes::load(rectangles.min.y + i),
+			Lanes::load(rectangles.max.x + i), Lanes::load(rectangles.max.y + i),
+			centerX, centerY,
+			closestX, closestY, inside
+		);
+
+		const Float differenceX = Lanes::sub(centerX, closestX);
+		const Float differenceY = Lanes::sub(centerY, closestY);
+		const Float length = Lanes::sqrt(Lanes::add(Lanes::mul(differenceX, differenceX), Lanes::mul(differenceY, differenceY)));
+		const Float signedLength = Lanes::select(inside, Lanes::sub(zero, length), length);
+		Lanes::store(distances + i, Lanes::sub(signedLength, Lanes::load(circleRadii + i)));
+
+		if (directions.x != nullptr)
+		{
+			Float directionX;
+			Float directionY;
+			normalize(differenceX, differenceY, length, directionX, directionY);
+			Lanes::store(directions.x + i, Lanes::select(inside, Lanes::sub(zero, directionX), directionX));
+			Lanes::store(directions.y + i, Lanes::select(inside, Lanes::sub(zero, directionY), directionY));
+		}
+	}
+}
+
+void twoLineSegments(const Vector2Span& starts1, const Vector2Span& ends1, const Vector2Span& starts2, const Vector2Span& ends2, size_t begin, size_t end, bool* intersects, const OutputVector2Span& intersections)
+{
+	const Float zero = Lanes::set(0.f);
+	const Float one = Lanes::set(1.f);
+	for (size_t i = begin; i < end; i += Lanes::SIZE)
+	{
+		const Float start1X = Lanes::load(starts1.x + i);
+		const Float start1Y = Lanes::load(starts1.y + i);
+		const Float start2X = Lanes::load(starts2.x + i);
+		const Float start2Y = Lanes::load(starts2.y + i);
+		const Float segment1X = Lanes::sub(Lanes::load(ends1.x + i), start1X);
+		const Float segment1Y = Lanes::sub(Lanes::load(ends1.y + i), start1Y);
+		const Float segment2X = Lanes::sub(Lanes::load(ends2.x + i), start2X);
+		const Float segment2Y = Lanes::sub(Lanes::load(ends2.y + i), start2Y);
+		const Float startsX = Lanes::sub(start1X, start2X);
+		const Float startsY = Lanes::sub(start1Y, start2Y);
+
+		// same operations as the scalar version
+		const Float d = Lanes::sub(Lanes::mul(segment2Y, segment1X), Lanes::mul(segment2X, segment1Y));
+		const Float ua = Lanes::div(Lanes::sub(Lanes::mul(segment2X, startsY), Lanes::mul(segment2Y, startsX)), d);
+		const Float ub = Lanes::div(Lanes::sub(Lanes::mul(segment1X, startsY), Lanes::mul(segment1Y, startsX)), d);
+		const Mask intersect = Lanes::andMask(
+			Lanes::notEqual(d, zero),
+			Lanes::andMask(
+				Lanes::andMask(Lanes::greaterEqual(ua, zero), Lanes::lessEqual(ua, one)),
+				Lanes::andMask(Lanes::greaterEqual(ub, zero), Lanes::lessEqual(ub, one))
+			)
+		);
+		Lanes::storeMask(intersects + i, intersect);
+
+		// like the scalar version, the intersection is left untouched when there is none
+		const Float intersectionX = Lanes::add(start1X, Lanes::mul(ua, segment1X));
+		const Float intersectionY = Lanes::add(start1Y, Lanes::mul(ua, segment1Y));
+		Lanes::store(intersections.x + i, Lanes::select(intersect, intersectionX, Lanes::load(intersections.x + i)));
+		Lanes::store(intersections.y + i, Lanes::select(intersect, intersectionY, Lanes::load(intersections.y + i)));
+	}
+}
+
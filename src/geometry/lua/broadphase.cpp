@@ -0,0 +1,149 @@
+#include <limits>
+
+#include "geometry/lua/broadphase.h"
+#include "geometry/broadphase.h"
+
+#include "misc/lua/vector2.h"
+
+#include "flat.h"
+
+namespace flat
+{
+namespace geometry
+{
+namespace lua
+{
+
+using LuaBroadphase = flat::lua::SharedCppValue<Broadphase>;
+
+int openBroadphase(flat::lua::Lua& lua)
+{
+	lua_State* L = lua.state;
+	FLAT_LUA_EXPECT_STACK_GROWTH(L, 0);
+
+	static const luaL_Reg Broadphase_lib_m[] = {
+		{"addProxy",      l_Broadphase_addProxy},
+		{"updateProxy",   l_Broadphase_updateProxy},
+		{"setProxyLayer", l_Broadphase_setProxyLayer},
+		{"removeProxy",   l_Broadphase_removeProxy},
+		{"clear",         l_Broadphase_clear},
+		{"findPairs",     l_Broadphase_findPairs},
+
+		{nullptr, nullptr}
+	};
+	lua.registerClass<LuaBroadphase>("flat.Broadphase", Broadphase_lib_m);
+
+	// constructor: flat.Broadphase()
+	lua_getglobal(L, "flat");
+	lua_pushcfunction(L, l_Broadphase);
+	lua_setfield(L, -2, "Broadphase");
+
+	lua_pop(L, 1);
+
+	return 0;
+}
+
+int l_Broadphase(lua_State* L)
+{
+	LuaBroadphase::pushNew(L);
+	return 1;
+}
+
+int l_Broadphase_addProxy(lua_State* L)
+{
+	Broadphase& broadphase = getBroadphase(L, 1);
+	const Vector2& min = flat::lua::getVector2(L, 2);
+	const Vector2& max = flat::lua::getVector2(L, 3);
+	const std::uint32_t layer = static_cast<std::uint32_t>(luaL_optinteger(L, 4, 1));
+	const std::uint32_t mask = static_cast<std::uint32_t>(luaL_optinteger(L, 5, Broadphase::ALL_LAYERS));
+	lua_pushinteger(L, broadphase.addProxy(AABB2(min, max), layer, mask));
+	return 1;
+}
+
+int l_Broadphase_updateProxy(lua_State* L)
+{
+	Broadphase& broadphase = getBroadphase(L, 1);
+	const int proxyId = getProxyId(L, 2, broadphase);
+	const Vector2& min = flat::lua::getVector2(L, 3);
+	const Vector2& max = flat::lua::getVector2(L, 4);
+	broadphase.updateProxy(proxyId, AABB2(min, max));
+	return 0;
+}
+
+int l_Broadphase_setProxyLayer(lua_State* L)
+{
+	Broadphase& broadphase = getBroadphase(L, 1);
+	const int proxyId = getProxyId(L, 2, broadphase);
+	const std::uint32_t layer = static_cast<std::uint32_t>(luaL_checkinteger(L, 3));
+	const std::uint32_t mask = static_cast<std::uint32_t>(luaL_optinteger(L, 4, Broadphase::ALL_LAYERS));
+	broadphase.setProxyLayer(proxyId, layer, mask);
+	return 0;
+}
+
+int l_Broadphase_removeProxy(lua_State* L)
+{
+	Broadphase& broadphase = getBroadphase(L, 1);
+	const int proxyId = getProxyId(L, 2, broadphase);
+	broadphase.removeProxy(proxyId);
+	return 0;
+}
+
+int l_Broadphase_clear(lua_State* L)
+{
+	Broadphase& broadphase = getBroadphase(L, 1);
+	broadphase.clear();
+	return 0;
+}
+
+int l_Broadphase_findPairs(lua_State* L)
+{
+	// broadphase:findPairs([pairs]) -> pairs, numPairs
+	// pairs = { a1, b1, a2, b2, ... }, the optional table is reused to avoid a new allocation every frame
+	Broadphase& broadphase = getBroadphase(L, 1);
+	const std::vector<Broadphase::Pair>& pairs = broadphase.findPairs();
+	const lua_Integer numValues = static_cast<lua_Integer>(pairs.size()) * 2;
+	if (lua_isnoneornil(L, 2))
+	{
+		lua_createtable(L, static_cast<int>(numValues), 0);
+	}
+	else
+	{
+		luaL_checktype(L, 2, LUA_TTABLE);
+		lua_settop(L, 2);
+		const lua_Integer previousNumValues = static_cast<lua_Integer>(lua_rawlen(L, 2));
+		for (lua_Integer i = previousNumValues; i > numValues; --i)
+		{
+			lua_pushnil(L);
+			lua_rawseti(L, 2, i);
+		}
+	}
+
+	lua_Integer i = 1;
+	for (const Broadphase::Pair& pair : pairs)
+	{
+		lua_pushinteger(L, pair.first);
+		lua_rawseti(L, -2, i++);
+		lua_pushinteger(L, pair.second);
+		lua_rawseti(L, -2, i++);
+	}
+	lua_pushinteger(L, static_cast<lua_Integer>(pairs.size()));
+	return 2;
+}
+
+Broadphase& getBroadphase(lua_State* L, int index)
+{
+	return LuaBroadphase::get(L, index);
+}
+
+int getProxyId(lua_State* L, int index, const Broadphase& broadphase)
+{
+	const lua_Integer proxyId = luaL_checkinteger(L, index);
+	luaL_argcheck(L, proxyId >= 0 && proxyId <= std::numeric_limits<int>::max() && broadphase.isValidProxy(static_cast<int>(proxyId)), index, "invalid or removed proxy id");
+	return static_cast<int>(proxyId);
+}
+
+} // lua
+} // geometry
+} // flat
+
+
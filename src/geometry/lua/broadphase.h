@@ -0,0 +1,38 @@
+#ifndef FLAT_GEOMETRY_LUA_BROADPHASE_H
+#define FLAT_GEOMETRY_LUA_BROADPHASE_H
+
+struct lua_State;
+
+namespace flat
+{
+namespace lua
+{
+class Lua;
+}
+namespace geometry
+{
+class Broadphase;
+namespace lua
+{
+
+int openBroadphase(flat::lua::Lua& lua);
+
+int l_Broadphase(lua_State* L);
+int l_Broadphase_addProxy(lua_State* L);
+int l_Broadphase_updateProxy(lua_State* L);
+int l_Broadphase_setProxyLayer(lua_State* L);
+int l_Broadphase_removeProxy(lua_State* L);
+int l_Broadphase_clear(lua_State* L);
+int l_Broadphase_findPairs(lua_State* L);
+
+// private
+Broadphase& getBroadphase(lua_State* L, int index);
+int getProxyId(lua_State* L, int index, const Broadphase& broadphase);
+
+} // lua
+} // geometry
+} // flat
+
+#endif // FLAT_GEOMETRY_LUA_BROADPHASE_H
+
+
@@ -0,0 +1,168 @@
+#include "geometry/lua/polygon.h"
+#include "geometry/polygon.h"
+
+#include "misc/lua/vector2.h"
+#include "lua/table.h"
+
+#include "flat.h"
+
+namespace flat
+{
+namespace geometry
+{
+namespace lua
+{
+
+using LuaPolygon = flat::lua::SharedCppValue<Polygon>;
+
+int openPolygon(flat::lua::Lua& lua)
+{
+	lua_State* L = lua.state;
+	FLAT_LUA_EXPECT_STACK_GROWTH(L, 0);
+
+	static const luaL_Reg Polygon_lib_m[] = {
+		{"getVertices",    l_Polygon_getVertices},
+		{"setVertices",    l_Polygon_setVertices},
+		{"getAABB",        l_Polygon_getAABB},
+		{"isConvex",       l_Polygon_isConvex},
+		{"isInside",       l_Polygon_isInside},
+		{"overlapPolygon", l_Polygon_overlapPolygon},
+		{"overlapCircle",  l_Polygon_overlapCircle},
+		{"overlapAABB",    l_Polygon_overlapAABB},
+		{"decompose",      l_Polygon_decompose},
+
+		{nullptr, nullptr}
+	};
+	lua.registerClass<LuaPolygon>("flat.Polygon", Polygon_lib_m);
+
+	// constructor: flat.Polygon({flat.Vector2(x, y), ...})
+	lua_getglobal(L, "flat");
+	lua_pushcfunction(L, l_Polygon);
+	lua_setfield(L, -2, "Polygon");
+
+	lua_pop(L, 1);
+
+	return 0;
+}
+
+int l_Polygon(lua_State* L)
+{
+	std::vector<Vector2> vertices = flat::lua::table::getArray<Vector2>(L, 1);
+	LuaPolygon::pushNew(L, vertices);
+	return 1;
+}
+
+int l_Polygon_getVertices(lua_State* L)
+{
+	Polygon& polygon = getPolygon(L, 1);
+	return flat::lua::table::pushVector(L, polygon.getVertices());
+}
+
+int l_Polygon_setVertices(lua_State* L)
+{
+	Polygon& polygon = getPolygon(L, 1);
+	polygon.setVertices(flat::lua::table::getArray<Vector2>(L, 2));
+	return 0;
+}
+
+int l_Polygon_getAABB(lua_State* L)
+{
+	Polygon& polygon = getPolygon(L, 1);
+	const AABB2& aabb = polygon.getAABB();
+	flat::lua::pushVector2(L, aabb.min);
+	flat::lua::pushVector2(L, aabb.max);
+	return 2;
+}
+
+int l_Polygon_isConvex(lua_State* L)
+{
+	Polygon& polygon = getPolygon(L, 1);
+	lua_pushboolean(L, polygon.isConvex());
+	return 1;
+}
+
+int l_Polygon_isInside(lua_State* L)
+{
+	Polygon& polygon = getPolygon(L, 1);
+	const Vector2& point = flat::lua::getVector2(L, 2);
+	lua_pushboolean(L, polygon.isInside(point));
+	return 1;
+}
+
+int l_Polygon_overlapPolygon(lua_State* L)
+{
+	Polygon& polygon = getPolygon(L, 1);
+	Polygon& other = getPolygon(L, 2);
+	luaL_argcheck(L, polygon.isConvex(), 1, "polygon must be convex");
+	luaL_argcheck(L, other.isConvex(), 2, "polygon must be convex");
+	Vector2 minimumTranslation;
+	const bool overlap = polygon.overlap(other, &minimumTranslation);
+	return pushOverlap(L, overlap, minimumTranslation);
+}
+
+int l_Polygon_overlapCircle(lua_State* L)
+{
+	Polygon& polygon = getPolygon(L, 1);
+	const Vector2& circleCenter = flat::lua::getVector2(L, 2);
+	const float circleRadius = static_cast<float>(luaL_checknumber(L, 3));
+	luaL_argcheck(L, polygon.isConvex(), 1, "polygon must be convex");
+	Vector2 minimumTranslation;
+	const bool overlap = polygon.overlap(circleCenter, circleRadius, &minimumTranslation);
+	return pushOverlap(L, overlap, minimumTranslation);
+}
+
+int l_Polygon_overlapAABB(lua_State* L)
+{
+	Polygon& polygon = getPolygon(L, 1);
+	const Vector2& min = flat::lua::getVector2(L, 2);
+	const Vector2& max = flat::lua::getVector2(L, 3);
+	luaL_argcheck(L, polygon.isConvex(), 1, "polygon must be convex");
+	Vector2 minimumTranslation;
+	const bool overlap = polygon.overlap(AABB2(min, max), &minimumTranslation);
+	return pushOverlap(L, overlap, minimumTranslation);
+}
+
+int l_Polygon_decompose(lua_State* L)
+{
+	Polygon& polygon = getPolygon(L, 1);
+	std::vector<Polygon> convexPolygons;
+	polygon.decompose(convexPolygons);
+	lua_createtable(L, static_cast<int>(convexPolygons.size()), 0);
+	for (size_t i = 0; i < convexPolygons.size(); ++i)
+	{
+		pushPolygon(L, convexPolygons[i]);
+		lua_rawseti(L, -2, static_cast<lua_Integer>(i + 1));
+	}
+	return 1;
+}
+
+Polygon& getPolygon(lua_State* L, int index)
+{
+	return LuaPolygon::get(L, index);
+}
+
+void pushPolygon(lua_State* L, const Polygon& polygon)
+{
+	LuaPolygon::pushNew(L, polygon);
+}
+
+int pushOverlap(lua_State* L, bool overlap, const Vector2& minimumTranslation)
+{
+	// overlap, minimumTranslation or nil
+	lua_pushboolean(L, overlap);
+	if (overlap)
+	{
+		flat::lua::pushVector2(L, minimumTranslation);
+	}
+	else
+	{
+		lua_pushnil(L);
+	}
+	return 2;
+}
+
+} // lua
+} // geometry
+} // flat
+
+
@@ -0,0 +1,44 @@
+#ifndef FLAT_GEOMETRY_LUA_POLYGON_H
+#define FLAT_GEOMETRY_LUA_POLYGON_H
+
+#include "misc/vector.h"
+
+struct lua_State;
+
+namespace flat
+{
+namespace lua
+{
+class Lua;
+}
+namespace geometry
+{
+class Polygon;
+namespace lua
+{
+
+int openPolygon(flat::lua::Lua& lua);
+
+int l_Polygon(lua_State* L);
+int l_Polygon_getVertices(lua_State* L);
+int l_Polygon_setVertices(lua_State* L);
+int l_Polygon_getAABB(lua_State* L);
+int l_Polygon_isConvex(lua_State* L);
+int l_Polygon_isInside(lua_State* L);
+int l_Polygon_overlapPolygon(lua_State* L);
+int l_Polygon_overlapCircle(lua_State* L);
+int l_Polygon_overlapAABB(lua_State* L);
+int l_Polygon_decompose(lua_State* L);
+
+// private
+Polygon& getPolygon(lua_State* L, int index);
+void pushPolygon(lua_State* L, const Polygon& polygon);
+int pushOverlap(lua_State* L, bool overlap, const Vector2& minimumTranslation);
+
+} // lua
+} // geometry
+} // flat
+
+#endif // FLAT_GEOMETRY_LUA_POLYGON_H
+
+
@@ -1,4 +1,6 @@
 #include <cstring>
+#include <limits>
+#include <algorithm>
 #include <GL/glew.h>
 
 #include "geometry/polygon.h"
@@ -7,6 +9,207 @@ namespace flat
 {
 namespace geometry
 {
+namespace
+{
+
+inline float perpDot(const Vector2& a, const Vector2& b)
+{
+	return a.x * b.y - a.y * b.x;
+}
+
+void project(const Vector2* vertices, size_t numVertices, const Vector2& axis, float& min, float& max)
+{
+	min = std::numeric_limits<float>::max();
+	max = -std::numeric_limits<float>::max();
+	for (size_t i = 0; i < numVertices; ++i)
+	{
+		const float projection = dot(vertices[i], axis);
+		min = std::min(min, projection);
+		max = std::max(max, projection);
+	}
+}
+
+// keeps the axis with the smallest overlap, oriented so that moving the first shape along it separates the shapes
+bool testAxis(const Vector2& axis, float minA, float maxA, float minB, float maxB, float& minOverlap, Vector2& minOverlapAxis)
+{
+	// strict, like AABB2::overlap
+	const float overlap = std::min(maxA, maxB) - std::max(minA, minB);
+	if (overlap <= 0.f)
+	{
+		return false;
+	}
+
+	if (overlap < minOverlap)
+	{
+		minOverlap = overlap;
+		minOverlapAxis = minA + maxA < minB + maxB ? -axis : axis;
+	}
+	return true;
+}
+
+bool testEdgeNormals(const Vector2* vertices, size_t numVertices, const Vector2* otherVertices, size_t numOtherVertices, bool reversed, float& minOverlap, Vector2& minOverlapAxis)
+{
+	for (size_t i = 0; i < numVertices; ++i)
+	{
+		const Vector2 edge = vertices[(i + 1) % numVertices] - vertices[i];
+		if (length2(edge) == 0.f)
+		{
+			continue;
+		}
+
+		const Vector2 axis = flat::normalize(Vector2(edge.y, -edge.x));
+		float min, max, otherMin, otherMax;
+		project(vertices, numVertices, axis, min, max);
+		project(otherVertices, numOtherVertices, axis, otherMin, otherMax);
+		const bool overlap = reversed
+			? testAxis(axis, otherMin, otherMax, min, max, minOverlap, minOverlapAxis)
+			: testAxis(axis, min, max, otherMin, otherMax, minOverlap, minOverlapAxis);
+		if (!overlap)
+		{
+			return false;
+		}
+	}
+	return true;
+}
+
+bool convexPolygonsOverlap(const Vector2* a, size_t numA, const Vector2* b, size_t numB, Vector2* minimumTranslation)
+{
+	if (numA == 0 || numB == 0)
+	{
+		return false;
+	}
+
+	float minOverlap = std::numeric_limits<float>::max();
+	Vector2 minOverlapAxis(0.f, 0.f);
+	if (!testEdgeNormals(a, numA, b, numB, false, minOverlap, minOverlapAxis)
+		|| !testEdgeNormals(b, numB, a, numA, true, minOverlap, minOverlapAxis))
+	{
+		return false;
+	}
+
+	if (minimumTranslation != nullptr)
+	{
+		*minimumTranslation = minOverlapAxis * minOverlap;
+	}
+	return true;
+}
+
+float getSignedArea(const std::vector<Vector2>& vertices, const std::vector<int>& indices)
+{
+	float area = 0.f;
+	for (size_t i = 0; i < indices.size(); ++i)
+	{
+		area += perpDot(vertices[indices[i]], vertices[indices[(i + 1) % indices.size()]]);
+	}
+	return area / 2.f;
+}
+
+// counter clockwise polygon, collinear vertices are accepted
+bool isConvexCounterClockwise(const std::vector<Vector2>& vertices, const std::vector<int>& indices)
+{
+	const size_t numIndices = indices.size();
+	for (size_t i = 0; i < numIndices; ++i)
+	{
+		const Vector2& previous = vertices[indices[(i + numIndices - 1) % numIndices]];
+		const Vector2& current = vertices[indices[i]];
+		const Vector2& next = vertices[indices[(i + 1) % numIndices]];
+		if (perpDot(current - previous, next - current) < 0.f)
+		{
+			return false;
+		}
+	}
+	return true;
+}
+
+bool isInsideTriangle(const Vector2& point, const Vector2& a, const Vector2& b, const Vector2& c)
+{
+	// counter clockwise triangle, points on the edges are inside
+	return perpDot(b - a, point - a) >= 0.f
+		&& perpDot(c - b, point - b) >= 0.f
+		&& perpDot(a - c, point - c) >= 0.f;
+}
+
+void triangulate(const std::vector<Vector2>& vertices, std::vector<int> indices, std::vector<std::vector<int>>& triangles)
+{
+	// ear clipping, O(n^3) in the worst case
+	while (indices.size() > 3)
+	{
+		const size_t numIndices = indices.size();
+		bool earFound = false;
+		for (size_t i = 0; i < numIndices && !earFound; ++i)
+		{
+			const int previous = indices[(i + numIndices - 1) % numIndices];
+			const int current = indices[i];
+			const int next = indices[(i + 1) % numIndices];
+			const Vector2& a = vertices[previous];
+			const Vector2& b = vertices[current];
+			const Vector2& c = vertices[next];
+			if (perpDot(b - a, c - b) <= 0.f)
+			{
+				continue;
+			}
+
+			bool isEar = true;
+			for (int index : indices)
+			{
+				if (index != previous && index != current && index != next
+					&& vertices[index] != a && vertices[index] != b && vertices[index] != c
+					&& isInsideTriangle(vertices[index], a, b, c))
+				{
+					isEar = false;
+					break;
+				}
+			}
+
+			if (isEar)
+			{
+				triangles.push_back({ previous, current, next });
+				indices.erase(indices.begin() + i);
+				earFound = true;
+			}
+		}
+
+		if (!earFound)
+		{
+			// degenerate polygon (self intersecting or only collinear vertices left)
+			FLAT_ASSERT_MSG(false, "Could not triangulate polygon");
+			return;
+		}
+	}
+	triangles.push_back(indices);
+}
+
+// merges a and b if they share the edge (a[i], a[i + 1]) and the result is convex
+bool tryMerge(const std::vector<Vector2>& vertices, const std::vector<int>& a, const std::vector<int>& b, std::vector<int>& merged)
+{
+	for (size_t i = 0; i < a.size(); ++i)
+	{
+		const int edgeStart = a[i];
+		const int edgeEnd = a[(i + 1) % a.size()];
+		for (size_t j = 0; j < b.size(); ++j)
+		{
+			if (b[j] != edgeEnd || b[(j + 1) % b.size()] != edgeStart)
+			{
+				continue;
+			}
+
+			// a from edgeEnd around to edgeStart, then b without the shared edge
+			merged.clear();
+			for (size_t k = 0; k < a.size(); ++k)
+			{
+				merged.push_back(a[(i + 1 + k) % a.size()]);
+			}
+			for (size_t k = 2; k < b.size(); ++k)
+			{
+				merged.push_back(b[(j + k) % b.size()]);
+			}
+			return isConvexCounterClockwise(vertices, merged);
+		}
+	}
+	return false;
+}
+
+} // anonymous namespace
 
 Polygon::Polygon()
 {
@@ -16,17 +219,19 @@ Polygon::Polygon()
 Polygon::Polygon(const std::vector<Vector2>& vertices) :
 	m_vertices(vertices)
 {
-	
+	updateAABB();
 }
 
 Polygon::Polygon(const Polygon& polygon)
 {
 	m_vertices = polygon.m_vertices;
+	m_aabb = polygon.m_aabb;
 }
 
 void Polygon::operator=(const Polygon& polygon)
 {
 	m_vertices = polygon.m_vertices;
+	m_aabb = polygon.m_aabb;
 }
 
 Polygon::~Polygon()
@@ -49,6 +254,220 @@ void Polygon::transform(const Matrix4& matrix4)
 {
 	for (std::vector<Vector2>::iterator it = m_vertices.begin(); it != m_vertices.end(); it++)
 		*it = Vector2(matrix4 * Vector4(*it, 0.f, 1.f));
+	updateAABB();
+}
+
+bool Polygon::isConvex() const
+{
+	const size_t numVertices = m_vertices.size();
+	float sign = 0.f;
+	for (size_t i = 0; i < numVertices; ++i)
+	{
+		const Vector2& previous = m_vertices[(i + numVertices - 1) % numVertices];
+		const Vector2& current = m_vertices[i];
+		const Vector2& next = m_vertices[(i + 1) % numVertices];
+		const float turn = perpDot(current - previous, next - current);
+		if (turn * sign < 0.f)
+		{
+			return false;
+		}
+		else if (turn != 0.f)
+		{
+			sign = turn;
+		}
+	}
+	return true;
+}
+
+bool Polygon::isInside(const Vector2& point) const
+{
+	if (m_vertices.empty() || !m_aabb.isInside(point))
+	{
+		return false;
+	}
+
+	int windingNumber = 0;
+	const size_t numVertices = m_vertices.size();
+	for (size_t i = 0; i < numVertices; ++i)
+	{
+		const Vector2& a = m_vertices[i];
+		const Vector2& b = m_vertices[(i + 1) % numVertices];
+		if (a.y <= point.y)
+		{
+			// upward crossing with the point on the left
+			if (b.y > point.y && perpDot(b - a, point - a) > 0.f)
+			{
+				++windingNumber;
+			}
+		}
+		else
+		{
+			// downward crossing with the point on the right
+			if (b.y <= point.y && perpDot(b - a, point - a) < 0.f)
+			{
+				--windingNumber;
+			}
+		}
+	}
+	return windingNumber != 0;
+}
+
+bool Polygon::overlap(const Polygon& other, Vector2* minimumTranslation) const
+{
+	FLAT_ASSERT(isConvex() && other.isConvex());
+	if (!AABB2::overlap(m_aabb, other.m_aabb))
+	{
+		return false;
+	}
+	return convexPolygonsOverlap(m_vertices.data(), m_vertices.size(), other.m_vertices.data(), other.m_vertices.size(), minimumTranslation);
+}
+
+bool Polygon::overlap(const Vector2& circleCenter, float circleRadius, Vector2* minimumTranslation) const
+{
+	FLAT_ASSERT(isConvex());
+	const Vector2 circleExtent(circleRadius, circleRadius);
+	if (m_vertices.empty() || !AABB2::overlap(m_aabb, AABB2(circleCenter - circleExtent, circleCenter + circleExtent)))
+	{
+		return false;
+	}
+
+	const Vector2* vertices = m_vertices.data();
+	const size_t numVertices = m_vertices.size();
+	float minOverlap = std::numeric_limits<float>::max();
+	Vector2 minOverlapAxis(0.f, 0.f);
+	float min, max;
+
+	// the edge normals and the axis from the closest vertex to the center
+	for (size_t i = 0; i < numVertices; ++i)
+	{
+		const Vector2 edge = vertices[(i + 1) % numVertices] - vertices[i];
+		if (length2(edge) == 0.f)
+		{
+			continue;
+		}
+
+		const Vector2 axis = flat::normalize(Vector2(edge.y, -edge.x));
+		project(vertices, numVertices, axis, min, max);
+		const float center = dot(circleCenter, axis);
+		if (!testAxis(axis, min, max, center - circleRadius, center + circleRadius, minOverlap, minOverlapAxis))
+		{
+			return false;
+		}
+	}
+
+	const Vector2* closestVertex = &vertices[0];
+	for (size_t i = 1; i < numVertices; ++i)
+	{
+		if (distance2(vertices[i], circleCenter) < distance2(*closestVertex, circleCenter))
+		{
+			closestVertex = &vertices[i];
+		}
+	}
+
+	if (*closestVertex != circleCenter)
+	{
+		const Vector2 axis = flat::normalize(circleCenter - *closestVertex);
+		project(vertices, numVertices, axis, min, max);
+		const float center = dot(circleCenter, axis);
+		if (!testAxis(axis, min, max, center - circleRadius, center + circleRadius, minOverlap, minOverlapAxis))
+		{
+			return false;
+		}
+	}
+
+	if (minimumTranslation != nullptr)
+	{
+		*minimumTranslation = minOverlapAxis * minOverlap;
+	}
+	return true;
+}
+
+bool Polygon::overlap(const AABB2& aabb, Vector2* minimumTranslation) const
+{
+	FLAT_ASSERT(isConvex());
+	if (!AABB2::overlap(m_aabb, aabb))
+	{
+		return false;
+	}
+
+	const Vector2 aabbVertices[] = {
+		aabb.min,
+		Vector2(aabb.max.x, aabb.min.y),
+		aabb.max,
+		Vector2(aabb.min.x, aabb.max.y)
+	};
+	return convexPolygonsOverlap(m_vertices.data(), m_vertices.size(), aabbVertices, 4, minimumTranslation);
+}
+
+void Polygon::decompose(std::vector<Polygon>& convexPolygons) const
+{
+	if (isConvex())
+	{
+		convexPolygons.push_back(*this);
+		return;
+	}
+
+	std::vector<int> indices(m_vertices.size());
+	for (size_t i = 0; i < indices.size(); ++i)
+	{
+		indices[i] = static_cast<int>(i);
+	}
+
+	if (getSignedArea(m_vertices, indices) < 0.f)
+	{
+		std::reverse(indices.begin(), indices.end());
+	}
+
+	std::vector<std::vector<int>> pieces;
+	triangulate(m_vertices, indices, pieces);
+
+	// Hertel-Mehlhorn: remove the diagonals that are not needed to keep the pieces convex
+	std::vector<int> merged;
+	bool mergeFound = true;
+	while (mergeFound)
+	{
+		mergeFound = false;
+		for (size_t i = 0; i < pieces.size() && !mergeFound; ++i)
+		{
+			for (size_t j = i + 1; j < pieces.size() && !mergeFound; ++j)
+			{
+				if (tryMerge(m_vertices, pieces[i], pieces[j], merged))
+				{
+					pieces[i].swap(merged);
+					pieces.erase(pieces.begin() + j);
+					mergeFound = true;
+				}
+			}
+		}
+	}
+
+	std::vector<Vector2> pieceVertices;
+	for (const std::vector<int>& piece : pieces)
+	{
+		pieceVertices.clear();
+		for (int index : piece)
+		{
+			pieceVertices.push_back(m_vertices[index]);
+		}
+		convexPolygons.emplace_back(pieceVertices);
+	}
+}
+
+void Polygon::updateAABB()
+{
+	if (m_vertices.empty())
+	{
+		m_aabb = AABB2();
+		return;
+	}
+
+	m_aabb.min = m_vertices[0];
+	m_aabb.max = m_vertices[0];
+	for (const Vector2& vertex : m_vertices)
+	{
+		m_aabb.min = glm::min(m_aabb.min, vertex);
+		m_aabb.max = glm::max(m_aabb.max, vertex);
+	}
 }
 
 } // geometry
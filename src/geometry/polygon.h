@@ -5,6 +5,7 @@
 
 #include "misc/vector.h"
 #include "misc/matrix4.h"
+#include "misc/aabb2.h"
 #include "video/attribute.h"
 
 namespace flat
@@ -21,14 +22,37 @@ class Polygon
 		void operator=(const Polygon& polygon);
 		virtual ~Polygon();
 		
-		inline void setVertices(const std::vector<Vector2>& vertices) { m_vertices = vertices; }
+		inline void setVertices(const std::vector<Vector2>& vertices) { m_vertices = vertices; updateAABB(); }
+		inline const std::vector<Vector2>& getVertices() const { return m_vertices; }
+
+		// cached, so that polygons can be stored in a QuadTree
+		inline const AABB2& getAABB() const { return m_aabb; }
 		
 		void draw(video::Attribute vertexAttribute) const;
 		
 		void transform(const Matrix4& matrix4);
+
+		bool isConvex() const;
+
+		// winding number, works with concave polygons
+		bool isInside(const Vector2& point) const;
+
+		// separating axis theorem, both shapes must be convex
+		// the minimum translation vector is the smallest move of this polygon that separates it from the other shape
+		bool overlap(const Polygon& other, Vector2* minimumTranslation = nullptr) const;
+		bool overlap(const Vector2& circleCenter, float circleRadius, Vector2* minimumTranslation = nullptr) const;
+		bool overlap(const AABB2& aabb, Vector2* minimumTranslation = nullptr) const;
+
+		// splits a simple polygon in convex polygons (ear clipping then Hertel-Mehlhorn), meant to be done at load time
+		void decompose(std::vector<Polygon>& convexPolygons) const;
 		
+	protected:
+		// must be called by subclasses when they change m_vertices
+		void updateAABB();
+
 	protected:
 		std::vector<Vector2> m_vertices;
+		AABB2 m_aabb;
 };
 
 } // geometry
@@ -1,11 +1,23 @@
 #ifndef FLAT_GEOMETRY_QUADTREE_H
 #define FLAT_GEOMETRY_QUADTREE_H
 
+#include <array>
+#include <vector>
+#include <algorithm>
+#include <numeric>
+#include <execution>
+#include <queue>
+#include <functional>
+#include <cmath>
+
 #ifdef FLAT_DEBUG
 #include <set>
 #endif
 
+#include "containers/dynamicbitset.h"
 #include "misc/aabb2.h"
+#include "misc/aabb2array.h"
+#include "geometry/intersection.h"
 #include "debug/helpers.h"
 
 namespace flat
@@ -24,6 +36,7 @@ inline void getDefaultAABB(T object, AABB2& aabb)
 
 enum CellAvailability : std::uint32_t
 {
+	UNAVAILABLE = 0,
 	AVAILABLE = 0xFFFFFFFF
 };
 
@@ -36,7 +49,7 @@ enum CellIndex : std::uint32_t
 template <class T>
 class QuadTreeCell
 {
-	template <class T, int depth, void (*GetAABB)(T, AABB2&)>
+	template <class U, int depth, void (*GetAABB)(U, AABB2&)>
 	friend class QuadTree;
 
 	public:
@@ -48,6 +61,8 @@ class QuadTreeCell
 		inline const AABB2& getAABB() const { return m_aabb; }
 #endif
 
+		inline Vector2 getCenter() const { return m_aabb.getCenter(); }
+
 		inline bool isInside(const Vector2& point) const { return m_aabb.isInside(point); }
 		inline bool contains(const AABB2& aabb) const { return m_aabb.contains(aabb); }
 		inline bool overlap(const AABB2& aabb) const { return AABB2::overlap(m_aabb, aabb); }
@@ -74,9 +89,14 @@ class QuadTree
 		};
 
 	public:
-		QuadTree(const AABB2& aabb);
+		// looseness > 1 turns the tree into a loose quad tree: each cell's bounds but the root's are inflated by that factor
+		// and objects are stored in a cell chosen from their center and size, so that objects straddling a
+		// cell boundary do not pile up in the shallow cells
+		QuadTree(const AABB2& aabb, float looseness = 1.f);
 		~QuadTree() = default;
 
+		inline bool isLoose() const { return m_looseness > 1.f; }
+
 		int addObject(T object);
 		int addObject(T object, const AABB2& objectAABB);
 		int updateObject(T object, int previousCellIndex);
@@ -87,6 +107,11 @@ class QuadTree
 		void replaceObject(T originalObject, T newObject, int cellIndex);
 		void clear();
 
+		// bulk load: replaces the whole content of the tree without walking it once per object
+		// target cells are computed in parallel from Morton codes, then objects are counting sorted into their cells
+		// the cell index of each object is written to cellIndices if not null, to be used with updateObject()/removeObject()
+		void rebuild(const T* objects, const AABB2* objectAABBs, size_t numObjects, int* cellIndices = nullptr);
+
 		template <class Container>
 		void getObjects(const AABB2& aabb, Container& objects) const;
 
@@ -99,6 +124,35 @@ class QuadTree
 		template <typename Func>
 		void eachObject(const Vector2& point, Func func) const;
 
+		// batch queries: the tree is walked once for all the AABBs and results are reported as (query index, object) pairs
+		template <class Container>
+		void getObjects(const AABB2* aabbs, size_t numAABBs, Container& objects) const;
+
+		template <typename Func>
+		void eachObject(const AABB2* aabbs, size_t numAABBs, Func func) const;
+
+		// union of the batch queries: each object overlapping at least one of the AABBs is reported once
+		template <class Container>
+		void getUniqueObjects(const AABB2* aabbs, size_t numAABBs, Container& objects) const;
+
+		template <typename Func>
+		void eachUniqueObject(const AABB2* aabbs, size_t numAABBs, Func func) const;
+
+		// the k objects closest to the point (distance to their AABB), sorted from the closest
+		template <class Container>
+		void nearest(const Vector2& point, int k, float maxDistance, Container& objects) const;
+
+		// calls func(object, distance) for each object whose AABB is hit by the ray, from the closest,
+		// until func returns false, direction must be normalized
+		template <typename Func>
+		void raycast(const Vector2& origin, const Vector2& direction, float maxDistance, Func func) const;
+
+		// removing and relocating objects leaves holes in the cell data, the tree compacts itself once
+		// the ratio of holes exceeds the threshold, compact() can also be called at a convenient time (level load...)
+		void compact();
+		inline void setCompactionThreshold(float compactionThreshold) { m_compactionThreshold = compactionThreshold; }
+		inline float getFragmentation() const { return m_cellData.empty() ? 0.f : static_cast<float>(m_numAvailableCellData) / m_cellData.size(); }
+
 #ifdef FLAT_DEBUG
 		const Cell& getCell(int index) const { return m_cells[index]; }
 #endif
@@ -121,6 +175,9 @@ class QuadTree
 		const Cell& getParentCell(const Cell& cell) const;
 
 		Cell& findChildCellForAABB(Cell& cell, const AABB2& aabb);
+		Cell& findLooseChildCellForAABB(Cell& cell, const AABB2& aabb);
+		Cell& getChildAroundPoint(const Cell& cell, const Vector2& point);
+		int findCellIndexForAABB(const AABB2& aabb);
 
 		template <class Container>
 		void getObjectsInCell(const Cell& cell, const AABB2& aabb, Container& objects) const;
@@ -134,6 +191,20 @@ class QuadTree
 		template <typename Func>
 		void eachObjectInCell(const Cell& cell, const Vector2& point, Func func) const;
 
+		struct BatchQuery
+		{
+			const AABB2* aabbs;
+			// indices of the queries overlapping the cell being visited, one list per level
+			std::array<std::vector<int>, depth> levelQueries;
+		};
+
+		// calls func(query index, cell data index)
+		template <typename Func>
+		void eachCellDataIndex(const AABB2* aabbs, size_t numAABBs, Func func) const;
+
+		template <typename Func>
+		void eachObjectInCell(const Cell& cell, int level, BatchQuery& batchQuery, Func func) const;
+
 		Cell& updateObjectCell(Cell& cell, const AABB2& aabb);
 
 		void addObjectInCell(Cell& cell, T object, const AABB2& objectAABB);
@@ -141,39 +212,44 @@ class QuadTree
 		void removeObjectInCell(Cell& cell, T object);
 		void replaceObjectInCell(Cell& cell, T originalObject, T newObject);
 
+		void addCellData(T object, const AABB2& objectAABB);
+		void setCellData(std::int32_t cellDataIndex, T object, const AABB2& objectAABB);
+		std::int32_t findCellData(const Cell& cell, T object) const;
+		void compactIfFragmented();
+
 #ifdef FLAT_DEBUG
 		void checkFreeCellDataListIntegrity();
 #endif
 
 		static constexpr int cpow(int m, int n);
 		static constexpr int getNumCells();
+		static constexpr int getLevelFirstCellIndex(int level);
+		static std::uint32_t getMortonCode(std::uint32_t x, std::uint32_t y);
 
 	private:
 		static constexpr int NUM_CELLS = getNumCells();
+		static constexpr int MIN_COMPACTION_SIZE = 64;
 
 		std::array<Cell, NUM_CELLS> m_cells;
+		float m_looseness;
 
+		// an entry is either an object or a link of the free list, the object's AABB is stored at the same
+		// index in m_cellDataAABBs so that the AABBs of a cell are contiguous and can be tested with SIMD
 		union CellData
 		{
 			public:
-				CellData(T object, const AABB2& objectAABB) :
-					m_object(object),
-					m_objectAABB(objectAABB)
+				CellData(T object)
 				{
-					FLAT_ASSERT(!isAvailable());
+					setObject(object);
 				}
 
-				CellData(const CellData& other) :
-					m_object(other.m_object),
-					m_objectAABB(other.m_objectAABB)
-				{
-				}
+				// copies free list links as well when the vector grows
+				CellData(const CellData& other) = default;
 
 				void operator=(const CellData& other)
 				{
 					FLAT_ASSERT(!isAvailable());
 					m_object = other.m_object;
-					m_objectAABB = other.m_objectAABB;
 				}
 
 				inline bool operator==(T object)
@@ -182,10 +258,11 @@ class QuadTree
 					return m_object == object;
 				}
 
-				inline void setObject(T object, const AABB2& objectAABB)
+				inline void setObject(T object)
 				{
+					// the object does not overlap the availability flag if it is smaller than 8 bytes
+					m_availability = CellAvailability::UNAVAILABLE;
 					m_object = object;
-					m_objectAABB = objectAABB;
 					FLAT_ASSERT(!isAvailable());
 				}
 
@@ -201,21 +278,6 @@ class QuadTree
 					return m_object;
 				}
 
-				inline const AABB2& getObjectAABB() const
-				{
-					FLAT_ASSERT(!isAvailable());
-					FLAT_ASSERT(m_objectAABB.isValid());
-					return m_objectAABB;
-				}
-
-				inline void updateAABB(const AABB2& objectAABB)
-				{
-					FLAT_ASSERT(!isAvailable());
-					FLAT_ASSERT(m_objectAABB.isValid());
-					FLAT_ASSERT(objectAABB.isValid());
-					m_objectAABB = objectAABB;
-				}
-
 				inline void setAvailable(std::uint32_t nextFreeCellDataIndex)
 				{
 					m_nextFreeCellDataIndex = nextFreeCellDataIndex;
@@ -234,11 +296,7 @@ class QuadTree
 				}
 
 			private:
-				struct 
-				{
-					T m_object;
-					AABB2 m_objectAABB;
-				};
+				T m_object;
 				struct
 				{
 					std::int32_t m_nextFreeCellDataIndex;
@@ -246,7 +304,10 @@ class QuadTree
 				};
 		};
 		std::vector<CellData> m_cellData;
+		AABB2Array m_cellDataAABBs;
 		std::int32_t m_firstFreeCellDataIndex;
+		std::int32_t m_numAvailableCellData;
+		float m_compactionThreshold;
 
 #ifdef FLAT_DEBUG
 		std::set<T> m_objects;
@@ -254,9 +315,13 @@ class QuadTree
 };
 
 template <class T, int depth, void (*GetAABB)(T, AABB2&)>
-inline QuadTree<T, depth, GetAABB>::QuadTree(const AABB2& aabb) :
-	m_firstFreeCellDataIndex(CellIndex::INVALID)
+inline QuadTree<T, depth, GetAABB>::QuadTree(const AABB2& aabb, float looseness) :
+	m_looseness(looseness),
+	m_firstFreeCellDataIndex(CellIndex::INVALID),
+	m_numAvailableCellData(0),
+	m_compactionThreshold(0.5f)
 {
+	FLAT_ASSERT(looseness >= 1.f);
 	initAABBs(getRootCell(), aabb);
 }
 
@@ -356,6 +421,56 @@ inline void QuadTree<T, depth, GetAABB>::clear()
 		cell.m_cellDataCount = 0;
 	}
 	m_cellData.clear();
+	m_cellDataAABBs.clear();
+	m_numAvailableCellData = 0;
+}
+
+template <class T, int depth, void (*GetAABB)(T, AABB2&)>
+void QuadTree<T, depth, GetAABB>::rebuild(const T* objects, const AABB2* objectAABBs, size_t numObjects, int* cellIndices)
+{
+	clear();
+
+	std::vector<int> objectCellIndices;
+	if (cellIndices == nullptr)
+	{
+		objectCellIndices.resize(numObjects);
+		cellIndices = objectCellIndices.data();
+	}
+
+	// the cell of an object only depends on its AABB, so this pass can run on all cores
+	std::transform(std::execution::par, objectAABBs, objectAABBs + numObjects, cellIndices, [this](const AABB2& objectAABB)
+	{
+		FLAT_ASSERT(objectAABB.isValid());
+		return findCellIndexForAABB(objectAABB);
+	});
+
+	// counting sort: each cell gets a contiguous range of cell data
+	for (size_t i = 0; i < numObjects; ++i)
+	{
+		++m_cells[cellIndices[i]].m_cellDataCount;
+	}
+
+	std::uint32_t cellDataIndex = 0;
+	for (Cell& cell : m_cells)
+	{
+		if (cell.m_cellDataCount > 0)
+		{
+			cell.m_cellDataIndex = cellDataIndex;
+			cellDataIndex += cell.m_cellDataCount;
+			cell.m_cellDataCount = 0;
+		}
+	}
+
+	m_cellData.resize(numObjects, CellData(T()));
+	m_cellDataAABBs.resize(numObjects);
+	for (size_t i = 0; i < numObjects; ++i)
+	{
+		FLAT_ASSERT(m_objects.find(objects[i]) == m_objects.end());
+		FLAT_DEBUG_ONLY(m_objects.insert(objects[i]);)
+		Cell& cell = m_cells[cellIndices[i]];
+		setCellData(cell.m_cellDataIndex + cell.m_cellDataCount, objects[i], objectAABBs[i]);
+		++cell.m_cellDataCount;
+	}
 }
 
 template <class T, int depth, void (*GetAABB)(T, AABB2&)>
@@ -388,10 +503,232 @@ inline void QuadTree<T, depth, GetAABB>::eachObject(const Vector2& point, Func f
 	eachObjectInCell(getRootCell(), point, func);
 }
 
+template <class T, int depth, void (*GetAABB)(T, AABB2&)>
+template <class Container>
+inline void QuadTree<T, depth, GetAABB>::getObjects(const AABB2* aabbs, size_t numAABBs, Container& objects) const
+{
+	eachObject(aabbs, numAABBs, [&objects](int queryIndex, T object)
+	{
+		objects.emplace_back(queryIndex, object);
+	});
+}
+
+template <class T, int depth, void (*GetAABB)(T, AABB2&)>
+template <typename Func>
+inline void QuadTree<T, depth, GetAABB>::eachObject(const AABB2* aabbs, size_t numAABBs, Func func) const
+{
+	eachCellDataIndex(aabbs, numAABBs, [this, &func](int queryIndex, size_t cellDataIndex)
+	{
+		func(queryIndex, m_cellData[cellDataIndex].getObject());
+	});
+}
+
+template <class T, int depth, void (*GetAABB)(T, AABB2&)>
+template <class Container>
+inline void QuadTree<T, depth, GetAABB>::getUniqueObjects(const AABB2* aabbs, size_t numAABBs, Container& objects) const
+{
+	eachUniqueObject(aabbs, numAABBs, [&objects](T object)
+	{
+		objects.push_back(object);
+	});
+}
+
+template <class T, int depth, void (*GetAABB)(T, AABB2&)>
+template <typename Func>
+inline void QuadTree<T, depth, GetAABB>::eachUniqueObject(const AABB2* aabbs, size_t numAABBs, Func func) const
+{
+	// each object has a single cell data slot: mark the slots during the walk then report them in memory order
+	containers::DynamicBitset foundCellData(m_cellData.size());
+	eachCellDataIndex(aabbs, numAABBs, [&foundCellData](int, size_t cellDataIndex)
+	{
+		foundCellData.set(cellDataIndex);
+	});
+	foundCellData.eachSetBit([this, &func](size_t cellDataIndex)
+	{
+		func(m_cellData[cellDataIndex].getObject());
+	});
+}
+
+template <class T, int depth, void (*GetAABB)(T, AABB2&)>
+template <typename Func>
+inline void QuadTree<T, depth, GetAABB>::eachCellDataIndex(const AABB2* aabbs, size_t numAABBs, Func func) const
+{
+	BatchQuery batchQuery;
+	batchQuery.aabbs = aabbs;
+
+	const Cell& rootCell = getRootCell();
+	std::vector<int>& rootQueries = batchQuery.levelQueries[0];
+	rootQueries.reserve(numAABBs);
+	for (size_t i = 0; i < numAABBs; ++i)
+	{
+		FLAT_ASSERT(aabbs[i].isValid());
+		if (rootCell.overlap(aabbs[i]))
+		{
+			rootQueries.push_back(static_cast<int>(i));
+		}
+	}
+
+	if (!rootQueries.empty())
+	{
+		eachObjectInCell(rootCell, 0, batchQuery, func);
+	}
+}
+
+template <class T, int depth, void (*GetAABB)(T, AABB2&)>
+template <class Container>
+void QuadTree<T, depth, GetAABB>::nearest(const Vector2& point, int k, float maxDistance, Container& objects) const
+{
+	FLAT_ASSERT(k > 0);
+	using Distance = std::pair<float, std::int32_t>;
+
+	// best first: cells are visited from the closest one and the search stops once the closest remaining cell
+	// is farther than the k-th closest object found so far
+	std::priority_queue<Distance, std::vector<Distance>, std::greater<Distance>> cellDistances;
+	std::priority_queue<Distance> objectDistances;
+
+	const Cell& rootCell = getRootCell();
+	const float rootDistance = intersection::pointToRectangleDistance(rootCell.m_aabb, point);
+	if (rootDistance <= maxDistance)
+	{
+		cellDistances.emplace(rootDistance, 0);
+	}
+
+	while (!cellDistances.empty())
+	{
+		const Distance cellDistance = cellDistances.top();
+		cellDistances.pop();
+		if (static_cast<int>(objectDistances.size()) == k && cellDistance.first >= objectDistances.top().first)
+		{
+			break;
+		}
+
+		const Cell& cell = m_cells[cellDistance.second];
+		if (cell.m_cellDataCount > 0)
+		{
+			FLAT_ASSERT(cell.m_cellDataIndex != CellIndex::INVALID);
+			const std::int32_t begin = cell.m_cellDataIndex;
+			const std::int32_t end = begin + cell.m_cellDataCount;
+			for (std::int32_t i = begin; i < end; ++i)
+			{
+				const float distance = intersection::pointToRectangleDistance(m_cellDataAABBs.get(i), point);
+				if (distance > maxDistance)
+				{
+					continue;
+				}
+
+				if (static_cast<int>(objectDistances.size()) < k)
+				{
+					objectDistances.emplace(distance, i);
+				}
+				else if (distance < objectDistances.top().first)
+				{
+					objectDistances.pop();
+					objectDistances.emplace(distance, i);
+				}
+			}
+		}
+
+		if (!isLeaf(cell))
+		{
+			for (ChildPosition childPosition : { ChildPosition::BOTTOM_LEFT, ChildPosition::BOTTOM_RIGHT, ChildPosition::TOP_LEFT, ChildPosition::TOP_RIGHT })
+			{
+				const Cell& childCell = getChild(cell, childPosition);
+				const float distance = intersection::pointToRectangleDistance(childCell.m_aabb, point);
+				if (distance <= maxDistance)
+				{
+					cellDistances.emplace(distance, getCellIndex(childCell));
+				}
+			}
+		}
+	}
+
+	// the max heap gives the farthest object first
+	std::vector<T> closestObjects(objectDistances.size());
+	for (typename std::vector<T>::reverse_iterator it = closestObjects.rbegin(); it != closestObjects.rend(); ++it)
+	{
+		*it = m_cellData[objectDistances.top().second].getObject();
+		objectDistances.pop();
+	}
+
+	for (T object : closestObjects)
+	{
+		objects.push_back(object);
+	}
+}
+
+template <class T, int depth, void (*GetAABB)(T, AABB2&)>
+template <typename Func>
+void QuadTree<T, depth, GetAABB>::raycast(const Vector2& origin, const Vector2& direction, float maxDistance, Func func) const
+{
+	FLAT_ASSERT(areValuesClose(length2(direction), 1.f, 0.001f));
+
+	// cells and objects share the same queue so that objects are reported in order, from the closest
+	struct RayHit
+	{
+		float distance;
+		std::int32_t index;
+		bool isObject;
+
+		bool operator>(const RayHit& other) const { return distance > other.distance; }
+	};
+	std::priority_queue<RayHit, std::vector<RayHit>, std::greater<RayHit>> rayHits;
+
+	float distance;
+	if (intersection::rayToRectangle(origin, direction, maxDistance, getRootCell().m_aabb, &distance))
+	{
+		rayHits.push({ distance, 0, false });
+	}
+
+	while (!rayHits.empty())
+	{
+		const RayHit rayHit = rayHits.top();
+		rayHits.pop();
+
+		if (rayHit.isObject)
+		{
+			if (!func(m_cellData[rayHit.index].getObject(), rayHit.distance))
+			{
+				return;
+			}
+			continue;
+		}
+
+		const Cell& cell = m_cells[rayHit.index];
+		if (cell.m_cellDataCount > 0)
+		{
+			FLAT_ASSERT(cell.m_cellDataIndex != CellIndex::INVALID);
+			const std::int32_t begin = cell.m_cellDataIndex;
+			const std::int32_t end = begin + cell.m_cellDataCount;
+			for (std::int32_t i = begin; i < end; ++i)
+			{
+				if (intersection::rayToRectangle(origin, direction, maxDistance, m_cellDataAABBs.get(i), &distance))
+				{
+					rayHits.push({ distance, i, true });
+				}
+			}
+		}
+
+		if (!isLeaf(cell))
+		{
+			for (ChildPosition childPosition : { ChildPosition::BOTTOM_LEFT, ChildPosition::BOTTOM_RIGHT, ChildPosition::TOP_LEFT, ChildPosition::TOP_RIGHT })
+			{
+				const Cell& childCell = getChild(cell, childPosition);
+				if (intersection::rayToRectangle(origin, direction, maxDistance, childCell.m_aabb, &distance))
+				{
+					rayHits.push({ distance, getCellIndex(childCell), false });
+				}
+			}
+		}
+	}
+}
+
 template <class T, int depth, void (*GetAABB)(T, AABB2&)>
 inline void QuadTree<T, depth, GetAABB>::initAABBs(Cell& cell, const AABB2& aabb)
 {
-	cell.setAABB(aabb);
+	// children are split from the tight bounds, only the stored bounds are inflated
+	// the root keeps the tight bounds so that objects outside of the world are still rejected
+	const Vector2 margin = isRoot(cell) ? Vector2(0.f, 0.f) : aabb.getSize() * ((m_looseness - 1.f) / 2.f);
+	cell.setAABB(AABB2(aabb.min - margin, aabb.max + margin));
 	if (!isLeaf(cell))
 	{
 		Cell& bottomLeftCell = getChild(cell, ChildPosition::BOTTOM_LEFT);
@@ -470,6 +807,11 @@ inline const typename QuadTree<T, depth, GetAABB>::Cell& QuadTree<T, depth, GetA
 template <class T, int depth, void (*GetAABB)(T, AABB2&)>
 inline typename QuadTree<T, depth, GetAABB>::Cell& QuadTree<T, depth, GetAABB>::findChildCellForAABB(Cell& cell, const AABB2& aabb)
 {
+	if (isLoose())
+	{
+		return findLooseChildCellForAABB(cell, aabb);
+	}
+
 	if (!isLeaf(cell))
 	{
 		Cell& bottomLeftCell = getChild(cell, ChildPosition::BOTTOM_LEFT);
@@ -500,6 +842,126 @@ inline typename QuadTree<T, depth, GetAABB>::Cell& QuadTree<T, depth, GetAABB>::
 	return cell;
 }
 
+template <class T, int depth, void (*GetAABB)(T, AABB2&)>
+inline typename QuadTree<T, depth, GetAABB>::Cell& QuadTree<T, depth, GetAABB>::findLooseChildCellForAABB(Cell& cell, const AABB2& aabb)
+{
+	// the only child that can hold the object is the one around its center, the inflated bounds then tell if it is small enough
+	if (!isLeaf(cell))
+	{
+		Cell& childCell = getChildAroundPoint(cell, aabb.getCenter());
+		if (childCell.contains(aabb))
+		{
+			return findLooseChildCellForAABB(childCell, aabb);
+		}
+	}
+
+	return cell;
+}
+
+template <class T, int depth, void (*GetAABB)(T, AABB2&)>
+inline typename QuadTree<T, depth, GetAABB>::Cell& QuadTree<T, depth, GetAABB>::getChildAroundPoint(const Cell& cell, const Vector2& point)
+{
+	FLAT_ASSERT(!isLeaf(cell));
+	const Vector2 cellCenter = cell.getCenter();
+	if (point.y < cellCenter.y)
+	{
+		return getChild(cell, point.x < cellCenter.x ? ChildPosition::BOTTOM_LEFT : ChildPosition::BOTTOM_RIGHT);
+	}
+	else
+	{
+		return getChild(cell, point.x < cellCenter.x ? ChildPosition::TOP_LEFT : ChildPosition::TOP_RIGHT);
+	}
+}
+
+template <class T, int depth, void (*GetAABB)(T, AABB2&)>
+int QuadTree<T, depth, GetAABB>::findCellIndexForAABB(const AABB2& aabb)
+{
+	// cells of a level are indexed by the Morton code of their position, so the cell can be found
+	// from the leaf coordinates of the AABB instead of descending the tree
+	constexpr int LEAF_LEVEL = depth - 1;
+	constexpr int LEAF_RESOLUTION = 1 << LEAF_LEVEL;
+	static_assert(LEAF_LEVEL <= 16, "Morton codes are limited to 16 bits per axis");
+
+	const Cell& rootCell = getRootCell();
+	const Vector2 rootSize = rootCell.m_aabb.getSize();
+	const Vector2 rootMin = rootCell.m_aabb.min;
+	const Vector2 leafSize = rootSize / static_cast<float>(LEAF_RESOLUTION);
+
+	auto toLeafCoordinate = [](float coordinate) -> std::uint32_t
+	{
+		return static_cast<std::uint32_t>(std::min(std::max(coordinate, 0.f), static_cast<float>(LEAF_RESOLUTION - 1)));
+	};
+	auto isOnLeafBoundary = [](float coordinate)
+	{
+		return std::abs(coordinate - std::round(coordinate)) < 1e-3f;
+	};
+
+	int level;
+	std::uint32_t mortonCode;
+	if (isLoose())
+	{
+		// a center on a cell boundary, give or take float rounding, can land on the other side than getChildAroundPoint()
+		const Vector2 center = (aabb.getCenter() - rootMin) / leafSize;
+		if (isOnLeafBoundary(center.x) || isOnLeafBoundary(center.y))
+		{
+			FLAT_ASSERT_MSG(rootCell.contains(aabb), "AABB is outside of the quad tree's root cell");
+			return getCellIndex(findChildCellForAABB(getRootCell(), aabb));
+		}
+
+		// deepest level whose margin is wide enough for the object, wherever its center lies in the cell
+		const Vector2 halfSize = aabb.getSize() / 2.f;
+		const float marginRatio = (m_looseness - 1.f) / 2.f;
+		level = LEAF_LEVEL;
+		while (level > 0)
+		{
+			const Vector2 margin = leafSize * static_cast<float>(1 << (LEAF_LEVEL - level)) * marginRatio;
+			if (halfSize.x <= margin.x && halfSize.y <= margin.y)
+			{
+				break;
+			}
+			--level;
+		}
+
+		mortonCode = getMortonCode(toLeafCoordinate(std::floor(center.x)), toLeafCoordinate(std::floor(center.y)));
+	}
+	else if (aabb.min.x == aabb.max.x || aabb.min.y == aabb.max.y)
+	{
+		// a flat AABB lying on a cell boundary fits in the cells on both sides, only the root descent knows which one it takes
+		FLAT_ASSERT_MSG(rootCell.contains(aabb), "AABB is outside of the quad tree's root cell");
+		return getCellIndex(findChildCellForAABB(getRootCell(), aabb));
+	}
+	else
+	{
+		// the common prefix of the Morton codes of both corners gives the deepest cell containing them
+		const Vector2 min = (aabb.min - rootMin) / leafSize;
+		const Vector2 max = (aabb.max - rootMin) / leafSize;
+		const std::uint32_t minX = toLeafCoordinate(std::floor(min.x));
+		const std::uint32_t minY = toLeafCoordinate(std::floor(min.y));
+		const std::uint32_t maxX = std::max(toLeafCoordinate(std::ceil(max.x) - 1.f), minX);
+		const std::uint32_t maxY = std::max(toLeafCoordinate(std::ceil(max.y) - 1.f), minY);
+		mortonCode = getMortonCode(minX, minY);
+		std::uint32_t differentBits = mortonCode ^ getMortonCode(maxX, maxY);
+		level = LEAF_LEVEL;
+		while (differentBits != 0)
+		{
+			differentBits >>= 2;
+			--level;
+		}
+	}
+
+	mortonCode >>= 2 * (LEAF_LEVEL - level);
+	Cell* cell = &m_cells[getLevelFirstCellIndex(level) + mortonCode];
+
+	// float rounding can pick a cell slightly too small, and descending handles what the
+	// Morton code cannot see (loose cells fitting bigger objects near their center)
+	while (!cell->contains(aabb) && !isRoot(*cell))
+	{
+		cell = &getParentCell(*cell);
+	}
+	FLAT_ASSERT_MSG(cell->contains(aabb), "AABB is outside of the quad tree's root cell");
+	return getCellIndex(findChildCellForAABB(*cell, aabb));
+}
+
 template <class T, int depth, void (*GetAABB)(T, AABB2&)>
 template <class Container>
 inline void QuadTree<T, depth, GetAABB>::getObjectsInCell(const Cell& cell, const AABB2& aabb, Container& objects) const
@@ -509,15 +971,11 @@ inline void QuadTree<T, depth, GetAABB>::getObjectsInCell(const Cell& cell, cons
 		if (cell.m_cellDataCount > 0)
 		{
 			FLAT_ASSERT(cell.m_cellDataIndex != CellIndex::INVALID);
-			std::vector<CellData>::const_iterator it = m_cellData.begin() + cell.m_cellDataIndex;
-			std::vector<CellData>::const_iterator end = it + cell.m_cellDataCount;
-			for (; it != end; ++it)
+			const size_t begin = cell.m_cellDataIndex;
+			m_cellDataAABBs.eachOverlap(aabb, begin, begin + cell.m_cellDataCount, [this, &objects](size_t i)
 			{
-				if (AABB2::overlap(aabb, it->getObjectAABB()))
-				{
-					objects.push_back(it->getObject());
-				}
-			}
+				objects.push_back(m_cellData[i].getObject());
+			});
 		}
 
 		if (!isLeaf(cell))
@@ -546,15 +1004,11 @@ inline void QuadTree<T, depth, GetAABB>::getObjectsInCell(const Cell& cell, cons
 		if (cell.m_cellDataCount > 0)
 		{
 			FLAT_ASSERT(cell.m_cellDataIndex != CellIndex::INVALID);
-			std::vector<CellData>::const_iterator it = m_cellData.begin() + cell.m_cellDataIndex;
-			std::vector<CellData>::const_iterator end = it + cell.m_cellDataCount;
-			for (; it != end; ++it)
+			const size_t begin = cell.m_cellDataIndex;
+			m_cellDataAABBs.eachInside(point, begin, begin + cell.m_cellDataCount, [this, &objects](size_t i)
 			{
-				if (it->getObjectAABB().isInside(point))
-				{
-					objects.push_back(it->getObject());
-				}
-			}
+				objects.push_back(m_cellData[i].getObject());
+			});
 		}
 
 		if (!isLeaf(cell))
@@ -583,15 +1037,11 @@ inline void QuadTree<T, depth, GetAABB>::eachObjectInCell(const Cell& cell, cons
 		if (cell.m_cellDataCount > 0)
 		{
 			FLAT_ASSERT(cell.m_cellDataIndex != CellIndex::INVALID);
-			std::vector<CellData>::const_iterator it = m_cellData.begin() + cell.m_cellDataIndex;
-			std::vector<CellData>::const_iterator end = it + cell.m_cellDataCount;
-			for (; it != end; ++it)
+			const size_t begin = cell.m_cellDataIndex;
+			m_cellDataAABBs.eachOverlap(aabb, begin, begin + cell.m_cellDataCount, [this, &func](size_t i)
 			{
-				if (AABB2::overlap(aabb, it->getObjectAABB()))
-				{
-					func(it->getObject());
-				}
-			}
+				func(m_cellData[i].getObject());
+			});
 		}
 
 		if (!isLeaf(cell))
@@ -620,30 +1070,70 @@ inline void QuadTree<T, depth, GetAABB>::eachObjectInCell(const Cell& cell, cons
 		if (cell.m_cellDataCount > 0)
 		{
 			FLAT_ASSERT(cell.m_cellDataIndex != CellIndex::INVALID);
-			std::vector<CellData>::const_iterator it = m_cellData.begin() + cell.m_cellDataIndex;
-			std::vector<CellData>::const_iterator itEnd = it + cell.m_cellDataCount;
-			for (; it != end; ++it)
+			const size_t begin = cell.m_cellDataIndex;
+			m_cellDataAABBs.eachInside(point, begin, begin + cell.m_cellDataCount, [this, &func](size_t i)
 			{
-				if (it->getObjectAABB().isInside(point))
-				{
-					func(it->getObject());
-				}
-			}
+				func(m_cellData[i].getObject());
+			});
 		}
 
 		if (!isLeaf(cell))
 		{
 			const Cell& bottomLeftCell = getChild(cell, ChildPosition::BOTTOM_LEFT);
-			getObjectsInCell(bottomLeftCell, point, func);
+			eachObjectInCell(bottomLeftCell, point, func);
 
 			const Cell& bottomRightCell = getChild(cell, ChildPosition::BOTTOM_RIGHT);
-			getObjectsInCell(bottomRightCell, point, func);
+			eachObjectInCell(bottomRightCell, point, func);
 
 			const Cell& topLeftCell = getChild(cell, ChildPosition::TOP_LEFT);
-			getObjectsInCell(topLeftCell, point, func);
+			eachObjectInCell(topLeftCell, point, func);
 
 			const Cell& topRightCell = getChild(cell, ChildPosition::TOP_RIGHT);
-			getObjectsInCell(topRightCell, point, func);
+			eachObjectInCell(topRightCell, point, func);
+		}
+	}
+}
+
+template <class T, int depth, void (*GetAABB)(T, AABB2&)>
+template <typename Func>
+inline void QuadTree<T, depth, GetAABB>::eachObjectInCell(const Cell& cell, int level, BatchQuery& batchQuery, Func func) const
+{
+	const std::vector<int>& queries = batchQuery.levelQueries[level];
+	FLAT_ASSERT(!queries.empty());
+
+	if (cell.m_cellDataCount > 0)
+	{
+		FLAT_ASSERT(cell.m_cellDataIndex != CellIndex::INVALID);
+		const size_t begin = cell.m_cellDataIndex;
+		const size_t end = begin + cell.m_cellDataCount;
+		for (int queryIndex : queries)
+		{
+			m_cellDataAABBs.eachOverlap(batchQuery.aabbs[queryIndex], begin, end, [queryIndex, &func](size_t i)
+			{
+				func(queryIndex, i);
+			});
+		}
+	}
+
+	if (!isLeaf(cell))
+	{
+		std::vector<int>& childQueries = batchQuery.levelQueries[level + 1];
+		for (ChildPosition childPosition : { ChildPosition::BOTTOM_LEFT, ChildPosition::BOTTOM_RIGHT, ChildPosition::TOP_LEFT, ChildPosition::TOP_RIGHT })
+		{
+			const Cell& childCell = getChild(cell, childPosition);
+			childQueries.clear();
+			for (int queryIndex : queries)
+			{
+				if (childCell.overlap(batchQuery.aabbs[queryIndex]))
+				{
+					childQueries.push_back(queryIndex);
+				}
+			}
+
+			if (!childQueries.empty())
+			{
+				eachObjectInCell(childCell, level + 1, batchQuery, func);
+			}
 		}
 	}
 }
@@ -651,6 +1141,13 @@ inline void QuadTree<T, depth, GetAABB>::eachObjectInCell(const Cell& cell, cons
 template <class T, int depth, void (*GetAABB)(T, AABB2&)>
 inline typename QuadTree<T, depth, GetAABB>::Cell& QuadTree<T, depth, GetAABB>::updateObjectCell(Cell& cell, const AABB2& aabb)
 {
+	if (isLoose())
+	{
+		// loose cells overlap, walking up from the previous cell could end in a different cell than removeObject() would find
+		FLAT_ASSERT_MSG(getRootCell().contains(aabb), "AABB is outside of the quad tree's root cell");
+		return findLooseChildCellForAABB(getRootCell(), aabb);
+	}
+
 	if (cell.contains(aabb))
 	{
 		return findChildCellForAABB(cell, aabb);
@@ -691,9 +1188,10 @@ void QuadTree<T, depth, GetAABB>::addObjectInCell(Cell& cell, T object, const AA
 			cell.m_cellDataIndex = m_firstFreeCellDataIndex;
 			cell.m_cellDataCount = 1;
 
-			m_cellData[cell.m_cellDataIndex].setObject(object, objectAABB);
+			setCellData(cell.m_cellDataIndex, object, objectAABB);
 
 			m_firstFreeCellDataIndex = nextFreeCellDataIndex;
+			--m_numAvailableCellData;
 
 			FLAT_ASSERT(m_firstFreeCellDataIndex == CellIndex::INVALID || m_cellData[m_firstFreeCellDataIndex].isAvailable());
 		}
@@ -702,7 +1200,7 @@ void QuadTree<T, depth, GetAABB>::addObjectInCell(Cell& cell, T object, const AA
 			// allocate
 			cell.m_cellDataIndex = cellDataCount;
 			cell.m_cellDataCount = 1;
-			m_cellData.emplace_back(object, objectAABB);
+			addCellData(object, objectAABB);
 
 			FLAT_ASSERT(m_firstFreeCellDataIndex == CellIndex::INVALID || m_cellData[m_firstFreeCellDataIndex].isAvailable());
 		}
@@ -717,7 +1215,7 @@ void QuadTree<T, depth, GetAABB>::addObjectInCell(Cell& cell, T object, const AA
 		{
 			// simply put at the end
 			++cell.m_cellDataCount;
-			m_cellData.emplace_back(object, objectAABB);
+			addCellData(object, objectAABB);
 
 			FLAT_ASSERT(m_firstFreeCellDataIndex == CellIndex::INVALID || m_cellData[m_firstFreeCellDataIndex].isAvailable());
 		}
@@ -728,7 +1226,8 @@ void QuadTree<T, depth, GetAABB>::addObjectInCell(Cell& cell, T object, const AA
 				&& m_cellData[newItemIndex].getNextFreeCellDataIndex() == CellIndex::INVALID_AVAILABLE)
 			{
 				++cell.m_cellDataCount;
-				m_cellData[newItemIndex].setObject(object, objectAABB);
+				setCellData(newItemIndex, object, objectAABB);
+				--m_numAvailableCellData;
 
 				if (newItemIndex == m_firstFreeCellDataIndex)
 				{
@@ -741,26 +1240,27 @@ void QuadTree<T, depth, GetAABB>::addObjectInCell(Cell& cell, T object, const AA
 			{
 				FLAT_ASSERT(m_firstFreeCellDataIndex == CellIndex::INVALID || m_cellData[m_firstFreeCellDataIndex].isAvailable());
 
-				// relocate at the end
-				m_cellData.reserve(m_cellData.size() + cell.m_cellDataCount + 1);
-
-				std::vector<CellData>::iterator begin = m_cellData.begin() + cell.m_cellDataIndex;
-				std::vector<CellData>::iterator end = begin + cell.m_cellDataCount;
-				for (std::vector<CellData>::iterator it = begin; it != end; ++it)
+				// relocate at the end, no reserve: an exact reserve reallocates on every relocation
+				const std::int32_t begin = cell.m_cellDataIndex;
+				const std::int32_t end = begin + cell.m_cellDataCount;
+				for (std::int32_t i = begin; i < end; ++i)
 				{
-					m_cellData.emplace_back(*it);
-					it->setAvailable(CellIndex::INVALID_AVAILABLE);
+					addCellData(m_cellData[i].getObject(), m_cellDataAABBs.get(i));
+					m_cellData[i].setAvailable(CellIndex::INVALID_AVAILABLE);
 				}
+				m_numAvailableCellData += cell.m_cellDataCount;
 
 				FLAT_ASSERT(m_firstFreeCellDataIndex == CellIndex::INVALID || m_cellData[m_firstFreeCellDataIndex].isAvailable());
-				begin->setAvailable(m_firstFreeCellDataIndex);
+				m_cellData[begin].setAvailable(m_firstFreeCellDataIndex);
 				m_firstFreeCellDataIndex = cell.m_cellDataIndex;
 
 				++cell.m_cellDataCount;
 				cell.m_cellDataIndex = cellDataCount;
-				m_cellData.emplace_back(object, objectAABB);
+				addCellData(object, objectAABB);
 
 				FLAT_ASSERT(m_firstFreeCellDataIndex == CellIndex::INVALID || m_cellData[m_firstFreeCellDataIndex].isAvailable());
+
+				compactIfFragmented();
 			}
 		}
 	}
@@ -772,18 +1272,9 @@ void flat::geometry::QuadTree<T, depth, GetAABB>::updateObjectInCell(Cell& cell,
 	FLAT_ASSERT(cell.m_cellDataCount > 0);
 	FLAT_ASSERT(cell.m_cellDataIndex != CellIndex::INVALID);
 
-	std::vector<CellData>::iterator it = m_cellData.begin() + cell.m_cellDataIndex;
-	std::vector<CellData>::iterator end = it + cell.m_cellDataCount;
-	for (; it != end; ++it)
-	{
-		if (it->getObject() == object)
-		{
-			it->updateAABB(objectAABB);
-			return;
-		}
-	}
-
-	FLAT_ASSERT_MSG(false, "object not found in cell");
+	FLAT_ASSERT(objectAABB.isValid());
+	const std::int32_t cellDataIndex = findCellData(cell, object);
+	m_cellDataAABBs.set(cellDataIndex, objectAABB);
 }
 
 template <class T, int depth, void (*GetAABB)(T, AABB2&)>
@@ -794,29 +1285,30 @@ void QuadTree<T, depth, GetAABB>::removeObjectInCell(Cell& cell, T object)
 	FLAT_ASSERT(cell.m_cellDataCount > 0);
 	FLAT_ASSERT(cell.m_cellDataIndex != CellIndex::INVALID);
 	
-	// find object in cell
-	std::vector<CellData>::iterator it = m_cellData.begin() + cell.m_cellDataIndex;
-	std::vector<CellData>::iterator end = it + cell.m_cellDataCount;
-	it = std::find(it, end, object);
-	FLAT_ASSERT(it != end);
-	std::vector<CellData>::iterator last = end - 1;
-	*it = *last;
+	// find object in cell and replace it with the last one
+	const std::int32_t cellDataIndex = findCellData(cell, object);
+	const std::int32_t lastCellDataIndex = cell.m_cellDataIndex + cell.m_cellDataCount - 1;
+	m_cellData[cellDataIndex] = m_cellData[lastCellDataIndex];
+	m_cellDataAABBs.set(cellDataIndex, m_cellDataAABBs.get(lastCellDataIndex));
 
 	--cell.m_cellDataCount;
+	++m_numAvailableCellData;
 
 	if (cell.m_cellDataCount == 0)
 	{
 		FLAT_ASSERT(m_firstFreeCellDataIndex == CellIndex::INVALID || m_cellData[m_firstFreeCellDataIndex].isAvailable());
-		last->setAvailable(m_firstFreeCellDataIndex);
+		m_cellData[lastCellDataIndex].setAvailable(m_firstFreeCellDataIndex);
 		m_firstFreeCellDataIndex = cell.m_cellDataIndex;
 		cell.m_cellDataIndex = CellIndex::INVALID;
 	}
 	else
 	{
-		last->setAvailable(CellIndex::INVALID_AVAILABLE);
+		m_cellData[lastCellDataIndex].setAvailable(CellIndex::INVALID_AVAILABLE);
 	}
 
 	FLAT_ASSERT(m_firstFreeCellDataIndex == CellIndex::INVALID || m_cellData[m_firstFreeCellDataIndex].isAvailable());
+
+	compactIfFragmented();
 }
 
 template <class T, int depth, void(*GetAABB)(T, AABB2&)>
@@ -825,12 +1317,82 @@ void flat::geometry::QuadTree<T, depth, GetAABB>::replaceObjectInCell(Cell& cell
 	FLAT_ASSERT(cell.m_cellDataCount > 0);
 	FLAT_ASSERT(cell.m_cellDataIndex != CellIndex::INVALID);
 
-	// find object in cell
-	std::vector<CellData>::iterator it = m_cellData.begin() + cell.m_cellDataIndex;  
-	std::vector<CellData>::iterator end = it + cell.m_cellDataCount;
-	it = std::find(it, end, originalObject);
-	FLAT_ASSERT(it != end);
-	it->replaceObject(newObject);
+	const std::int32_t cellDataIndex = findCellData(cell, originalObject);
+	m_cellData[cellDataIndex].replaceObject(newObject);
+}
+
+template <class T, int depth, void (*GetAABB)(T, AABB2&)>
+inline void QuadTree<T, depth, GetAABB>::addCellData(T object, const AABB2& objectAABB)
+{
+	m_cellData.emplace_back(object);
+	m_cellDataAABBs.add(objectAABB);
+	FLAT_ASSERT(m_cellData.size() == m_cellDataAABBs.getSize());
+}
+
+template <class T, int depth, void (*GetAABB)(T, AABB2&)>
+inline void QuadTree<T, depth, GetAABB>::setCellData(std::int32_t cellDataIndex, T object, const AABB2& objectAABB)
+{
+	m_cellData[cellDataIndex].setObject(object);
+	m_cellDataAABBs.set(cellDataIndex, objectAABB);
+}
+
+template <class T, int depth, void (*GetAABB)(T, AABB2&)>
+inline std::int32_t QuadTree<T, depth, GetAABB>::findCellData(const Cell& cell, T object) const
+{
+	FLAT_ASSERT(cell.m_cellDataCount > 0);
+	FLAT_ASSERT(cell.m_cellDataIndex != CellIndex::INVALID);
+	const std::int32_t begin = cell.m_cellDataIndex;
+	const std::int32_t end = begin + cell.m_cellDataCount;
+	for (std::int32_t i = begin; i < end; ++i)
+	{
+		if (m_cellData[i].getObject() == object)
+		{
+			return i;
+		}
+	}
+	FLAT_ASSERT_MSG(false, "object not found in cell");
+	return CellIndex::INVALID;
+}
+
+template <class T, int depth, void (*GetAABB)(T, AABB2&)>
+void QuadTree<T, depth, GetAABB>::compact()
+{
+	// cells are stored breadth first so siblings, which are usually queried together, end up next to each other
+	std::vector<CellData> cellData;
+	AABB2Array cellDataAABBs;
+	const size_t numObjects = m_cellData.size() - m_numAvailableCellData;
+	cellData.reserve(numObjects);
+	cellDataAABBs.reserve(numObjects);
+
+	for (Cell& cell : m_cells)
+	{
+		if (cell.m_cellDataCount > 0)
+		{
+			const std::int32_t begin = cell.m_cellDataIndex;
+			const std::int32_t end = begin + cell.m_cellDataCount;
+			cell.m_cellDataIndex = static_cast<std::uint32_t>(cellData.size());
+			for (std::int32_t i = begin; i < end; ++i)
+			{
+				cellData.push_back(m_cellData[i]);
+				cellDataAABBs.add(m_cellDataAABBs.get(i));
+			}
+		}
+	}
+	FLAT_ASSERT(cellData.size() == numObjects);
+
+	m_cellData.swap(cellData);
+	std::swap(m_cellDataAABBs, cellDataAABBs);
+	m_firstFreeCellDataIndex = CellIndex::INVALID;
+	m_numAvailableCellData = 0;
+}
+
+template <class T, int depth, void (*GetAABB)(T, AABB2&)>
+inline void QuadTree<T, depth, GetAABB>::compactIfFragmented()
+{
+	if (m_numAvailableCellData > MIN_COMPACTION_SIZE && getFragmentation() > m_compactionThreshold)
+	{
+		compact();
+	}
 }
 
 #ifdef FLAT_DEBUG
@@ -875,6 +1437,28 @@ inline constexpr int QuadTree<T, depth, GetAABB>::getNumCells()
 	return numCells;
 }
 
+template <class T, int depth, void (*GetAABB)(T, AABB2&)>
+inline constexpr int QuadTree<T, depth, GetAABB>::getLevelFirstCellIndex(int level)
+{
+	return (cpow(4, level) - 1) / 3;
+}
+
+template <class T, int depth, void (*GetAABB)(T, AABB2&)>
+inline std::uint32_t QuadTree<T, depth, GetAABB>::getMortonCode(std::uint32_t x, std::uint32_t y)
+{
+	// x goes to the even bits to match the child positions: bottom left, bottom right, top left, top right
+	auto spreadBits = [](std::uint32_t value)
+	{
+		value &= 0x0000FFFF;
+		value = (value | (value << 8)) & 0x00FF00FF;
+		value = (value | (value << 4)) & 0x0F0F0F0F;
+		value = (value | (value << 2)) & 0x33333333;
+		value = (value | (value << 1)) & 0x55555555;
+		return value;
+	};
+	return spreadBits(x) | (spreadBits(y) << 1);
+}
+
 } //geometry
 } // flat
 
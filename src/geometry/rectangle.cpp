@@ -31,6 +31,7 @@ void Rectangle::setPositionSize(const Vector2& position, const Vector2& size)
 	m_vertices.emplace_back(position.x + size.x, position.y);
 	m_vertices.push_back(position + size);
 	m_vertices.emplace_back(position.x, position.y + size.y);
+	updateAABB();
 }
 
 void Rectangle::setSize(const Vector2& size)
@@ -0,0 +1,296 @@
+#include <cstdlib>
+#include <cstring>
+#include <algorithm>
+#include <lua5.3/lua.hpp>
+
+#include "lua/allocator.h"
+
+#include "memory/memory.h"
+#include "memory/memorytracker.h"
+#include "debug/assert.h"
+
+namespace flat
+{
+namespace lua
+{
+
+Allocator::Allocator() :
+	m_adoptedBlocks(nullptr),
+	m_numLiveLargeBlocks(0),
+	m_liveLargeBytes(0),
+	m_numLargeAllocations(0)
+{
+	// 16 bytes steps up to 128, then 32 up to 256 and 64 up to 512, lua does not need more than 8 bytes alignment
+	static constexpr size_t blockSizes[] = { 8, 16, 32, 48, 64, 80, 96, 112, 128, 160, 192, 224, 256, 320, 384, 448, 512 };
+	static_assert(blockSizes[sizeof(blockSizes) / sizeof(blockSizes[0]) - 1] == MAX_POOLED_SIZE, "the last size class must be MAX_POOLED_SIZE");
+
+	m_sizeClasses.reserve(sizeof(blockSizes) / sizeof(blockSizes[0]));
+	for (size_t blockSize : blockSizes)
+	{
+		SizeClass sizeClass;
+		sizeClass.freeBlocks = nullptr;
+		sizeClass.blockSize = blockSize;
+		sizeClass.numLiveBlocks = 0;
+		sizeClass.liveBytes = 0;
+		sizeClass.numAllocations = 0;
+		m_sizeClasses.push_back(sizeClass);
+	}
+
+	size_t sizeClassIndex = 0;
+	for (size_t i = 0; i <= MAX_POOLED_SIZE / 8; ++i)
+	{
+		while (m_sizeClasses[sizeClassIndex].blockSize < i * 8)
+		{
+			++sizeClassIndex;
+		}
+		m_sizeClassIndices[i] = static_cast<std::uint8_t>(sizeClassIndex);
+	}
+}
+
+Allocator::~Allocator()
+{
+	for (SizeClass& sizeClass : m_sizeClasses)
+	{
+		for (void* page : sizeClass.pages)
+		{
+			std::free(page);
+		}
+	}
+
+	while (m_adoptedBlocks != nullptr)
+	{
+		FreeBlock* adoptedBlock = m_adoptedBlocks;
+		m_adoptedBlocks = adoptedBlock->next;
+		std::free(reinterpret_cast<unsigned char*>(adoptedBlock) - MAX_POOLED_SIZE);
+	}
+}
+
+void* Allocator::allocate(void* userData, void* pointer, size_t oldSize, size_t newSize)
+{
+	Allocator* allocator = static_cast<Allocator*>(userData);
+	if (newSize == 0)
+	{
+		if (pointer != nullptr)
+		{
+			allocator->freeBlock(pointer, oldSize);
+		}
+		return nullptr;
+	}
+	// when pointer is null, oldSize is the type of the object being allocated
+	return pointer == nullptr ? allocator->allocateBlock(newSize) : allocator->reallocateBlock(pointer, oldSize, newSize);
+}
+
+Allocator::SizeClassStats Allocator::getSizeClassStats(size_t sizeClassIndex) const
+{
+	FLAT_ASSERT(sizeClassIndex < getNumSizeClasses());
+	SizeClassStats stats;
+	if (sizeClassIndex < m_sizeClasses.size())
+	{
+		const SizeClass& sizeClass = m_sizeClasses[sizeClassIndex];
+		stats.blockSize = sizeClass.blockSize;
+		stats.numLiveBlocks = sizeClass.numLiveBlocks;
+		stats.liveBytes = sizeClass.liveBytes;
+		stats.reservedBytes = sizeClass.pages.size() * PAGE_SIZE;
+		stats.numAllocations = sizeClass.numAllocations;
+	}
+	else
+	{
+		stats.blockSize = 0;
+		stats.numLiveBlocks = m_numLiveLargeBlocks;
+		stats.liveBytes = m_liveLargeBytes;
+		stats.reservedBytes = m_liveLargeBytes;
+		stats.numAllocations = m_numLargeAllocations;
+	}
+	return stats;
+}
+
+void* Allocator::allocateBlock(size_t size)
+{
+	if (size > MAX_POOLED_SIZE)
+	{
+		void* pointer = std::malloc(std::max(size, MIN_LARGE_BLOCK_SIZE));
+		if (pointer != nullptr)
+		{
+			FLAT_TRACK_ALLOCATION(memory::MemoryTag::LUA, size);
+			++m_numLiveLargeBlocks;
+			m_liveLargeBytes += size;
+			++m_numLargeAllocations;
+		}
+		return pointer;
+	}
+
+	SizeClass& sizeClass = getSizeClass(size);
+	if (sizeClass.freeBlocks == nullptr && !addPage(sizeClass))
+	{
+		// lua raises a memory error
+		return nullptr;
+	}
+	FLAT_TRACK_ALLOCATION(memory::MemoryTag::LUA, size);
+	FreeBlock* block = sizeClass.freeBlocks;
+	sizeClass.freeBlocks = block->next;
+	++sizeClass.numLiveBlocks;
+	sizeClass.liveBytes += size;
+	++sizeClass.numAllocations;
+	FLAT_INIT_MEMORY(block, sizeClass.blockSize);
+	return block;
+}
+
+void Allocator::freeBlock(void* pointer, size_t size)
+{
+	FLAT_TRACK_FREE(memory::MemoryTag::LUA, size);
+	if (size > MAX_POOLED_SIZE)
+	{
+		FLAT_ASSERT(m_numLiveLargeBlocks > 0 && m_liveLargeBytes >= size);
+		--m_numLiveLargeBlocks;
+		m_liveLargeBytes -= size;
+		std::free(pointer);
+		return;
+	}
+
+	SizeClass& sizeClass = getSizeClass(size);
+	FLAT_ASSERT(sizeClass.numLiveBlocks > 0 && sizeClass.liveBytes >= size);
+	--sizeClass.numLiveBlocks;
+	sizeClass.liveBytes -= size;
+	FLAT_WIPE_MEMORY(pointer, sizeClass.blockSize);
+	FreeBlock* block = static_cast<FreeBlock*>(pointer);
+	block->next = sizeClass.freeBlocks;
+	sizeClass.freeBlocks = block;
+}
+
+void* Allocator::reallocateBlock(void* pointer, size_t oldSize, size_t newSize)
+{
+	if (oldSize > MAX_POOLED_SIZE && newSize > MAX_POOLED_SIZE)
+	{
+		void* newPointer = std::realloc(pointer, std::max(newSize, MIN_LARGE_BLOCK_SIZE));
+		if (newPointer == nullptr)
+		{
+			if (newSize > oldSize)
+			{
+				return nullptr;
+			}
+			// the block is big enough already
+			newPointer = pointer;
+		}
+		FLAT_TRACK_FREE(memory::MemoryTag::LUA, oldSize);
+		FLAT_TRACK_ALLOCATION(memory::MemoryTag::LUA, newSize);
+		m_liveLargeBytes += newSize - oldSize;
+		++m_numLargeAllocations;
+		return newPointer;
+	}
+
+	if (oldSize <= MAX_POOLED_SIZE && newSize <= MAX_POOLED_SIZE)
+	{
+		SizeClass& sizeClass = getSizeClass(oldSize);
+		if (&sizeClass == &getSizeClass(newSize))
+		{
+			// the block is big enough already
+			FLAT_TRACK_FREE(memory::MemoryTag::LUA, oldSize);
+			FLAT_TRACK_ALLOCATION(memory::MemoryTag::LUA, newSize);
+			sizeClass.liveBytes += newSize - oldSize;
+			return pointer;
+		}
+	}
+
+	void* newPointer = allocateBlock(newSize);
+	if (newPointer != nullptr)
+	{
+		std::memcpy(newPointer, pointer, std::min(oldSize, newSize));
+		freeBlock(pointer, oldSize);
+	}
+	else if (newSize < oldSize)
+	{
+		// no smaller block is available and lua cannot handle a failing shrink
+		newPointer = adoptBlock(pointer, oldSize, newSize);
+	}
+	return newPointer;
+}
+
+void* Allocator::adoptBlock(void* pointer, size_t oldSize, size_t newSize)
+{
+	FLAT_ASSERT(newSize < oldSize && newSize <= MAX_POOLED_SIZE);
+	if (oldSize > MAX_POOLED_SIZE)
+	{
+		FLAT_ASSERT(m_numLiveLargeBlocks > 0 && m_liveLargeBytes >= oldSize);
+		--m_numLiveLargeBlocks;
+		m_liveLargeBytes -= oldSize;
+		FreeBlock* adoptedBlock = reinterpret_cast<FreeBlock*>(static_cast<unsigned char*>(pointer) + MAX_POOLED_SIZE);
+		adoptedBlock->next = m_adoptedBlocks;
+		m_adoptedBlocks = adoptedBlock;
+	}
+	else
+	{
+		// the block stays in the page of the bigger size class and goes to the free list of the smaller one
+		SizeClass& oldSizeClass = getSizeClass(oldSize);
+		FLAT_ASSERT(oldSizeClass.numLiveBlocks > 0 && oldSizeClass.liveBytes >= oldSize);
+		--oldSizeClass.numLiveBlocks;
+		oldSizeClass.liveBytes -= oldSize;
+	}
+
+	FLAT_TRACK_FREE(memory::MemoryTag::LUA, oldSize);
+	FLAT_TRACK_ALLOCATION(memory::MemoryTag::LUA, newSize);
+	SizeClass& sizeClass = getSizeClass(newSize);
+	++sizeClass.numLiveBlocks;
+	sizeClass.liveBytes += newSize;
+	++sizeClass.numAllocations;
+	return pointer;
+}
+
+bool Allocator::addPage(SizeClass& sizeClass)
+{
+	FLAT_ASSERT(sizeClass.freeBlocks == nullptr);
+	unsigned char* page = static_cast<unsigned char*>(std::malloc(PAGE_SIZE));
+	if (page == nullptr)
+	{
+		return false;
+	}
+
+	sizeClass.pages.push_back(page);
+
+	const size_t numBlocks = PAGE_SIZE / sizeClass.blockSize;
+	for (size_t i = numBlocks; i-- > 0;)
+	{
+		FreeBlock* block = reinterpret_cast<FreeBlock*>(page + i * sizeClass.blockSize);
+		block->next = sizeClass.freeBlocks;
+		sizeClass.freeBlocks = block;
+	}
+	return true;
+}
+
+int l_flat_lua_getAllocatorStats(lua_State* L)
+{
+	void* userData = nullptr;
+	lua_Alloc allocate = lua_getallocf(L, &userData);
+	if (allocate != &Allocator::allocate)
+	{
+		lua_pushnil(L);
+		return 1;
+	}
+
+	// { { blockSize = 8, numLiveBlocks = ..., liveBytes = ..., reservedBytes = ..., numAllocations = ... }, ... }
+	// the last entry has a blockSize of 0 and gathers the blocks allocated with malloc
+	const Allocator* allocator = static_cast<const Allocator*>(userData);
+	const size_t numSizeClasses = allocator->getNumSizeClasses();
+	lua_createtable(L, static_cast<int>(numSizeClasses), 0);
+	for (size_t i = 0; i < numSizeClasses; ++i)
+	{
+		const Allocator::SizeClassStats stats = allocator->getSizeClassStats(i);
+		lua_createtable(L, 0, 5);
+		lua_pushinteger(L, static_cast<lua_Integer>(stats.blockSize));
+		lua_setfield(L, -2, "blockSize");
+		lua_pushinteger(L, static_cast<lua_Integer>(stats.numLiveBlocks));
+		lua_setfield(L, -2, "numLiveBlocks");
+		lua_pushinteger(L, static_cast<lua_Integer>(stats.liveBytes));
+		lua_setfield(L, -2, "liveBytes");
+		lua_pushinteger(L, static_cast<lua_Integer>(stats.reservedBytes));
+		lua_setfield(L, -2, "reservedBytes");
+		lua_pushinteger(L, static_cast<lua_Integer>(stats.numAllocations));
+		lua_setfield(L, -2, "numAllocations");
+		lua_rawseti(L, -2, static_cast<lua_Integer>(i + 1));
+	}
+	return 1;
+}
+
+} // lua
+} // flat
+
+
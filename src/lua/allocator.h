@@ -0,0 +1,97 @@
+#ifndef FLAT_LUA_ALLOCATOR_H
+#define FLAT_LUA_ALLOCATOR_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+struct lua_State;
+
+namespace flat
+{
+namespace lua
+{
+
+// lua_Alloc serving the small blocks (tables, closures, strings, userdata) from one free list per size class,
+// bigger blocks go to malloc, it must outlive the lua state
+// lua expects shrinking a block to never fail, when no smaller block is available the block is kept where it is
+class Allocator
+{
+	public:
+		static constexpr size_t MAX_POOLED_SIZE = 512;
+		static constexpr size_t PAGE_SIZE = 16 * 1024;
+
+		struct SizeClassStats
+		{
+			size_t blockSize; // 0 for the blocks allocated with malloc
+			size_t numLiveBlocks;
+			size_t liveBytes; // as requested by lua
+			size_t reservedBytes;
+			size_t numAllocations; // since the creation of the state
+		};
+
+	public:
+		Allocator();
+		Allocator(const Allocator&) = delete;
+		Allocator(Allocator&&) = delete;
+		~Allocator();
+
+		void operator=(const Allocator&) = delete;
+
+		// to give to lua_newstate with this allocator as user data
+		static void* allocate(void* userData, void* pointer, size_t oldSize, size_t newSize);
+
+		size_t getNumSizeClasses() const { return m_sizeClasses.size() + 1; }
+		// the last one is for the blocks bigger than MAX_POOLED_SIZE
+		SizeClassStats getSizeClassStats(size_t sizeClassIndex) const;
+
+	private:
+		struct FreeBlock
+		{
+			FreeBlock* next;
+		};
+
+		// blocks allocated with malloc can be given to a size class when shrunk, they are linked
+		// past MAX_POOLED_SIZE so that lua never overwrites the link
+		static constexpr size_t MIN_LARGE_BLOCK_SIZE = MAX_POOLED_SIZE + sizeof(FreeBlock);
+
+		struct SizeClass
+		{
+			FreeBlock* freeBlocks;
+			std::vector<void*> pages;
+			size_t blockSize;
+			size_t numLiveBlocks;
+			size_t liveBytes;
+			size_t numAllocations;
+		};
+
+		void* allocateBlock(size_t size);
+		void freeBlock(void* pointer, size_t size);
+		void* reallocateBlock(void* pointer, size_t oldSize, size_t newSize);
+		// shrinks the block in place, it belongs to the size class of newSize afterwards
+		void* adoptBlock(void* pointer, size_t oldSize, size_t newSize);
+
+		inline SizeClass& getSizeClass(size_t size) { return m_sizeClasses[m_sizeClassIndices[(size + 7) / 8]]; }
+		// false if out of memory
+		bool addPage(SizeClass& sizeClass);
+
+	private:
+		std::vector<SizeClass> m_sizeClasses;
+		std::uint8_t m_sizeClassIndices[MAX_POOLED_SIZE / 8 + 1];
+
+		// malloc blocks given to a size class, freed with the pages
+		FreeBlock* m_adoptedBlocks;
+
+		size_t m_numLiveLargeBlocks;
+		size_t m_liveLargeBytes;
+		size_t m_numLargeAllocations;
+};
+
+int l_flat_lua_getAllocatorStats(lua_State* L);
+
+} // lua
+} // flat
+
+#endif // FLAT_LUA_ALLOCATOR_H
+
+
@@ -16,8 +16,11 @@
 #include "sharp/ui/lua/ui.h"
 #include "misc/lua/vector2.h"
 #include "misc/lua/vector3.h"
+#include "geometry/lua/broadphase.h"
+#include "geometry/lua/polygon.h"
 #include "file/lua/file.h"
 #include "profiler/lua/profiler.h"
+#include "memory/lua/memory.h"
 
 namespace flat
 {
@@ -66,7 +69,9 @@ void Lua::reset(Flat& flat)
 
 	m_typeHashToName.clear();
 
-	state = luaL_newstate();
+	// a new allocator as well to release the pages of the previous state
+	m_allocator = std::make_unique<Allocator>();
+	state = lua_newstate(&Allocator::allocate, m_allocator.get());
 
 	lua_State* L = state;
 	{
@@ -94,7 +99,9 @@ void Lua::reset(Flat& flat)
 		lua_setfield(L, -2, "debug"); // flat.debug = {}/false
 
 		lua_newtable(L);
-		lua_setfield(L, -2, "lua"); // flat.lua = {}
+		lua_pushcfunction(L, l_flat_lua_getAllocatorStats);
+		lua_setfield(L, -2, "getAllocatorStats");
+		lua_setfield(L, -2, "lua"); // flat.lua = {getAllocatorStats = ...}
 
 		lua_setglobal(L, "flat");
 
@@ -110,10 +117,16 @@ void Lua::reset(Flat& flat)
 
 		snapshot::open(*this);
 		profiler::lua::open(L);
+#ifdef FLAT_MEMORY_TRACKING_ENABLED
+		memory::lua::open(L);
+#endif
 
 		lua::openVector2(*this);
 		lua::openVector3(*this);
 
+		geometry::lua::openBroadphase(*this);
+		geometry::lua::openPolygon(*this);
+
 		file::lua::open(*this);
 
 		openRequire(L);
@@ -10,6 +10,7 @@
 #include <lua5.3/lua.hpp>
 
 #include "lua/debug.h"
+#include "lua/allocator.h"
 #include "lua/types.h"
 #include "lua/timer/timercontainer.h"
 
@@ -91,6 +92,9 @@ class Lua
 		std::vector<std::weak_ptr<timer::TimerContainer>> m_timerContainers;
 
 		std::unordered_map<size_t, std::string> m_typeHashToName;
+
+		// declared last to be destroyed after the state is closed
+		std::unique_ptr<Allocator> m_allocator;
 };
 
 void close(lua_State* L);
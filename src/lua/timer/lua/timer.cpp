@@ -13,7 +13,7 @@ namespace timer
 namespace lua
 {
 
-using LuaTimer = flat::lua::SharedCppValue<Timer*>;
+using LuaTimer = flat::lua::SharedCppValue<TimerReference>;
 
 int open(Lua& lua)
 {
@@ -44,70 +44,74 @@ int open(Lua& lua)
 int l_Timer(lua_State* L)
 {
 	TimerContainer* timerContainer = flat::lua::getFlat(L).lua->defaultTimerContainer.get();
-	pushTimer(L, timerContainer->add());
+	pushTimer(L, timerContainer, timerContainer->add());
 	return 1;
 }
 
 int l_Timer_start(lua_State* L)
 {
-	Timer* timer = getTimer(L, 1);
-	const TimerContainer& timerContainer = timer->getTimerContainer();
+	TimerReference& timerReference = getTimerReference(L, 1);
+	Timer& timer = getTimer(L, 1);
 	const float duration = static_cast<float>(luaL_checknumber(L, 2));
 	const bool loop = lua_toboolean(L, 3) == 1;
-	timer->setDuration(duration);
-	timer->setBeginTime(timerContainer.getClock().getTime());
-	timer->setLoop(loop);
-	TimerContainer::callTimerUpdate(L, timer);
+	timer.setDuration(duration);
+	timer.setBeginTime(timerReference.timerContainer->getClock().getTime());
+	timer.setLoop(loop);
+	timerReference.timerContainer->callTimerUpdate(L, timerReference.timerHandle);
 	return 0;
 }
 
 int l_Timer_stop(lua_State* L)
 {
-	Timer* timer = getTimer(L, 1);
-	lua_pushboolean(L, timer->stop());
+	TimerReference& timerReference = getTimerReference(L, 1);
+	lua_pushboolean(L, timerReference.timerContainer->stop(timerReference.timerHandle));
 	return 1;
 }
 
 int l_Timer_getElapsedTime(lua_State* L)
 {
-	Timer* timer = getTimer(L, 1);
-	lua_pushnumber(L, timer->getElapsedTime());
+	Timer& timer = getTimer(L, 1);
+	lua_pushnumber(L, timer.getElapsedTime());
 	return 1;
 }
 
 int l_Timer_onUpdate(lua_State* L)
 {
-	Timer* timer = getTimer(L, 1);
+	Timer& timer = getTimer(L, 1);
 	flat::lua::SharedLuaReference<LUA_TFUNCTION> onUpdate;
 	onUpdate.setIfNotNil(L, 2);
-	timer->setOnUpdate(onUpdate);
+	timer.setOnUpdate(onUpdate);
 	return 0;
 }
 
 int l_Timer_onEnd(lua_State* L)
 {
-	Timer* timer = getTimer(L, 1);	
+	Timer& timer = getTimer(L, 1);
 	flat::lua::SharedLuaReference<LUA_TFUNCTION> onEnd;
 	onEnd.setIfNotNil(L, 2);
-	timer->setOnEnd(onEnd);
+	timer.setOnEnd(onEnd);
 	return 0;
 }
 
-Timer* getTimer(lua_State* L, int index)
+TimerReference& getTimerReference(lua_State* L, int index)
 {
 	return LuaTimer::get(L, index);
 }
 
-void pushTimer(lua_State* L, Timer* timer)
+Timer& getTimer(lua_State* L, int index)
 {
-	if (timer != nullptr)
+	TimerReference& timerReference = getTimerReference(L, index);
+	Timer* timer = timerReference.timerContainer->getTimer(timerReference.timerHandle);
+	if (timer == nullptr)
 	{
-		LuaTimer::pushNew(L, timer);
-	}
-	else
-	{
-		lua_pushnil(L);
+		luaL_error(L, "The timer has been stopped or is finished");
 	}
+	return *timer;
+}
+
+void pushTimer(lua_State* L, TimerContainer* timerContainer, TimerHandle timerHandle)
+{
+	LuaTimer::pushNew(L, TimerReference{ timerContainer, timerHandle });
 }
 
 } // lua
@@ -1,6 +1,8 @@
 #ifndef FLAT_TIME_TIMER_LUA_TIMER_H
 #define FLAT_TIME_TIMER_LUA_TIMER_H
 
+#include "containers/slotmap.h"
+
 struct lua_State;
 
 namespace flat
@@ -13,9 +15,17 @@ namespace timer
 {
 class Timer;
 class TimerContainer;
+using TimerHandle = containers::SlotMapHandle;
 namespace lua
 {
 
+// what lua holds, the handle becomes stale when the timer is stopped or finished
+struct TimerReference
+{
+	TimerContainer* timerContainer;
+	TimerHandle timerHandle;
+};
+
 int open(Lua& lua);
 
 int l_Timer(lua_State* L);
@@ -26,8 +36,9 @@ int l_Timer_onUpdate(lua_State* L);
 int l_Timer_onEnd(lua_State* L);
 
 // private
-Timer* getTimer(lua_State* L, int index);
-void pushTimer(lua_State* L, Timer* timer);
+TimerReference& getTimerReference(lua_State* L, int index);
+Timer& getTimer(lua_State* L, int index);
+void pushTimer(lua_State* L, TimerContainer* timerContainer, TimerHandle timerHandle);
 
 } // lua
 } // timer
@@ -23,11 +23,6 @@ float Timer::getElapsedTime() const
 	return currentTime - m_beginTime;
 }
 
-bool Timer::stop()
-{
-	return m_timerContainer->stop(this);
-}
-
 } // timer
 } // lua
 } // flat
@@ -17,11 +17,11 @@ class Timer
 		Timer() = delete;
 		Timer(TimerContainer* timerContainer);
 		Timer(const Timer&) = delete;
-		Timer(Timer&&) = delete;
+		Timer(Timer&&) = default;
 		~Timer() = default;
 
 		void operator=(const Timer&) = delete;
-		void operator=(Timer&&) = delete;
+		Timer& operator=(Timer&&) = default;
 		
 		inline void setBeginTime(float beginTime) const { m_beginTime = beginTime; }
 		inline float getBeginTime() const { return m_beginTime; }
@@ -43,8 +43,6 @@ class Timer
 		inline bool isFinished(float currentTime) const { return currentTime >= getTimeOut(); }
 
 		inline TimerContainer& getTimerContainer() const { return *m_timerContainer; }
-
-		bool stop();
 		
 	private:
 		TimerContainer* m_timerContainer;
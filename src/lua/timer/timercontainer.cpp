@@ -28,56 +28,26 @@ TimerContainer::~TimerContainer()
 
 size_t TimerContainer::getNumTimers() const
 {
-	return m_timers.size() + m_frameTimers.size();
+	// every live timer is in exactly one of the lists, only the pending ones are left out
+	const size_t numPendingTimers = static_cast<size_t>(std::count_if(m_pendingTimers.begin(), m_pendingTimers.end(), [this](TimerHandle timerHandle) { return m_timers.isValid(timerHandle); }));
+	return m_timers.getSize() - numPendingTimers;
 }
 
 size_t TimerContainer::getNumFrameTimers() const
 {
-	return m_frameTimers.size();
+	return static_cast<size_t>(std::count_if(m_frameTimers.begin(), m_frameTimers.end(), [this](TimerHandle timerHandle) { return m_timers.isValid(timerHandle); }));
 }
 
-Timer* TimerContainer::add()
+TimerHandle TimerContainer::add()
 {
-	Timer* timer = m_timerPool.create(this);
-	FLAT_ASSERT(timer != nullptr);
-	m_pendingTimers.push_back(timer);
-	return timer;
+	TimerHandle timerHandle = m_timers.insert(this);
+	m_pendingTimers.push_back(timerHandle);
+	return timerHandle;
 }
 
-bool TimerContainer::stop(Timer* timer)
+bool TimerContainer::stop(TimerHandle timerHandle)
 {
-	if (!timer->getOnUpdate().isEmpty())
-	{
-		std::vector<Timer*>::iterator it = std::find(m_frameTimers.begin(), m_frameTimers.end(), timer);
-		if (it != m_frameTimers.end())
-		{
-			m_timerPool.destroy(*it);
-			*it = nullptr;
-			return true;
-		}
-		return false;
-	}
-	else
-	{
-		std::deque<Timer*>::iterator it = std::find(m_timers.begin(), m_timers.end(), timer);
-		if (it != m_timers.end())
-		{
-			m_timerPool.destroy(*it);
-			*it = nullptr;
-			return true;
-		}
-		else
-		{
-			std::vector<Timer*>::iterator it = std::find(m_pendingTimers.begin(), m_pendingTimers.end(), timer);
-			if (it != m_pendingTimers.end())
-			{
-				m_timerPool.destroy(*it);
-				m_pendingTimers.erase(it);
-				return true;
-			}
-			return false;
-		}
-	}
+	return m_timers.erase(timerHandle);
 }
 
 void TimerContainer::updateTimers(lua_State* L)
@@ -86,30 +56,28 @@ void TimerContainer::updateTimers(lua_State* L)
 
 	FLAT_ASSERT(m_clock != nullptr);
 	const float time = m_clock->getTime();
-	size_t size = m_timers.size();
-	m_timers.erase(
-	    std::remove(
-			m_timers.begin(),
-			m_timers.end(),
-			nullptr
-			),
-		m_timers.end()
-	);
-	FLAT_ASSERT(std::is_sorted(m_timers.begin(), m_timers.end(), &TimerContainer::compareTimersByTimeout));
+	auto isStopped = [this](TimerHandle timerHandle) { return !m_timers.isValid(timerHandle); };
+	auto compareTimers = [this](TimerHandle a, TimerHandle b) { return compareTimersByTimeout(a, b); };
+	m_sortedTimers.erase(std::remove_if(m_sortedTimers.begin(), m_sortedTimers.end(), isStopped), m_sortedTimers.end());
+	FLAT_ASSERT(std::is_sorted(m_sortedTimers.begin(), m_sortedTimers.end(), compareTimers));
 	// insert pending timers
-	for (std::vector<Timer*>::iterator it = m_pendingTimers.begin(); it != m_pendingTimers.end();)
+	for (std::vector<TimerHandle>::iterator it = m_pendingTimers.begin(); it != m_pendingTimers.end();)
 	{
-		Timer* timer = *it;
-		if (timer->getBeginTime() >= 0)
+		const Timer* timer = m_timers.get(*it);
+		if (timer == nullptr)
+		{
+			it = m_pendingTimers.erase(it);
+		}
+		else if (timer->getBeginTime() >= 0)
 		{
 			if (!timer->getOnUpdate().isEmpty())
 			{
-				m_frameTimers.push_back(timer);
+				m_frameTimers.push_back(*it);
 			}
 			else
 			{
-				std::deque<Timer*>::iterator sortedIterator = std::upper_bound(m_timers.begin(), m_timers.end(), timer, &TimerContainer::compareTimersByTimeout);
-				m_timers.insert(sortedIterator, timer);
+				std::deque<TimerHandle>::iterator sortedIterator = std::upper_bound(m_sortedTimers.begin(), m_sortedTimers.end(), *it, compareTimers);
+				m_sortedTimers.insert(sortedIterator, *it);
 			}
 			it = m_pendingTimers.erase(it);
 		}
@@ -119,24 +87,26 @@ void TimerContainer::updateTimers(lua_State* L)
 		}
 	}
 
-	// update timers
-	for (std::deque<Timer*>::iterator it = m_timers.begin(); it != m_timers.end(); it++)
+	// update timers, the callbacks can add timers (to m_pendingTimers) or stop any timer, so the timer pointers
+	// are fetched again after each callback
+	for (size_t i = 0; i < m_sortedTimers.size(); ++i)
 	{
-		Timer* timer = *it;
+		const TimerHandle timerHandle = m_sortedTimers[i];
+		const Timer* timer = m_timers.get(timerHandle);
 		if (timer != nullptr)
 		{
 			const float timeOut = timer->getTimeOut();
 			if (time >= timeOut)
 			{
-				callTimerEnd(L, timer);
-				if (timer->getLoop())
+				callTimerEnd(L, timerHandle);
+				timer = m_timers.get(timerHandle);
+				if (timer != nullptr && timer->getLoop())
 				{
 					timer->setBeginTime(time);
 				}
 				else
 				{
-					m_timerPool.destroy(timer);
-					*it = nullptr;
+					m_timers.erase(timerHandle);
 				}
 			}
 			else
@@ -145,34 +115,40 @@ void TimerContainer::updateTimers(lua_State* L)
 			}
 		}
 	}
-	std::sort(m_timers.begin(), m_timers.end(), &TimerContainer::compareTimersByTimeout);
+	m_sortedTimers.erase(std::remove_if(m_sortedTimers.begin(), m_sortedTimers.end(), isStopped), m_sortedTimers.end());
+	std::sort(m_sortedTimers.begin(), m_sortedTimers.end(), compareTimers);
 
 	// update frame timers
-	for (std::vector<Timer*>::iterator it = m_frameTimers.begin(); it != m_frameTimers.end();)
+	for (std::vector<TimerHandle>::iterator it = m_frameTimers.begin(); it != m_frameTimers.end();)
 	{
-		Timer* timer = *it;
+		const TimerHandle timerHandle = *it;
+		const Timer* timer = m_timers.get(timerHandle);
 		if (timer != nullptr)
 		{
 			const float timeOut = timer->getTimeOut();
 			if (time >= timeOut)
 			{
 				// update one last time before dying
-				callTimerUpdate(L, timer);
-				if (timer->getLoop())
+				callTimerUpdate(L, timerHandle);
+				timer = m_timers.get(timerHandle);
+				if (timer != nullptr && timer->getLoop())
 				{
 					timer->setBeginTime(time);
 					it++;
 				}
 				else
 				{
-					callTimerEnd(L, timer);
-					m_timerPool.destroy(timer);
+					if (timer != nullptr)
+					{
+						callTimerEnd(L, timerHandle);
+						m_timers.erase(timerHandle);
+					}
 					it = m_frameTimers.erase(it);
 				}
 			}
 			else
 			{
-				callTimerUpdate(L, timer);
+				callTimerUpdate(L, timerHandle);
 				it++;
 			}
 		}
@@ -185,62 +161,61 @@ void TimerContainer::updateTimers(lua_State* L)
 
 void TimerContainer::clearTimers()
 {
-	for (Timer* timer : m_timers)
-	{
-		if (timer != nullptr)
-		{
-			m_timerPool.destroy(timer);
-		}
-	}
 	m_timers.clear();
-
-	for (Timer* timer : m_frameTimers)
-	{
-		if (timer != nullptr)
-		{
-			m_timerPool.destroy(timer);
-		}
-	}
+	m_sortedTimers.clear();
 	m_frameTimers.clear();
-
-	for (Timer* timer : m_pendingTimers)
-	{
-		m_timerPool.destroy(timer);
-	}
 	m_pendingTimers.clear();
 }
 
-bool TimerContainer::compareTimersByTimeout(const Timer* a, const Timer* b)
+bool TimerContainer::compareTimersByTimeout(TimerHandle a, TimerHandle b) const
 {
-	if (b == nullptr)
+	const Timer* timerA = m_timers.get(a);
+	const Timer* timerB = m_timers.get(b);
+	if (timerB == nullptr)
 		return false;
-	if (a == nullptr)
+	if (timerA == nullptr)
 		return true;
-	return a->getTimeOut() < b->getTimeOut();
+	return timerA->getTimeOut() < timerB->getTimeOut();
 }
 
-void TimerContainer::callTimerUpdate(lua_State* L, Timer* timer)
+void TimerContainer::callTimerUpdate(lua_State* L, TimerHandle timerHandle)
 {
 	FLAT_PROFILE("Timer update");
 
 	FLAT_LUA_EXPECT_STACK_GROWTH(L, 0);
-	const flat::lua::SharedLuaReference<LUA_TFUNCTION>& onUpdate = timer->getOnUpdate();
+	const Timer* timer = m_timers.get(timerHandle);
+	FLAT_ASSERT(timer != nullptr);
+	// copied as the callback can move or stop the timer
+	const flat::lua::SharedLuaReference<LUA_TFUNCTION> onUpdate = timer->getOnUpdate();
 	if (!onUpdate.isEmpty())
 	{
 		const float elapsedTime = std::min(timer->getElapsedTime(), timer->getDuration());
-		onUpdate.call(timer, elapsedTime);
+		onUpdate.callFunction(
+			[this, timerHandle, elapsedTime](lua_State* L)
+			{
+				lua::pushTimer(L, this, timerHandle);
+				lua_pushnumber(L, elapsedTime);
+			}
+		);
 	}
 }
 
-void TimerContainer::callTimerEnd(lua_State* L, Timer* timer)
+void TimerContainer::callTimerEnd(lua_State* L, TimerHandle timerHandle)
 {
 	FLAT_PROFILE("Timer end");
 
 	FLAT_LUA_EXPECT_STACK_GROWTH(L, 0);
-	const flat::lua::SharedLuaReference<LUA_TFUNCTION>& onEnd = timer->getOnEnd();
+	const Timer* timer = m_timers.get(timerHandle);
+	FLAT_ASSERT(timer != nullptr);
+	const flat::lua::SharedLuaReference<LUA_TFUNCTION> onEnd = timer->getOnEnd();
 	if (!onEnd.isEmpty())
 	{
-		onEnd.call(timer);
+		onEnd.callFunction(
+			[this, timerHandle](lua_State* L)
+			{
+				lua::pushTimer(L, this, timerHandle);
+			}
+		);
 	}
 }
 
@@ -7,7 +7,7 @@
 
 #include "lua/timer/timer.h"
 
-#include "containers/pool.h"
+#include "containers/slotmap.h"
 #include "time/clock.h"
 #include "debug/assert.h"
 
@@ -22,6 +22,8 @@ namespace lua
 namespace timer
 {
 
+using TimerHandle = containers::SlotMapHandle;
+
 class TimerContainer
 {
 	public:
@@ -33,30 +35,35 @@ class TimerContainer
 
 		void operator=(const TimerContainer&) = delete;
 
+		// started timers, including the frame timers, the ones that have not started yet are not counted
 		size_t getNumTimers() const;
 		size_t getNumFrameTimers() const;
 
 		inline const time::Clock& getClock() const { return *m_clock; }
 		
-		Timer* add();
-		bool stop(Timer* timer);
+		TimerHandle add();
+		// returns false if the timer is already stopped or finished
+		bool stop(TimerHandle timerHandle);
+
+		// nullptr once the timer is stopped or finished, the pointer is invalidated by add and stop
+		inline Timer* getTimer(TimerHandle timerHandle) { return m_timers.get(timerHandle); }
 		
 		void updateTimers(lua_State* L);
 		
 		void clearTimers();
 
-		static void callTimerUpdate(lua_State* L, Timer* timer);
-		static void callTimerEnd(lua_State* L, Timer* timer);
+		void callTimerUpdate(lua_State* L, TimerHandle timerHandle);
+		void callTimerEnd(lua_State* L, TimerHandle timerHandle);
 
 	private:
-		static bool compareTimersByTimeout(const Timer* a, const Timer* b);
-
+		bool compareTimersByTimeout(TimerHandle a, TimerHandle b) const;
 
 	private:
-		containers::Pool<Timer, 256> m_timerPool;
-		std::vector<Timer*> m_pendingTimers;
-		std::deque<Timer*> m_timers;
-		std::vector<Timer*> m_frameTimers;
+		containers::SlotMap<Timer> m_timers;
+		// stopped timers are removed from these lists during the next update
+		std::vector<TimerHandle> m_pendingTimers;
+		std::deque<TimerHandle> m_sortedTimers;
+		std::vector<TimerHandle> m_frameTimers;
 		std::shared_ptr<time::Clock> m_clock;
 };
 
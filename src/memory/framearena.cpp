@@ -0,0 +1,110 @@
+#include <cstdlib>
+#include <cstring>
+#include <cstdint>
+#include <algorithm>
+
+#include "memory/framearena.h"
+#include "memory/memory.h"
+
+#include "debug/assert.h"
+
+namespace flat
+{
+namespace memory
+{
+
+void* FrameArenaResource::do_allocate(size_t size, size_t alignment)
+{
+	return m_frameArena.allocate(size, alignment);
+}
+
+FrameArena::FrameArena(size_t blockSize) :
+	m_currentBlock(nullptr),
+	m_currentOffset(0),
+	m_blockSize(blockSize),
+	m_capacity(0),
+	m_frameStats{},
+	m_previousFrameStats{},
+	m_resource(*this)
+{
+	FLAT_ASSERT(blockSize > 0);
+	addBlock(blockSize);
+	m_frameStats = {};
+}
+
+FrameArena::~FrameArena()
+{
+	freeBlocks();
+}
+
+void* FrameArena::allocate(size_t size, size_t alignment)
+{
+	FLAT_ASSERT(alignment > 0 && (alignment & (alignment - 1)) == 0);
+
+	std::uintptr_t data = reinterpret_cast<std::uintptr_t>(getData(m_currentBlock));
+	std::uintptr_t address = (data + m_currentOffset + alignment - 1) & ~(static_cast<std::uintptr_t>(alignment) - 1);
+	if (address + size > data + m_currentBlock->size)
+	{
+		addBlock(size + alignment);
+		data = reinterpret_cast<std::uintptr_t>(getData(m_currentBlock));
+		address = (data + alignment - 1) & ~(static_cast<std::uintptr_t>(alignment) - 1);
+	}
+	m_currentOffset = address + size - data;
+
+	++m_frameStats.numAllocations;
+	m_frameStats.numAllocatedBytes += size;
+
+	void* pointer = reinterpret_cast<void*>(address);
+	FLAT_INIT_MEMORY(pointer, size);
+	return pointer;
+}
+
+void FrameArena::reset()
+{
+	FLAT_ASSERT(m_currentBlock != nullptr);
+	m_previousFrameStats = m_frameStats;
+	m_frameStats = {};
+
+	if (m_currentBlock->previous != nullptr)
+	{
+		// the frame did not fit in one block, use a single block large enough for the next frames
+		const size_t capacity = m_capacity;
+		freeBlocks();
+		addBlock(capacity);
+	}
+	else
+	{
+		FLAT_WIPE_MEMORY(getData(m_currentBlock), m_currentOffset);
+	}
+	m_currentOffset = 0;
+}
+
+void FrameArena::addBlock(size_t minSize)
+{
+	const size_t size = std::max(minSize, m_blockSize);
+	Block* block = static_cast<Block*>(std::malloc(sizeof(Block) + size));
+	FLAT_ASSERT(block != nullptr);
+	block->previous = m_currentBlock;
+	block->size = size;
+	m_currentBlock = block;
+	m_currentOffset = 0;
+	m_capacity += size;
+	++m_frameStats.numBlockAllocations;
+}
+
+void FrameArena::freeBlocks()
+{
+	while (m_currentBlock != nullptr)
+	{
+		Block* previous = m_currentBlock->previous;
+		FLAT_WIPE_MEMORY(getData(m_currentBlock), m_currentBlock->size);
+		std::free(m_currentBlock);
+		m_currentBlock = previous;
+	}
+	m_capacity = 0;
+}
+
+} // memory
+} // flat
+
+
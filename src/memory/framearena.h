@@ -0,0 +1,111 @@
+#ifndef FLAT_MEMORY_FRAMEARENA_H
+#define FLAT_MEMORY_FRAMEARENA_H
+
+#include <cstddef>
+#include <memory_resource>
+#include <type_traits>
+#include <utility>
+
+namespace flat
+{
+namespace memory
+{
+class FrameArena;
+
+// lets std::pmr containers allocate from a frame arena, deallocation does nothing until the arena is reset
+class FrameArenaResource : public std::pmr::memory_resource
+{
+	public:
+		FrameArenaResource(FrameArena& frameArena) : m_frameArena(frameArena) {}
+
+	private:
+		void* do_allocate(size_t size, size_t alignment) override;
+		void do_deallocate(void* /*pointer*/, size_t /*size*/, size_t /*alignment*/) override {}
+		bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override { return this == &other; }
+
+	private:
+		FrameArena& m_frameArena;
+};
+
+// bump allocator for temporaries that do not outlive the current frame, everything is released at once by reset()
+class FrameArena
+{
+	public:
+		static constexpr size_t DEFAULT_BLOCK_SIZE = 1024 * 1024;
+
+		struct Stats
+		{
+			size_t numAllocations;
+			size_t numAllocatedBytes;
+			size_t numBlockAllocations; // actual heap allocations, only when the current block is full
+		};
+
+	public:
+		FrameArena(size_t blockSize = DEFAULT_BLOCK_SIZE);
+		FrameArena(const FrameArena&) = delete;
+		FrameArena(FrameArena&&) = delete;
+		~FrameArena();
+
+		void operator=(const FrameArena&) = delete;
+
+		void* allocate(size_t size, size_t alignment = alignof(std::max_align_t));
+
+		template <class T>
+		T* allocateArray(size_t count);
+
+		// the destructor is never called
+		template <class T, typename... ConstructorArgs>
+		T* create(ConstructorArgs&&... constructorArgs);
+
+		// invalidates every allocation of the frame
+		void reset();
+
+		inline std::pmr::memory_resource* getResource() { return &m_resource; }
+
+		inline const Stats& getFrameStats() const { return m_frameStats; }
+		inline const Stats& getPreviousFrameStats() const { return m_previousFrameStats; }
+		inline size_t getCapacity() const { return m_capacity; }
+
+	private:
+		struct Block
+		{
+			Block* previous;
+			size_t size;
+		};
+
+		void addBlock(size_t minSize);
+		void freeBlocks();
+
+		static inline unsigned char* getData(Block* block) { return reinterpret_cast<unsigned char*>(block + 1); }
+
+	private:
+		Block* m_currentBlock;
+		size_t m_currentOffset;
+		size_t m_blockSize;
+		size_t m_capacity;
+
+		Stats m_frameStats;
+		Stats m_previousFrameStats;
+
+		FrameArenaResource m_resource;
+};
+
+template <class T>
+T* FrameArena::allocateArray(size_t count)
+{
+	return static_cast<T*>(allocate(sizeof(T) * count, alignof(T)));
+}
+
+template <class T, typename... ConstructorArgs>
+T* FrameArena::create(ConstructorArgs&&... constructorArgs)
+{
+	static_assert(std::is_trivially_destructible<T>::value, "the frame arena does not call destructors");
+	return new (allocate(sizeof(T), alignof(T))) T(std::forward<ConstructorArgs>(constructorArgs)...);
+}
+
+} // memory
+} // flat
+
+#endif // FLAT_MEMORY_FRAMEARENA_H
+
+
@@ -0,0 +1,101 @@
+#ifdef FLAT_MEMORY_TRACKING_ENABLED
+
+#include <lua5.3/lua.hpp>
+
+#include "memory/lua/memory.h"
+#include "memory/memorytracker.h"
+
+#include "lua/debug.h"
+
+namespace flat
+{
+namespace memory
+{
+namespace lua
+{
+
+static MemoryTag checkMemoryTag(lua_State* L, int index)
+{
+	const char* tagName = luaL_checkstring(L, index);
+	MemoryTag tag;
+	if (!getMemoryTagByName(tagName, tag))
+	{
+		luaL_error(L, "Unknown memory tag '%s'", tagName);
+	}
+	return tag;
+}
+
+int open(lua_State* L)
+{
+	FLAT_LUA_EXPECT_STACK_GROWTH(L, 0);
+
+	static const luaL_Reg flat_memory_lib_s[] = {
+		{"getTags",               l_flat_memory_getTags },
+		{"getStats",              l_flat_memory_getStats },
+		{"setBudget",             l_flat_memory_setBudget },
+		{"getNumExceededBudgets", l_flat_memory_getNumExceededBudgets },
+
+		{nullptr, nullptr}
+	};
+
+	lua_getglobal(L, "flat");
+	luaL_newlib(L, flat_memory_lib_s);
+	lua_setfield(L, -2, "memory");
+
+	lua_pop(L, 1);
+
+	return 0;
+}
+
+int l_flat_memory_getTags(lua_State* L)
+{
+	lua_createtable(L, static_cast<int>(MemoryTag::COUNT), 0);
+	for (int i = 0; i < static_cast<int>(MemoryTag::COUNT); ++i)
+	{
+		lua_pushstring(L, getMemoryTagName(static_cast<MemoryTag>(i)));
+		lua_rawseti(L, -2, i + 1);
+	}
+	return 1;
+}
+
+int l_flat_memory_getStats(lua_State* L)
+{
+	const MemoryTracker::Stats stats = MemoryTracker::getStats(checkMemoryTag(L, 1));
+	lua_createtable(L, 0, 6);
+	lua_pushinteger(L, static_cast<lua_Integer>(stats.liveBytes));
+	lua_setfield(L, -2, "liveBytes");
+	lua_pushinteger(L, static_cast<lua_Integer>(stats.peakBytes));
+	lua_setfield(L, -2, "peakBytes");
+	lua_pushinteger(L, static_cast<lua_Integer>(stats.numLiveAllocations));
+	lua_setfield(L, -2, "numLiveAllocations");
+	lua_pushinteger(L, static_cast<lua_Integer>(stats.frameAllocatedBytes));
+	lua_setfield(L, -2, "frameAllocatedBytes");
+	lua_pushinteger(L, static_cast<lua_Integer>(stats.frameNumAllocations));
+	lua_setfield(L, -2, "frameNumAllocations");
+	lua_pushinteger(L, static_cast<lua_Integer>(stats.budget));
+	lua_setfield(L, -2, "budget");
+	return 1;
+}
+
+int l_flat_memory_setBudget(lua_State* L)
+{
+	const MemoryTag tag = checkMemoryTag(L, 1);
+	const lua_Integer budget = luaL_checkinteger(L, 2);
+	luaL_argcheck(L, budget >= 0, 2, "the budget cannot be negative");
+	MemoryTracker::setBudget(tag, static_cast<size_t>(budget));
+	return 0;
+}
+
+int l_flat_memory_getNumExceededBudgets(lua_State* L)
+{
+	lua_pushinteger(L, static_cast<lua_Integer>(MemoryTracker::getNumExceededBudgets()));
+	return 1;
+}
+
+} // lua
+} // memory
+} // flat
+
+#endif // FLAT_MEMORY_TRACKING_ENABLED
+
+
@@ -0,0 +1,30 @@
+#ifndef FLAT_MEMORY_LUA_MEMORY_H
+#define FLAT_MEMORY_LUA_MEMORY_H
+
+#ifdef FLAT_MEMORY_TRACKING_ENABLED
+
+struct lua_State;
+
+namespace flat
+{
+namespace memory
+{
+namespace lua
+{
+
+int open(lua_State* L);
+
+int l_flat_memory_getTags(lua_State* L);
+int l_flat_memory_getStats(lua_State* L);
+int l_flat_memory_setBudget(lua_State* L);
+int l_flat_memory_getNumExceededBudgets(lua_State* L);
+
+} // lua
+} // memory
+} // flat
+
+#endif // FLAT_MEMORY_TRACKING_ENABLED
+
+#endif // FLAT_MEMORY_LUA_MEMORY_H
+
+
@@ -3,6 +3,8 @@
 
 #ifdef FLAT_DEBUG
 
+#include <cstring>
+
 #define FLAT_INIT_VALUE 0x11
 #define FLAT_WIPE_VALUE 0xEE
 
@@ -16,6 +18,8 @@
 
 #endif
 
+#define FLAT_CACHE_LINE_SIZE 64
+
 #define FLAT_DELETE(object)       (delete object, object = nullptr)
 #define FLAT_DELETE_ARRAY(object) (delete[] object, object = nullptr)
 #define FLAT_FREE(object)         free(object); object = nullptr;
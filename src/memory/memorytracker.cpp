@@ -0,0 +1,135 @@
+#include <cstring>
+#include <iostream>
+
+#include "memory/memorytracker.h"
+
+#include "profiler/profiler.h"
+#include "debug/assert.h"
+
+namespace flat
+{
+namespace memory
+{
+
+static const char* memoryTagNames[] = {
+	"render",
+	"ui",
+	"lua",
+	"audio",
+	"resource",
+	"other"
+};
+static_assert(sizeof(memoryTagNames) / sizeof(memoryTagNames[0]) == static_cast<size_t>(MemoryTag::COUNT), "missing tag names");
+
+const char* getMemoryTagName(MemoryTag tag)
+{
+	FLAT_ASSERT(tag < MemoryTag::COUNT);
+	return memoryTagNames[static_cast<size_t>(tag)];
+}
+
+bool getMemoryTagByName(const char* name, MemoryTag& tag)
+{
+	for (size_t i = 0; i < static_cast<size_t>(MemoryTag::COUNT); ++i)
+	{
+		if (std::strcmp(memoryTagNames[i], name) == 0)
+		{
+			tag = static_cast<MemoryTag>(i);
+			return true;
+		}
+	}
+	return false;
+}
+
+#ifdef FLAT_MEMORY_TRACKING_ENABLED
+
+MemoryTracker::TagCounters MemoryTracker::s_counters[static_cast<size_t>(MemoryTag::COUNT)];
+std::atomic<size_t> MemoryTracker::s_numExceededBudgets(0);
+
+void MemoryTracker::allocate(MemoryTag tag, size_t size)
+{
+	TagCounters& counters = getCounters(tag);
+	const size_t liveBytes = counters.liveBytes.fetch_add(size, std::memory_order_relaxed) + size;
+	counters.numLiveAllocations.fetch_add(1, std::memory_order_relaxed);
+	counters.frameAllocatedBytes.fetch_add(size, std::memory_order_relaxed);
+	counters.frameNumAllocations.fetch_add(1, std::memory_order_relaxed);
+
+	size_t peakBytes = counters.peakBytes.load(std::memory_order_relaxed);
+	while (liveBytes > peakBytes && !counters.peakBytes.compare_exchange_weak(peakBytes, liveBytes, std::memory_order_relaxed))
+	{
+	}
+}
+
+void MemoryTracker::free(MemoryTag tag, size_t size)
+{
+	TagCounters& counters = getCounters(tag);
+	FLAT_ASSERT(counters.liveBytes.load(std::memory_order_relaxed) >= size);
+	counters.liveBytes.fetch_sub(size, std::memory_order_relaxed);
+	counters.numLiveAllocations.fetch_sub(1, std::memory_order_relaxed);
+}
+
+void MemoryTracker::setBudget(MemoryTag tag, size_t budget)
+{
+	TagCounters& counters = getCounters(tag);
+	counters.budget = budget;
+	counters.overBudget = false;
+}
+
+bool MemoryTracker::isOverBudget(MemoryTag tag)
+{
+	return getCounters(tag).overBudget;
+}
+
+size_t MemoryTracker::getNumExceededBudgets()
+{
+	return s_numExceededBudgets.load(std::memory_order_relaxed);
+}
+
+MemoryTracker::Stats MemoryTracker::getStats(MemoryTag tag)
+{
+	const TagCounters& counters = getCounters(tag);
+	Stats stats;
+	stats.liveBytes = counters.liveBytes.load(std::memory_order_relaxed);
+	stats.peakBytes = counters.peakBytes.load(std::memory_order_relaxed);
+	stats.numLiveAllocations = counters.numLiveAllocations.load(std::memory_order_relaxed);
+	stats.frameAllocatedBytes = counters.previousFrameAllocatedBytes;
+	stats.frameNumAllocations = counters.previousFrameNumAllocations;
+	stats.budget = counters.budget;
+	return stats;
+}
+
+void MemoryTracker::endFrame()
+{
+	for (size_t i = 0; i < static_cast<size_t>(MemoryTag::COUNT); ++i)
+	{
+		TagCounters& counters = s_counters[i];
+		counters.previousFrameAllocatedBytes = counters.frameAllocatedBytes.exchange(0, std::memory_order_relaxed);
+		counters.previousFrameNumAllocations = counters.frameNumAllocations.exchange(0, std::memory_order_relaxed);
+
+		const size_t liveBytes = counters.liveBytes.load(std::memory_order_relaxed);
+		const bool overBudget = counters.budget > 0 && liveBytes > counters.budget;
+		if (overBudget && !counters.overBudget)
+		{
+			std::cerr << "Memory budget exceeded for " << memoryTagNames[i] << ": "
+				<< liveBytes << " bytes used, " << counters.budget << " allowed" << std::endl;
+			s_numExceededBudgets.fetch_add(1, std::memory_order_relaxed);
+		}
+		counters.overBudget = overBudget;
+	}
+
+#ifdef FLAT_PROFILER_ENABLED
+	profiler::Profiler::getInstance().writeMemoryStats();
+#endif
+}
+
+MemoryTracker::TagCounters& MemoryTracker::getCounters(MemoryTag tag)
+{
+	FLAT_ASSERT(tag < MemoryTag::COUNT);
+	return s_counters[static_cast<size_t>(tag)];
+}
+
+#endif // FLAT_MEMORY_TRACKING_ENABLED
+
+} // memory
+} // flat
+
+
@@ -0,0 +1,156 @@
+#ifndef FLAT_MEMORY_MEMORYTRACKER_H
+#define FLAT_MEMORY_MEMORYTRACKER_H
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+
+namespace flat
+{
+namespace memory
+{
+
+enum class MemoryTag : std::uint8_t
+{
+	RENDER,
+	UI,
+	LUA,
+	AUDIO,
+	RESOURCE,
+	OTHER,
+
+	COUNT
+};
+
+const char* getMemoryTagName(MemoryTag tag);
+// returns false if the name does not match any tag
+bool getMemoryTagByName(const char* name, MemoryTag& tag);
+
+} // memory
+} // flat
+
+#ifdef FLAT_MEMORY_TRACKING_ENABLED
+
+#include <atomic>
+
+namespace flat
+{
+namespace memory
+{
+
+// live and peak bytes per subsystem plus what was allocated during the last frame
+// the counters are atomic so that tracked allocations can happen on any thread
+class MemoryTracker
+{
+	public:
+		struct Stats
+		{
+			size_t liveBytes;
+			size_t peakBytes;
+			size_t numLiveAllocations;
+			size_t frameAllocatedBytes; // during the last complete frame
+			size_t frameNumAllocations;
+			size_t budget; // 0 when there is none
+		};
+
+	public:
+		MemoryTracker() = delete;
+
+		static void allocate(MemoryTag tag, size_t size);
+		static void free(MemoryTag tag, size_t size);
+
+		// a warning is printed once each time the live bytes of the tag go over its budget
+		static void setBudget(MemoryTag tag, size_t budget);
+		static bool isOverBudget(MemoryTag tag);
+		// number of times any budget was exceeded since the start, to make soak tests fail
+		static size_t getNumExceededBudgets();
+
+		static Stats getStats(MemoryTag tag);
+
+		// closes the frame counters, checks the budgets and writes the stats to the profiler output
+		static void endFrame();
+
+	private:
+		struct TagCounters
+		{
+			std::atomic<size_t> liveBytes;
+			std::atomic<size_t> peakBytes;
+			std::atomic<size_t> numLiveAllocations;
+			std::atomic<size_t> frameAllocatedBytes;
+			std::atomic<size_t> frameNumAllocations;
+			size_t previousFrameAllocatedBytes;
+			size_t previousFrameNumAllocations;
+			size_t budget;
+			bool overBudget;
+		};
+
+		static TagCounters& getCounters(MemoryTag tag);
+
+		static TagCounters s_counters[static_cast<size_t>(MemoryTag::COUNT)];
+		static std::atomic<size_t> s_numExceededBudgets;
+};
+
+} // memory
+} // flat
+
+#define FLAT_TRACK_ALLOCATION(tag, size) flat::memory::MemoryTracker::allocate(tag, size)
+#define FLAT_TRACK_FREE(tag, size) flat::memory::MemoryTracker::free(tag, size)
+#define FLAT_TRACK_END_FRAME() flat::memory::MemoryTracker::endFrame()
+
+#else
+
+#define FLAT_TRACK_ALLOCATION(tag, size) {}
+#define FLAT_TRACK_FREE(tag, size) {}
+#define FLAT_TRACK_END_FRAME() {}
+
+#endif // FLAT_MEMORY_TRACKING_ENABLED
+
+namespace flat
+{
+namespace memory
+{
+
+// std allocator reporting to the memory tracker under Tag, same as std::allocator when tracking is disabled
+template <class T, MemoryTag Tag>
+class TaggedAllocator
+{
+	public:
+		using value_type = T;
+
+		template <class U>
+		struct rebind
+		{
+			using other = TaggedAllocator<U, Tag>;
+		};
+
+	public:
+		TaggedAllocator() = default;
+
+		template <class U>
+		TaggedAllocator(const TaggedAllocator<U, Tag>&) {}
+
+		T* allocate(size_t count)
+		{
+			FLAT_TRACK_ALLOCATION(Tag, count * sizeof(T));
+			return std::allocator<T>().allocate(count);
+		}
+
+		void deallocate(T* pointer, size_t count)
+		{
+			FLAT_TRACK_FREE(Tag, count * sizeof(T));
+			std::allocator<T>().deallocate(pointer, count);
+		}
+
+		template <class U>
+		bool operator==(const TaggedAllocator<U, Tag>&) const { return true; }
+
+		template <class U>
+		bool operator!=(const TaggedAllocator<U, Tag>&) const { return false; }
+};
+
+} // memory
+} // flat
+
+#endif // FLAT_MEMORY_MEMORYTRACKER_H
+
+
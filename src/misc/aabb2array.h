@@ -0,0 +1,293 @@
+#ifndef FLAT_MISC_AABB2ARRAY_H
+#define FLAT_MISC_AABB2ARRAY_H
+
+#include <vector>
+#include <limits>
+#include <cstdint>
+
+#if defined(__AVX__)
+#include <immintrin.h>
+#define FLAT_AABB2ARRAY_AVX
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define FLAT_AABB2ARRAY_SSE
+#endif
+
+#include "misc/aabb2.h"
+
+namespace flat
+{
+
+// structure of arrays storage for AABB2, meant to test one AABB or point against many AABBs with SIMD
+// the arrays always have at least LANES entries of padding after the last AABB so that kernels can load
+// whole lanes from any index, lanes past the end of the tested range are masked out
+class AABB2Array
+{
+	public:
+#if defined(FLAT_AABB2ARRAY_AVX)
+		static constexpr size_t LANES = 8;
+#else
+		static constexpr size_t LANES = 4;
+#endif
+
+	public:
+		AABB2Array() : m_size(0) {}
+		~AABB2Array() = default;
+
+		inline size_t getSize() const { return m_size; }
+		inline bool isEmpty() const { return m_size == 0; }
+
+		inline void clear()
+		{
+			m_size = 0;
+			m_minX.clear();
+			m_minY.clear();
+			m_maxX.clear();
+			m_maxY.clear();
+		}
+
+		inline void reserve(size_t size)
+		{
+			const size_t paddedSize = getPaddedSize(size + LANES);
+			m_minX.reserve(paddedSize);
+			m_minY.reserve(paddedSize);
+			m_maxX.reserve(paddedSize);
+			m_maxY.reserve(paddedSize);
+		}
+
+		inline void resize(size_t size)
+		{
+			const size_t paddedSize = getPaddedSize(size + LANES);
+			if (paddedSize > m_minX.size())
+			{
+				constexpr float infinity = std::numeric_limits<float>::infinity();
+				m_minX.resize(paddedSize, infinity);
+				m_minY.resize(paddedSize, infinity);
+				m_maxX.resize(paddedSize, -infinity);
+				m_maxY.resize(paddedSize, -infinity);
+			}
+			m_size = size;
+		}
+
+		inline void add(const AABB2& aabb)
+		{
+			resize(m_size + 1);
+			set(m_size - 1, aabb);
+		}
+
+		inline void set(size_t index, const AABB2& aabb)
+		{
+			FLAT_ASSERT(index < m_size);
+			m_minX[index] = aabb.min.x;
+			m_minY[index] = aabb.min.y;
+			m_maxX[index] = aabb.max.x;
+			m_maxY[index] = aabb.max.y;
+		}
+
+		inline AABB2 get(size_t index) const
+		{
+			FLAT_ASSERT(index < m_size);
+			return AABB2(Vector2(m_minX[index], m_minY[index]), Vector2(m_maxX[index], m_maxY[index]));
+		}
+
+		// calls func(index) for each stored AABB overlapping the given one, in increasing index order
+		template <typename Func>
+		inline void eachOverlap(const AABB2& aabb, Func func) const { eachOverlap(aabb, 0, m_size, func); }
+
+		template <typename Func>
+		void eachOverlap(const AABB2& aabb, size_t begin, size_t end, Func func) const;
+
+		// same as eachOverlap for AABBs sorted by increasing min.x, stops at the first AABB starting after aabb.max.x
+		template <typename Func>
+		inline void eachOverlapSortedByMinX(const AABB2& aabb, size_t begin, Func func) const { eachOverlapSortedByMinX(aabb, begin, m_size, func); }
+
+		template <typename Func>
+		void eachOverlapSortedByMinX(const AABB2& aabb, size_t begin, size_t end, Func func) const;
+
+		// calls func(index) for each stored AABB containing the given point, in increasing index order
+		template <typename Func>
+		inline void eachInside(const Vector2& point, Func func) const { eachInside(point, 0, m_size, func); }
+
+		template <typename Func>
+		void eachInside(const Vector2& point, size_t begin, size_t end, Func func) const;
+
+	private:
+		static inline size_t getPaddedSize(size_t size)
+		{
+			return (size + LANES - 1) / LANES * LANES;
+		}
+
+		static inline std::uint32_t getLaneMask(size_t index, size_t end)
+		{
+			return end - index >= LANES ? (1u << LANES) - 1 : (1u << (end - index)) - 1;
+		}
+
+		template <typename Func>
+		static inline void eachBit(std::uint32_t mask, size_t offset, Func& func)
+		{
+			while (mask != 0)
+			{
+#if defined(__GNUC__)
+				const std::uint32_t bit = static_cast<std::uint32_t>(__builtin_ctz(mask));
+#else
+				std::uint32_t bit = 0;
+				while ((mask & (1u << bit)) == 0)
+				{
+					++bit;
+				}
+#endif
+				mask &= mask - 1;
+				func(offset + bit);
+			}
+		}
+
+	private:
+		std::vector<float> m_minX;
+		std::vector<float> m_minY;
+		std::vector<float> m_maxX;
+		std::vector<float> m_maxY;
+		size_t m_size;
+};
+
+template <typename Func>
+inline void AABB2Array::eachOverlap(const AABB2& aabb, size_t begin, size_t end, Func func) const
+{
+	FLAT_ASSERT(begin <= end && end <= m_size);
+	// same comparisons as AABB2::overlap
+#if defined(FLAT_AABB2ARRAY_AVX)
+	const __m256 minX = _mm256_set1_ps(aabb.min.x);
+	const __m256 minY = _mm256_set1_ps(aabb.min.y);
+	const __m256 maxX = _mm256_set1_ps(aabb.max.x);
+	const __m256 maxY = _mm256_set1_ps(aabb.max.y);
+	for (size_t i = begin; i < end; i += LANES)
+	{
+		__m256 overlap = _mm256_cmp_ps(_mm256_loadu_ps(&m_maxX[i]), minX, _CMP_GT_OQ);
+		overlap = _mm256_and_ps(overlap, _mm256_cmp_ps(_mm256_loadu_ps(&m_minX[i]), maxX, _CMP_LT_OQ));
+		overlap = _mm256_and_ps(overlap, _mm256_cmp_ps(_mm256_loadu_ps(&m_maxY[i]), minY, _CMP_GT_OQ));
+		overlap = _mm256_and_ps(overlap, _mm256_cmp_ps(_mm256_loadu_ps(&m_minY[i]), maxY, _CMP_LT_OQ));
+		eachBit(static_cast<std::uint32_t>(_mm256_movemask_ps(overlap)) & getLaneMask(i, end), i, func);
+	}
+#elif defined(FLAT_AABB2ARRAY_SSE)
+	const __m128 minX = _mm_set1_ps(aabb.min.x);
+	const __m128 minY = _mm_set1_ps(aabb.min.y);
+	const __m128 maxX = _mm_set1_ps(aabb.max.x);
+	const __m128 maxY = _mm_set1_ps(aabb.max.y);
+	for (size_t i = begin; i < end; i += LANES)
+	{
+		__m128 overlap = _mm_cmpgt_ps(_mm_loadu_ps(&m_maxX[i]), minX);
+		overlap = _mm_and_ps(overlap, _mm_cmplt_ps(_mm_loadu_ps(&m_minX[i]), maxX));
+		overlap = _mm_and_ps(overlap, _mm_cmpgt_ps(_mm_loadu_ps(&m_maxY[i]), minY));
+		overlap = _mm_and_ps(overlap, _mm_cmplt_ps(_mm_loadu_ps(&m_minY[i]), maxY));
+		eachBit(static_cast<std::uint32_t>(_mm_movemask_ps(overlap)) & getLaneMask(i, end), i, func);
+	}
+#else
+	for (size_t i = begin; i < end; ++i)
+	{
+		if (m_maxX[i] > aabb.min.x
+			&& m_minX[i] < aabb.max.x
+			&& m_maxY[i] > aabb.min.y
+			&& m_minY[i] < aabb.max.y)
+		{
+			func(i);
+		}
+	}
+#endif
+}
+
+template <typename Func>
+inline void AABB2Array::eachOverlapSortedByMinX(const AABB2& aabb, size_t begin, size_t end, Func func) const
+{
+	FLAT_ASSERT(begin <= end && end <= m_size);
+#if defined(FLAT_AABB2ARRAY_AVX)
+	const __m256 minX = _mm256_set1_ps(aabb.min.x);
+	const __m256 minY = _mm256_set1_ps(aabb.min.y);
+	const __m256 maxX = _mm256_set1_ps(aabb.max.x);
+	const __m256 maxY = _mm256_set1_ps(aabb.max.y);
+	for (size_t i = begin; i < end; i += LANES)
+	{
+		const __m256 startsBefore = _mm256_cmp_ps(_mm256_loadu_ps(&m_minX[i]), maxX, _CMP_LT_OQ);
+		const std::uint32_t startsBeforeMask = static_cast<std::uint32_t>(_mm256_movemask_ps(startsBefore));
+		__m256 overlap = _mm256_and_ps(startsBefore, _mm256_cmp_ps(_mm256_loadu_ps(&m_maxX[i]), minX, _CMP_GT_OQ));
+		overlap = _mm256_and_ps(overlap, _mm256_cmp_ps(_mm256_loadu_ps(&m_maxY[i]), minY, _CMP_GT_OQ));
+		overlap = _mm256_and_ps(overlap, _mm256_cmp_ps(_mm256_loadu_ps(&m_minY[i]), maxY, _CMP_LT_OQ));
+		eachBit(static_cast<std::uint32_t>(_mm256_movemask_ps(overlap)) & getLaneMask(i, end), i, func);
+		if (startsBeforeMask != (1u << LANES) - 1)
+		{
+			break;
+		}
+	}
+#elif defined(FLAT_AABB2ARRAY_SSE)
+	const __m128 minX = _mm_set1_ps(aabb.min.x);
+	const __m128 minY = _mm_set1_ps(aabb.min.y);
+	const __m128 maxX = _mm_set1_ps(aabb.max.x);
+	const __m128 maxY = _mm_set1_ps(aabb.max.y);
+	for (size_t i = begin; i < end; i += LANES)
+	{
+		const __m128 startsBefore = _mm_cmplt_ps(_mm_loadu_ps(&m_minX[i]), maxX);
+		const std::uint32_t startsBeforeMask = static_cast<std::uint32_t>(_mm_movemask_ps(startsBefore));
+		__m128 overlap = _mm_and_ps(startsBefore, _mm_cmpgt_ps(_mm_loadu_ps(&m_maxX[i]), minX));
+		overlap = _mm_and_ps(overlap, _mm_cmpgt_ps(_mm_loadu_ps(&m_maxY[i]), minY));
+		overlap = _mm_and_ps(overlap, _mm_cmplt_ps(_mm_loadu_ps(&m_minY[i]), maxY));
+		eachBit(static_cast<std::uint32_t>(_mm_movemask_ps(overlap)) & getLaneMask(i, end), i, func);
+		if (startsBeforeMask != (1u << LANES) - 1)
+		{
+			break;
+		}
+	}
+#else
+	for (size_t i = begin; i < end && m_minX[i] < aabb.max.x; ++i)
+	{
+		if (m_maxX[i] > aabb.min.x
+			&& m_maxY[i] > aabb.min.y
+			&& m_minY[i] < aabb.max.y)
+		{
+			func(i);
+		}
+	}
+#endif
+}
+
+template <typename Func>
+inline void AABB2Array::eachInside(const Vector2& point, size_t begin, size_t end, Func func) const
+{
+	FLAT_ASSERT(begin <= end && end <= m_size);
+	// same comparisons as AABB2::isInside
+#if defined(FLAT_AABB2ARRAY_AVX)
+	const __m256 x = _mm256_set1_ps(point.x);
+	const __m256 y = _mm256_set1_ps(point.y);
+	for (size_t i = begin; i < end; i += LANES)
+	{
+		__m256 inside = _mm256_cmp_ps(_mm256_loadu_ps(&m_minX[i]), x, _CMP_LE_OQ);
+		inside = _mm256_and_ps(inside, _mm256_cmp_ps(x, _mm256_loadu_ps(&m_maxX[i]), _CMP_LE_OQ));
+		inside = _mm256_and_ps(inside, _mm256_cmp_ps(_mm256_loadu_ps(&m_minY[i]), y, _CMP_LE_OQ));
+		inside = _mm256_and_ps(inside, _mm256_cmp_ps(y, _mm256_loadu_ps(&m_maxY[i]), _CMP_LE_OQ));
+		eachBit(static_cast<std::uint32_t>(_mm256_movemask_ps(inside)) & getLaneMask(i, end), i, func);
+	}
+#elif defined(FLAT_AABB2ARRAY_SSE)
+	const __m128 x = _mm_set1_ps(point.x);
+	const __m128 y = _mm_set1_ps(point.y);
+	for (size_t i = begin; i < end; i += LANES)
+	{
+		__m128 inside = _mm_cmple_ps(_mm_loadu_ps(&m_minX[i]), x);
+		inside = _mm_and_ps(inside, _mm_cmple_ps(x, _mm_loadu_ps(&m_maxX[i])));
+		inside = _mm_and_ps(inside, _mm_cmple_ps(_mm_loadu_ps(&m_minY[i]), y));
+		inside = _mm_and_ps(inside, _mm_cmple_ps(y, _mm_loadu_ps(&m_maxY[i])));
+		eachBit(static_cast<std::uint32_t>(_mm_movemask_ps(inside)) & getLaneMask(i, end), i, func);
+	}
+#else
+	for (size_t i = begin; i < end; ++i)
+	{
+		if (m_minX[i] <= point.x && point.x <= m_maxX[i]
+			&& m_minY[i] <= point.y && point.y <= m_maxY[i])
+		{
+			func(i);
+		}
+	}
+#endif
+}
+
+} // flat
+
+#endif // FLAT_MISC_AABB2ARRAY_H
+
+
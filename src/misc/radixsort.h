@@ -0,0 +1,73 @@
+#ifndef FLAT_MISC_RADIXSORT_H
+#define FLAT_MISC_RADIXSORT_H
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+
+namespace flat
+{
+
+// stable LSD radix sort on a 64 bit key, 8 bits per pass, getKey(item) returns the key of an item
+// passes where all the keys have the same byte are skipped, so keys using only a few bits sort in a few passes
+// buffer must hold numItems items, the result ends up in items
+template <class T, class GetKey>
+void radixSort(T* items, T* buffer, size_t numItems, GetKey getKey)
+{
+	constexpr int NUM_PASSES = 8;
+	constexpr int NUM_BUCKETS = 256;
+
+	// all the histograms in a single read of the keys
+	std::array<std::array<size_t, NUM_BUCKETS>, NUM_PASSES> histograms = {};
+	for (size_t i = 0; i < numItems; ++i)
+	{
+		const std::uint64_t key = getKey(items[i]);
+		for (int pass = 0; pass < NUM_PASSES; ++pass)
+		{
+			++histograms[pass][(key >> (pass * 8)) & 0xFF];
+		}
+	}
+
+	T* source = items;
+	T* destination = buffer;
+	for (int pass = 0; pass < NUM_PASSES; ++pass)
+	{
+		std::array<size_t, NUM_BUCKETS>& histogram = histograms[pass];
+		const int shift = pass * 8;
+		if (numItems == 0 || histogram[(getKey(source[0]) >> shift) & 0xFF] == numItems)
+		{
+			continue;
+		}
+
+		// histogram to bucket offsets
+		size_t offset = 0;
+		for (size_t& count : histogram)
+		{
+			const size_t bucketSize = count;
+			count = offset;
+			offset += bucketSize;
+		}
+
+		for (size_t i = 0; i < numItems; ++i)
+		{
+			const size_t bucket = (getKey(source[i]) >> shift) & 0xFF;
+			destination[histogram[bucket]++] = std::move(source[i]);
+		}
+		std::swap(source, destination);
+	}
+
+	if (source != items)
+	{
+		for (size_t i = 0; i < numItems; ++i)
+		{
+			items[i] = std::move(source[i]);
+		}
+	}
+}
+
+} // flat
+
+#endif // FLAT_MISC_RADIXSORT_H
+
+
@@ -2,6 +2,8 @@
 
 #include "profiler/binarywriter.h"
 
+#include "memory/memorytracker.h"
+
 #include "debug/assert.h"
 
 namespace flat
@@ -43,6 +45,34 @@ BinaryWriter::SectionId BinaryWriter::getSectionId(const char* name)
 	}
 }
 
+void BinaryWriter::writeMemoryStats(Profiler::TimePoint time)
+{
+#ifdef FLAT_MEMORY_TRACKING_ENABLED
+	// the tag names are written with the section names
+	write(Code::MEMORY_STATS);
+	write(time);
+	write(static_cast<std::uint8_t>(memory::MemoryTag::COUNT));
+	for (std::uint8_t i = 0; i < static_cast<std::uint8_t>(memory::MemoryTag::COUNT); ++i)
+	{
+		const memory::MemoryTag tag = static_cast<memory::MemoryTag>(i);
+		const memory::MemoryTracker::Stats stats = memory::MemoryTracker::getStats(tag);
+		write(getSectionId(memory::getMemoryTagName(tag)));
+		write(static_cast<std::uint64_t>(stats.liveBytes));
+		write(static_cast<std::uint64_t>(stats.frameAllocatedBytes));
+		write(static_cast<std::uint64_t>(stats.frameNumAllocations));
+	}
+#endif
+}
+
+void BinaryWriter::writeCounter(const char* name, Profiler::TimePoint time, std::int64_t value)
+{
+	// the counter names are written with the section names
+	write(Code::COUNTER);
+	write(getSectionId(name));
+	write(time);
+	write(value);
+}
+
 void BinaryWriter::writeSectionNames()
 {
 	std::vector<const char*> sectionNames(m_sectionIdsByName.size());
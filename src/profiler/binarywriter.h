@@ -21,7 +21,9 @@ class BinaryWriter
 	{
 		PUSH_SECTION,
 		POP_SECTION,
-		SECTION_NAMES
+		SECTION_NAMES,
+		MEMORY_STATS,
+		COUNTER
 	};
 
 	public:
@@ -39,6 +41,10 @@ class BinaryWriter
 
 		void writeSectionNames();
 
+		void writeMemoryStats(Profiler::TimePoint time);
+
+		void writeCounter(const char* name, Profiler::TimePoint time, std::int64_t value);
+
 	private:
 		SectionId getSectionId(const char* name);
 
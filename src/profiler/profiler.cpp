@@ -58,6 +58,22 @@ void Profiler::saveSectionName(const std::shared_ptr<std::string>& sectionName)
 	m_savedSectionNames.push_back(sectionName);
 }
 
+void Profiler::writeMemoryStats()
+{
+	if (m_binaryWriter != nullptr && m_shouldWrite)
+	{
+		m_binaryWriter->writeMemoryStats(getCurrentTime());
+	}
+}
+
+void Profiler::writeCounter(const char* counterName, std::int64_t value)
+{
+	if (m_binaryWriter != nullptr && m_shouldWrite)
+	{
+		m_binaryWriter->writeCounter(counterName, getCurrentTime(), value);
+	}
+}
+
 void Profiler::popStartedSections()
 {
 	FLAT_ASSERT(m_binaryWriter != nullptr);
@@ -6,6 +6,7 @@
 #include <chrono>
 #include <string>
 #include <vector>
+#include <cstdint>
 
 #include "util/singleton.h"
 
@@ -42,6 +43,12 @@ class Profiler : public flat::util::Singleton<Profiler>
 
 		void saveSectionName(const std::shared_ptr<std::string>& sectionName);
 
+		// memory tracker counters of each tag, once per frame
+		void writeMemoryStats();
+
+		// value of a named counter at the current time, the name must outlive the recording like section names
+		void writeCounter(const char* counterName, std::int64_t value);
+
 	private:
 		void popStartedSections();
 
@@ -60,6 +67,7 @@ class Profiler : public flat::util::Singleton<Profiler>
 #define FLAT_DEINIT_PROFILER() flat::profiler::Profiler::destroyInstance()
 #define FLAT_PROFILE(sectionName) flat::profiler::ProfilerSection profilerSection(sectionName)
 #define FLAT_PROFILE_RESOURCE_LOADING(resourceName, durationForWarning) flat::profiler::ResourceProfilerSection resourceProfilerSection(resourceName, durationForWarning)
+#define FLAT_PROFILE_COUNTER(counterName, value) flat::profiler::Profiler::getInstance().writeCounter(counterName, value)
 
 #else
 
@@ -67,6 +75,7 @@ class Profiler : public flat::util::Singleton<Profiler>
 #define FLAT_DEINIT_PROFILER() {}
 #define FLAT_PROFILE(sectionName) {}
 #define FLAT_PROFILE_RESOURCE_LOADING(resourceName, durationForWarning) {}
+#define FLAT_PROFILE_COUNTER(counterName, value) {}
 
 #endif // FLAT_PROFILER_ENABLED
 
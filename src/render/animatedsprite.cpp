@@ -20,6 +20,18 @@ AnimatedSprite::~AnimatedSprite()
 	
 }
 
+void AnimatedSprite::setTexture(const std::shared_ptr<const video::Texture>& texture)
+{
+	Sprite::setTexture(texture);
+	SpriteAnimator::setAtlasRegion(nullptr);
+}
+
+void AnimatedSprite::setAtlasRegion(const std::shared_ptr<const video::Atlas>& atlas, const video::AtlasRegion& region)
+{
+	Sprite::setAtlasRegion(atlas, region);
+	SpriteAnimator::setAtlasRegion(&region);
+}
+
 const BaseSprite::VertexUvs& AnimatedSprite::getVertexUvs() const
 {
 	return m_vertexUvs;
@@ -17,6 +17,12 @@ class AnimatedSprite : public Sprite, public SpriteAnimator
 		AnimatedSprite();
 		~AnimatedSprite() override;
 
+		// the animation tiles are laid out in the whole texture again
+		void setTexture(const std::shared_ptr<const video::Texture>& texture); // not virtual!
+
+		// the animation tiles are laid out in the region instead of the whole texture
+		void setAtlasRegion(const std::shared_ptr<const video::Atlas>& atlas, const video::AtlasRegion& region); // not virtual!
+
 	protected:
 		const VertexUvs& getVertexUvs() const override;
 		VertexUvs& getVertexUvs() override;
@@ -1,3 +1,5 @@
+#include <cmath>
+
 #include "render/basesprite.h"
 #include "render/rendersettings.h"
 
@@ -68,6 +70,11 @@ void BaseSprite::updateModelMatrix() const
 	if (m_modelMatrixIsDirty)
 	{
 		m_modelMatrixIsDirty = false;
+		if (m_rotation.x == 0.f && m_rotation.y == 0.f)
+		{
+			update2dModelMatrix();
+			return;
+		}
 		m_modelMatrix = Matrix4();
 		translateBy(m_modelMatrix, Vector3(m_position, 0.f));
 		rotateBy(m_modelMatrix, m_rotation);
@@ -79,6 +86,22 @@ void BaseSprite::updateModelMatrix() const
 	}
 }
 
+void BaseSprite::update2dModelMatrix() const
+{
+	// same matrix as the general case without the 4x4 products:
+	// translate(position) * rotateZ(rotation.z) * scale(scale * flip) * translate(-origin)
+	const float cosZ = std::cos(m_rotation.z);
+	const float sinZ = std::sin(m_rotation.z);
+	const float scaleX = m_flipX ? -m_scale.x : m_scale.x;
+	const float scaleY = m_flipY ? -m_scale.y : m_scale.y;
+	const Vector2 xAxis(cosZ * scaleX, sinZ * scaleX);
+	const Vector2 yAxis(-sinZ * scaleY, cosZ * scaleY);
+	m_modelMatrix[0] = Vector4(xAxis, 0.f, 0.f);
+	m_modelMatrix[1] = Vector4(yAxis, 0.f, 0.f);
+	m_modelMatrix[2] = Vector4(0.f, 0.f, 1.f, 0.f);
+	m_modelMatrix[3] = Vector4(m_position - xAxis * m_origin.x - yAxis * m_origin.y, 0.f, 1.f);
+}
+
 void BaseSprite::setModelMatrix(const Matrix4& modelMatrix)
 {
 	// TODO: do better than this
@@ -92,14 +115,16 @@ void BaseSprite::setModelMatrix(const Matrix4& modelMatrix)
 void BaseSprite::getAABB(AABB2& aabb) const
 {
 	const Matrix4& aMatrix = getModelMatrix();
-	// TODO: wrong for rotated sprites
-	aabb.min = Vector2(aMatrix * Vector4(getVertexPositions()[0], 0.f, 1.f));
-	aabb.max = Vector2(aMatrix * Vector4(getVertexPositions()[3], 0.f, 1.f));
-
-	if (aabb.min.x > aabb.max.x)
-		std::swap(aabb.min.x, aabb.max.x);
-	if (aabb.min.y > aabb.max.y)
-		std::swap(aabb.min.y, aabb.max.y);
+	// the 4 corners of the quad so that rotated sprites are fully inside
+	const VertexPositions& vertexPositions = getVertexPositions();
+	aabb.min = Vector2(aMatrix * Vector4(vertexPositions[0], 0.f, 1.f));
+	aabb.max = aabb.min;
+	for (int i = 1; i < 4; ++i)
+	{
+		const Vector2 corner(aMatrix * Vector4(vertexPositions[i], 0.f, 1.f));
+		aabb.min = glm::min(aabb.min, corner);
+		aabb.max = glm::max(aabb.max, corner);
+	}
 
 	FLAT_ASSERT(aabb.isValid());
 }
@@ -76,6 +76,7 @@ class BaseSprite
 		
 		void updateModelMatrix() const;
 		inline const Matrix4& getModelMatrix() const { updateModelMatrix(); return m_modelMatrix; }
+		inline bool isModelMatrixDirty() const { return m_modelMatrixIsDirty; }
 
 		void setModelMatrix(const Matrix4& modelMatrix);
 
@@ -85,6 +86,10 @@ class BaseSprite
 
 		bool requiresAlphaBlending() const;
 		
+	protected:
+		// no rotation around x or y
+		void update2dModelMatrix() const;
+
 	protected:
 		static constexpr int NUM_VERTICES = 6;
 		using VertexPositions = std::array<Vector2, NUM_VERTICES>;
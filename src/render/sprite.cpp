@@ -1,6 +1,7 @@
 #include "render/sprite.h"
 
 #include "video/filetexture.h"
+#include "video/atlas.h"
 #include "misc/aabb2.h"
 
 namespace flat
@@ -17,7 +18,8 @@ BaseSprite::VertexUvs Sprite::vertexUvs = {
 	Vector2(1.f, 0.f)
 };
 
-Sprite::Sprite() : BaseSprite()
+Sprite::Sprite() : BaseSprite(),
+	m_vertexUvs(&vertexUvs)
 {
 	// pos
 	m_vertexPositions[0].x = 0.f;
@@ -47,14 +49,27 @@ Sprite::~Sprite()
 void Sprite::setTexture(const std::shared_ptr<const video::Texture>& texture)
 {
 	BaseSprite::setTexture(texture);
+	setSize(m_texture->getSize());
+	m_vertexUvs = &vertexUvs;
+}
+
+void Sprite::setAtlasRegion(const std::shared_ptr<const video::Atlas>& atlas, const video::AtlasRegion& region)
+{
+	FLAT_ASSERT_MSG(atlas != nullptr && atlas->getRegion(region.fileName) == &region, "The region must belong to the atlas");
+	BaseSprite::setTexture(atlas);
+	m_origin = region.size / 2.f;
+	setSize(region.size);
+	m_vertexUvs = &region.vertexUvs;
+}
 
-	const Vector2& textureSize = m_texture->getSize();
-	m_vertexPositions[1].x = textureSize.x;
-	m_vertexPositions[2].y = textureSize.y;
-	m_vertexPositions[3].x = textureSize.x;
-	m_vertexPositions[3].y = textureSize.y;
-	m_vertexPositions[4].y = textureSize.y;
-	m_vertexPositions[5].x = textureSize.x;
+void Sprite::setSize(const Vector2& size)
+{
+	m_vertexPositions[1].x = size.x;
+	m_vertexPositions[2].y = size.y;
+	m_vertexPositions[3].x = size.x;
+	m_vertexPositions[3].y = size.y;
+	m_vertexPositions[4].y = size.y;
+	m_vertexPositions[5].x = size.x;
 }
 
 const BaseSprite::VertexPositions& Sprite::getVertexPositions() const
@@ -69,7 +84,7 @@ BaseSprite::VertexPositions& Sprite::getVertexPositions()
 
 const BaseSprite::VertexUvs& Sprite::getVertexUvs() const
 {
-	return vertexUvs;
+	return *m_vertexUvs;
 }
 
 BaseSprite::VertexUvs& Sprite::getVertexUvs()
@@ -5,6 +5,11 @@
 
 namespace flat
 {
+namespace video
+{
+class Atlas;
+struct AtlasRegion;
+}
 namespace render
 {
 
@@ -16,14 +21,22 @@ class Sprite : public BaseSprite
 
 		void setTexture(const std::shared_ptr<const video::Texture>& texture); // not virtual!
 
+		// only shows the given region of the atlas, the sprite has the size of the region
+		void setAtlasRegion(const std::shared_ptr<const video::Atlas>& atlas, const video::AtlasRegion& region); // not virtual!
+
 	protected:
 		const VertexPositions& getVertexPositions() const override;
 		VertexPositions& getVertexPositions() override;
 		const VertexUvs& getVertexUvs() const override;
 		VertexUvs& getVertexUvs() override;
 
+	private:
+		void setSize(const Vector2& size);
+
 	private:
 		VertexPositions m_vertexPositions;
+		// the whole texture or the uvs of an atlas region, kept alive by the atlas
+		const VertexUvs* m_vertexUvs;
 		static VertexUvs vertexUvs;
 };
 
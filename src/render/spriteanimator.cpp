@@ -6,6 +6,7 @@
 
 #include "misc/aabb2.h"
 #include "video/filetexture.h"
+#include "video/atlas.h"
 
 namespace flat
 {
@@ -14,6 +15,7 @@ namespace render
 
 SpriteAnimator::SpriteAnimator(BaseSprite* sprite) :
 	m_sprite(sprite),
+	m_atlasRegion(nullptr),
 	m_tileSizeRatio(1.f, 1.f),
 	m_currentLine(0),
 	m_currentColumn(0),
@@ -35,7 +37,7 @@ void SpriteAnimator::setAtlasSize(int atlasWidth, int atlasHeight)
 {
 	const flat::video::Texture* texture = m_sprite->getTexture().get();
 	FLAT_ASSERT(texture != nullptr);
-	const flat::Vector2& textureSize = texture->getSize();
+	const flat::Vector2& textureSize = m_atlasRegion != nullptr ? m_atlasRegion->size : texture->getSize();
 	FLAT_ASSERT(0 < atlasWidth  && atlasWidth  < textureSize.x);
 	FLAT_ASSERT(0 < atlasHeight && atlasHeight < textureSize.y);
 	if (textureSize.x / atlasWidth != floor(textureSize.x / atlasWidth)
@@ -63,6 +65,13 @@ void SpriteAnimator::setAtlasSize(int atlasWidth, int atlasHeight)
 	vertexPositions[5].x = atlasTileWidth;
 }
 
+void SpriteAnimator::setAtlasRegion(const video::AtlasRegion* atlasRegion)
+{
+	m_atlasRegion = atlasRegion;
+	setLine(m_currentLine);
+	setColumn(m_currentColumn);
+}
+
 void SpriteAnimator::setAnimated(bool animated)
 {
 	if (!m_animated && animated)
@@ -78,8 +87,10 @@ void SpriteAnimator::setLine(int line)
 	m_currentLine = line;
 	
 	// update uv
-	float uvy0 = m_tileSizeRatio.y * line;
-	float uvy1 = m_tileSizeRatio.y * (line + 1);
+	const Vector2 uvMin = getUvMin();
+	const Vector2 uvSize = getUvSize();
+	float uvy0 = uvMin.y + uvSize.y * m_tileSizeRatio.y * line;
+	float uvy1 = uvMin.y + uvSize.y * m_tileSizeRatio.y * (line + 1);
 	
 	BaseSprite::VertexUvs& vertexUvs = m_sprite->getVertexUvs();
 	vertexUvs[0].y = uvy0;
@@ -96,8 +107,10 @@ void SpriteAnimator::setColumn(int column)
 	m_currentColumn = column;
 	
 	// update uv
-	float uvx0 = m_tileSizeRatio.x * column;
-	float uvx1 = m_tileSizeRatio.x * (column + 1);
+	const Vector2 uvMin = getUvMin();
+	const Vector2 uvSize = getUvSize();
+	float uvx0 = uvMin.x + uvSize.x * m_tileSizeRatio.x * column;
+	float uvx1 = uvMin.x + uvSize.x * m_tileSizeRatio.x * (column + 1);
 	
 	BaseSprite::VertexUvs& vertexUvs = m_sprite->getVertexUvs();
 	vertexUvs[0].x = uvx0;
@@ -166,6 +179,16 @@ int SpriteAnimator::getAtlasHeight() const
 	return static_cast<int>(std::round(1.f / m_tileSizeRatio.y));
 }
 
+Vector2 SpriteAnimator::getUvMin() const
+{
+	return m_atlasRegion != nullptr ? m_atlasRegion->uvMin : Vector2(0.f, 0.f);
+}
+
+Vector2 SpriteAnimator::getUvSize() const
+{
+	return m_atlasRegion != nullptr ? m_atlasRegion->uvMax - m_atlasRegion->uvMin : Vector2(1.f, 1.f);
+}
+
 } // render
 } // flat
 
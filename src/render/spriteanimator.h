@@ -5,6 +5,10 @@
 
 namespace flat
 {
+namespace video
+{
+struct AtlasRegion;
+}
 namespace render
 {
 class BaseSprite;
@@ -23,6 +27,10 @@ class SpriteAnimator
 		~SpriteAnimator();
 		
 		void setAtlasSize(int atlasWidth, int atlasHeight);
+
+		// the tiles are laid out in a region of the texture instead of the whole texture, nullptr for the whole texture
+		// the region must belong to the texture of the sprite
+		void setAtlasRegion(const video::AtlasRegion* atlasRegion);
 		
 		void setAnimated(bool animated);
 		inline bool isAnimated() const { return m_animated; }
@@ -50,8 +58,12 @@ class SpriteAnimator
 		int getAtlasWidth() const;
 		int getAtlasHeight() const;
 
+		Vector2 getUvMin() const;
+		Vector2 getUvSize() const;
+
 	private:
 		BaseSprite* m_sprite;
+		const video::AtlasRegion* m_atlasRegion;
 		
 		flat::Vector2 m_tileSizeRatio;
 		
@@ -1,28 +1,237 @@
+#include <cstring>
+#include <cstddef>
+#include <algorithm>
+#include <execution>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define FLAT_SPRITEBATCH_SSE
+#endif
+
 #include "render/spritebatch.h"
 #include "render/basesprite.h"
 #include "render/rendersettings.h"
 
+#include "profiler/profiler.h"
+
 namespace flat
 {
 namespace render
 {
 
-SpriteBatch::SpriteBatch() :
-	m_numVertices(0),
-	m_texture(nullptr)
+namespace
+{
+inline std::uint16_t packUnorm16(float value)
+{
+	FLAT_ASSERT_MSG(0.f <= value && value <= 1.f, "Compact sprite batches require uvs in [0, 1]");
+	return static_cast<std::uint16_t>(std::clamp(value, 0.f, 1.f) * 65535.f + 0.5f);
+}
+
+inline std::uint8_t packUnorm8(float value)
+{
+	return static_cast<std::uint8_t>(std::clamp(value, 0.f, 1.f) * 255.f + 0.5f);
+}
+
+inline std::uint32_t packSnorm10(float value)
+{
+	const float scaled = std::clamp(value, -1.f, 1.f) * 511.f;
+	const std::int32_t rounded = static_cast<std::int32_t>(scaled < 0.f ? scaled - 0.5f : scaled + 0.5f);
+	return static_cast<std::uint32_t>(rounded) & 0x3FF;
+}
+
+// GL_INT_2_10_10_10_REV: x in the lowest bits, w = 0
+inline std::uint32_t packNormal(const Vector3& normal)
+{
+	return packSnorm10(normal.x) | (packSnorm10(normal.y) << 10) | (packSnorm10(normal.z) << 20);
+}
+
+// below this, the threads cost more than they save
+constexpr size_t MIN_PARALLEL_SPRITES = 512;
+constexpr size_t SPRITES_PER_CHUNK = 4096;
+
+template <class Func>
+inline void forEachSprite(const BaseSprite* const* sprites, size_t numSprites, Func func)
+{
+	if (numSprites < MIN_PARALLEL_SPRITES)
+	{
+		std::for_each(sprites, sprites + numSprites, func);
+	}
+	else
+	{
+		std::for_each(std::execution::par, sprites, sprites + numSprites, func);
+	}
+}
+
+// the sprite vertices have z = 0 and w = 1 and only x and y are kept,
+// so only the 2d affine part of the model matrix is needed
+inline Vector2 transformPosition(const Matrix4& transform, const Vector2& position)
+{
+	return Vector2(
+		transform[0].x * position.x + transform[1].x * position.y + transform[3].x,
+		transform[0].y * position.x + transform[1].y * position.y + transform[3].y
+	);
+}
+
+// the 4 corners of the quad at once
+inline void transformQuad(const Matrix4& transform, const Vector2* corners, Vector2* positions)
 {
+#if defined(FLAT_SPRITEBATCH_SSE)
+	static_assert(sizeof(Vector2) == 2 * sizeof(float), "Vector2 must be 2 packed floats");
+	const __m128 corners01 = _mm_loadu_ps(&corners[0].x);
+	const __m128 corners23 = _mm_loadu_ps(&corners[2].x);
+	const __m128 x = _mm_shuffle_ps(corners01, corners23, _MM_SHUFFLE(2, 0, 2, 0));
+	const __m128 y = _mm_shuffle_ps(corners01, corners23, _MM_SHUFFLE(3, 1, 3, 1));
+	const __m128 transformedX = _mm_add_ps(
+		_mm_add_ps(_mm_mul_ps(x, _mm_set1_ps(transform[0].x)), _mm_mul_ps(y, _mm_set1_ps(transform[1].x))),
+		_mm_set1_ps(transform[3].x)
+	);
+	const __m128 transformedY = _mm_add_ps(
+		_mm_add_ps(_mm_mul_ps(x, _mm_set1_ps(transform[0].y)), _mm_mul_ps(y, _mm_set1_ps(transform[1].y))),
+		_mm_set1_ps(transform[3].y)
+	);
+	_mm_storeu_ps(&positions[0].x, _mm_unpacklo_ps(transformedX, transformedY));
+	_mm_storeu_ps(&positions[2].x, _mm_unpackhi_ps(transformedX, transformedY));
+#else
+	for (int i = 0; i < SpriteBatch::NUM_QUAD_VERTICES; ++i)
+	{
+		positions[i] = transformPosition(transform, corners[i]);
+	}
+#endif
+}
+}
 
+GLuint SpriteBatch::quadIndexBufferId = 0;
+size_t SpriteBatch::numIndexedQuads = 0;
+
+SpriteBatch::SpriteBatch(VertexFormat vertexFormat, size_t numSprites) :
+	m_numSprites(0),
+	m_texture(nullptr),
+	m_vertexBuffer(GL_ARRAY_BUFFER),
+	m_vertexFormat(vertexFormat)
+{
+	reserve(numSprites);
+}
+
+void SpriteBatch::reserve(size_t numSprites)
+{
+	if (m_vertexFormat == VertexFormat::COMPACT)
+	{
+		m_compactVertices.reserve(numSprites * NUM_QUAD_VERTICES);
+	}
+	else
+	{
+		m_vertices.reserve(numSprites * BaseSprite::NUM_VERTICES);
+	}
 }
 
 void SpriteBatch::clear()
 {
-	m_numVertices = 0;
+	m_vertices.clear();
+	m_compactVertices.clear();
+	m_numSprites = 0;
 	m_texture = nullptr;
 }
 
 void SpriteBatch::add(const BaseSprite& sprite)
 {
-	if (m_numVertices == 0)
+	setTexture(sprite);
+
+	if (m_vertexFormat == VertexFormat::COMPACT)
+	{
+		const size_t firstVertex = m_compactVertices.size();
+		m_compactVertices.resize(firstVertex + NUM_QUAD_VERTICES);
+		writeCompactVertices(sprite, &m_compactVertices[firstVertex]);
+	}
+	else
+	{
+		const size_t firstVertex = m_vertices.size();
+		m_vertices.resize(firstVertex + BaseSprite::NUM_VERTICES);
+		writeFullVertices(sprite, &m_vertices[firstVertex]);
+	}
+	++m_numSprites;
+}
+
+void SpriteBatch::add(const BaseSprite* const* sprites, size_t numSprites)
+{
+	if (numSprites == 0)
+	{
+		return;
+	}
+
+	FLAT_PROFILE("Sprite batch add");
+
+	setTexture(*sprites[0]);
+#ifdef FLAT_DEBUG
+	for (size_t i = 1; i < numSprites; ++i)
+	{
+		FLAT_ASSERT(m_texture == sprites[i]->getTexture().get());
+	}
+#endif
+
+	// the storage grows by chunks small enough to still be in cache when the vertices are written,
+	// each sprite of a chunk writing its own range of vertices
+	for (size_t chunkBegin = 0; chunkBegin < numSprites; chunkBegin += SPRITES_PER_CHUNK)
+	{
+		const size_t chunkSize = std::min(numSprites - chunkBegin, SPRITES_PER_CHUNK);
+		const BaseSprite* const* chunkSprites = sprites + chunkBegin;
+		const size_t firstSprite = m_numSprites;
+		m_numSprites += chunkSize;
+		if (m_vertexFormat == VertexFormat::COMPACT)
+		{
+			m_compactVertices.resize(m_numSprites * NUM_QUAD_VERTICES);
+			CompactVertex* vertices = m_compactVertices.data() + firstSprite * NUM_QUAD_VERTICES;
+			forEachSprite(chunkSprites, chunkSize, [chunkSprites, vertices](const BaseSprite* const& sprite)
+			{
+				writeCompactVertices(*sprite, vertices + (&sprite - chunkSprites) * NUM_QUAD_VERTICES);
+			});
+		}
+		else
+		{
+			m_vertices.resize(m_numSprites * BaseSprite::NUM_VERTICES);
+			Vertex* vertices = m_vertices.data() + firstSprite * BaseSprite::NUM_VERTICES;
+			forEachSprite(chunkSprites, chunkSize, [chunkSprites, vertices](const BaseSprite* const& sprite)
+			{
+				writeFullVertices(*sprite, vertices + (&sprite - chunkSprites) * BaseSprite::NUM_VERTICES);
+			});
+		}
+	}
+}
+
+void SpriteBatch::draw(const RenderSettings& renderSettings, const Matrix4& viewMatrix) const
+{
+	if (m_numSprites == 0)
+	{
+		return;
+	}
+
+	FLAT_ASSERT(m_texture != nullptr);
+	renderSettings.textureUniform.set(m_texture);
+
+	if (m_vertexFormat == VertexFormat::COMPACT)
+	{
+		drawCompact(renderSettings);
+	}
+	else
+	{
+		drawFull(renderSettings);
+	}
+
+	// other draws use client side arrays
+	glBindBuffer(GL_ARRAY_BUFFER, 0);
+}
+
+size_t SpriteBatch::getSpriteSize() const
+{
+	if (m_vertexFormat == VertexFormat::COMPACT)
+	{
+		return sizeof(CompactVertex) * NUM_QUAD_VERTICES;
+	}
+	return sizeof(Vertex) * BaseSprite::NUM_VERTICES;
+}
+
+void SpriteBatch::setTexture(const BaseSprite& sprite)
+{
+	if (m_numSprites == 0)
 	{
 		FLAT_ASSERT(m_texture == nullptr);
 		m_texture = sprite.getTexture().get();
@@ -30,30 +239,30 @@ void SpriteBatch::add(const BaseSprite& sprite)
 #ifdef FLAT_DEBUG
 	else
 	{
-		FLAT_ASSERT(m_numVertices > 0 && static_cast<size_t>(m_numVertices) + BaseSprite::NUM_VERTICES < m_vertices.size());
 		FLAT_ASSERT(m_texture == sprite.getTexture().get());
 	}
 #endif
 	FLAT_ASSERT(m_texture != nullptr);
+}
 
+void SpriteBatch::writeFullVertices(const BaseSprite& sprite, Vertex* vertices)
+{
 	const Matrix4& transform = sprite.getModelMatrix();
 	const video::Color& color = sprite.getColor();
 	const Vector3& normal = sprite.getNormal();
 	const float depth = sprite.getDepth();
 	const BaseSprite::VertexPositions& vertexPositions = sprite.getVertexPositions();
 	const BaseSprite::VertexUvs& vertexUvs = sprite.getVertexUvs();
-	Vector4 pos2d(0.f, 0.f, 0.f, 1.f);
-	Vector4 pos(0.f, 0.f, 0.f, 1.f);
+	Vector2 positions[BaseSprite::NUM_VERTICES];
+	transformQuad(transform, &vertexPositions[0], positions);
+	for (int i = NUM_QUAD_VERTICES; i < BaseSprite::NUM_VERTICES; ++i)
+	{
+		positions[i] = transformPosition(transform, vertexPositions[i]);
+	}
 	for (int i = 0; i < BaseSprite::NUM_VERTICES; ++i)
 	{
-		FLAT_ASSERT(m_numVertices + 1 > 0);
-		SpriteBatch::Vertex& spriteBatchVertex = m_vertices[m_numVertices++];
-		FLAT_ASSERT(m_numVertices > 0);
-		pos2d.x = vertexPositions[i].x;
-		pos2d.y = vertexPositions[i].y;
-		pos = transform * pos2d;
-		spriteBatchVertex.pos.x = pos.x;
-		spriteBatchVertex.pos.y = pos.y;
+		SpriteBatch::Vertex& spriteBatchVertex = vertices[i];
+		spriteBatchVertex.pos = positions[i];
 		spriteBatchVertex.uv = vertexUvs[i];
 		spriteBatchVertex.color = color;
 		spriteBatchVertex.normal = normal;
@@ -61,10 +270,38 @@ void SpriteBatch::add(const BaseSprite& sprite)
 	}
 }
 
-void SpriteBatch::draw(const RenderSettings& renderSettings, const Matrix4& viewMatrix) const
+void SpriteBatch::writeCompactVertices(const BaseSprite& sprite, CompactVertex* vertices)
 {
-	FLAT_ASSERT(m_texture != nullptr);
-	renderSettings.textureUniform.set(m_texture);
+	const Matrix4& transform = sprite.getModelMatrix();
+	const video::Color& color = sprite.getColor();
+	const std::uint8_t packedColor[4] = { packUnorm8(color.r), packUnorm8(color.g), packUnorm8(color.b), packUnorm8(color.a) };
+	const std::uint32_t packedNormal = packNormal(sprite.getNormal());
+	const float depth = sprite.getDepth();
+	const BaseSprite::VertexPositions& vertexPositions = sprite.getVertexPositions();
+	const BaseSprite::VertexUvs& vertexUvs = sprite.getVertexUvs();
+
+	// the first 4 sprite vertices are the corners of the quad, the last 2 repeat corners 2 and 1
+	Vector2 positions[NUM_QUAD_VERTICES];
+	transformQuad(transform, &vertexPositions[0], positions);
+	for (int i = 0; i < NUM_QUAD_VERTICES; ++i)
+	{
+		CompactVertex& compactVertex = vertices[i];
+		compactVertex.pos = positions[i];
+		compactVertex.uv[0] = packUnorm16(vertexUvs[i].x);
+		compactVertex.uv[1] = packUnorm16(vertexUvs[i].y);
+		std::memcpy(compactVertex.color, packedColor, sizeof(packedColor));
+		compactVertex.normal = packedNormal;
+		compactVertex.depth = depth;
+	}
+}
+
+void SpriteBatch::drawFull(const RenderSettings& renderSettings) const
+{
+	// one copy into the mapped buffer instead of the driver copying client memory during the draw
+	const size_t numBytes = m_vertices.size() * sizeof(Vertex);
+	std::memcpy(m_vertexBuffer.map(numBytes), m_vertices.data(), numBytes);
+	m_vertexBuffer.unmap();
+	const char* vertices = reinterpret_cast<const char*>(m_vertexBuffer.getMappedOffset());
 
 	const video::Attribute positionAttribute = renderSettings.positionAttribute;
 	const video::Attribute uvAttribute = renderSettings.uvAttribute;
@@ -73,27 +310,100 @@ void SpriteBatch::draw(const RenderSettings& renderSettings, const Matrix4& view
 	const video::Attribute depthAttribute = renderSettings.depthAttribute;
 
 	glEnableVertexAttribArray(positionAttribute);
-	glVertexAttribPointer(positionAttribute, 2, GL_FLOAT, GL_FALSE, sizeof(Vertex), &m_vertices[0].pos);
+	glVertexAttribPointer(positionAttribute, 2, GL_FLOAT, GL_FALSE, sizeof(Vertex), vertices + offsetof(Vertex, pos));
 
 	glEnableVertexAttribArray(uvAttribute);
-	glVertexAttribPointer(uvAttribute, 2, GL_FLOAT, GL_FALSE, sizeof(Vertex), &m_vertices[0].uv);
+	glVertexAttribPointer(uvAttribute, 2, GL_FLOAT, GL_FALSE, sizeof(Vertex), vertices + offsetof(Vertex, uv));
 
 	glEnableVertexAttribArray(colorAttribute);
-	glVertexAttribPointer(colorAttribute, 4, GL_FLOAT, GL_FALSE, sizeof(Vertex), &m_vertices[0].color);
+	glVertexAttribPointer(colorAttribute, 4, GL_FLOAT, GL_FALSE, sizeof(Vertex), vertices + offsetof(Vertex, color));
 
 	glEnableVertexAttribArray(normalAttribute);
-	glVertexAttribPointer(normalAttribute, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), &m_vertices[0].normal);
+	glVertexAttribPointer(normalAttribute, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), vertices + offsetof(Vertex, normal));
 
 	glEnableVertexAttribArray(depthAttribute);
-	glVertexAttribPointer(depthAttribute, 1, GL_FLOAT, GL_FALSE, sizeof(Vertex), &m_vertices[0].depth);
+	glVertexAttribPointer(depthAttribute, 1, GL_FLOAT, GL_FALSE, sizeof(Vertex), vertices + offsetof(Vertex, depth));
 
-	glDrawArrays(GL_TRIANGLES, 0, m_numVertices);
+	glDrawArrays(GL_TRIANGLES, 0, static_cast<GLsizei>(m_vertices.size()));
 
-	glDisableVertexAttribArray(positionAttribute);
-	glDisableVertexAttribArray(uvAttribute);
-	glDisableVertexAttribArray(colorAttribute);
-	glDisableVertexAttribArray(normalAttribute);
-	glDisableVertexAttribArray(depthAttribute);
+	disableVertexAttributes(renderSettings);
+}
+
+void SpriteBatch::drawCompact(const RenderSettings& renderSettings) const
+{
+	const size_t numBytes = m_compactVertices.size() * sizeof(CompactVertex);
+	std::memcpy(m_vertexBuffer.map(numBytes), m_compactVertices.data(), numBytes);
+	m_vertexBuffer.unmap();
+	const char* vertices = reinterpret_cast<const char*>(m_vertexBuffer.getMappedOffset());
+
+	enableCompactVertexAttributes(renderSettings, vertices);
+
+	bindQuadIndexBuffer(m_numSprites);
+	glDrawElements(GL_TRIANGLES, static_cast<GLsizei>(m_numSprites * NUM_QUAD_INDICES), GL_UNSIGNED_INT, nullptr);
+	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
+
+	disableVertexAttributes(renderSettings);
+}
+
+void SpriteBatch::enableCompactVertexAttributes(const RenderSettings& renderSettings, const char* vertices)
+{
+	const video::Attribute positionAttribute = renderSettings.positionAttribute;
+	const video::Attribute uvAttribute = renderSettings.uvAttribute;
+	const video::Attribute colorAttribute = renderSettings.colorAttribute;
+	const video::Attribute normalAttribute = renderSettings.normalAttribute;
+	const video::Attribute depthAttribute = renderSettings.depthAttribute;
+
+	glEnableVertexAttribArray(positionAttribute);
+	glVertexAttribPointer(positionAttribute, 2, GL_FLOAT, GL_FALSE, sizeof(CompactVertex), vertices + offsetof(CompactVertex, pos));
+
+	glEnableVertexAttribArray(uvAttribute);
+	glVertexAttribPointer(uvAttribute, 2, GL_UNSIGNED_SHORT, GL_TRUE, sizeof(CompactVertex), vertices + offsetof(CompactVertex, uv));
+
+	glEnableVertexAttribArray(colorAttribute);
+	glVertexAttribPointer(colorAttribute, 4, GL_UNSIGNED_BYTE, GL_TRUE, sizeof(CompactVertex), vertices + offsetof(CompactVertex, color));
+
+	glEnableVertexAttribArray(normalAttribute);
+	glVertexAttribPointer(normalAttribute, 4, GL_INT_2_10_10_10_REV, GL_TRUE, sizeof(CompactVertex), vertices + offsetof(CompactVertex, normal));
+
+	glEnableVertexAttribArray(depthAttribute);
+	glVertexAttribPointer(depthAttribute, 1, GL_FLOAT, GL_FALSE, sizeof(CompactVertex), vertices + offsetof(CompactVertex, depth));
+}
+
+void SpriteBatch::disableVertexAttributes(const RenderSettings& renderSettings)
+{
+	glDisableVertexAttribArray(renderSettings.positionAttribute);
+	glDisableVertexAttribArray(renderSettings.uvAttribute);
+	glDisableVertexAttribArray(renderSettings.colorAttribute);
+	glDisableVertexAttribArray(renderSettings.normalAttribute);
+	glDisableVertexAttribArray(renderSettings.depthAttribute);
+}
+
+void SpriteBatch::bindQuadIndexBuffer(size_t numSprites)
+{
+	if (quadIndexBufferId == 0)
+	{
+		glGenBuffers(1, &quadIndexBufferId);
+	}
+	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, quadIndexBufferId);
+
+	if (numSprites > numIndexedQuads)
+	{
+		numIndexedQuads = std::max(numSprites, numIndexedQuads * 2);
+		std::vector<std::uint32_t> indices(numIndexedQuads * NUM_QUAD_INDICES);
+		for (size_t i = 0; i < numIndexedQuads; ++i)
+		{
+			// same triangles as the 6 vertices of BaseSprite
+			const std::uint32_t firstVertex = static_cast<std::uint32_t>(i * NUM_QUAD_VERTICES);
+			std::uint32_t* quadIndices = &indices[i * NUM_QUAD_INDICES];
+			quadIndices[0] = firstVertex;
+			quadIndices[1] = firstVertex + 1;
+			quadIndices[2] = firstVertex + 2;
+			quadIndices[3] = firstVertex + 3;
+			quadIndices[4] = firstVertex + 2;
+			quadIndices[5] = firstVertex + 1;
+		}
+		glBufferData(GL_ELEMENT_ARRAY_BUFFER, indices.size() * sizeof(std::uint32_t), indices.data(), GL_STATIC_DRAW);
+	}
 }
 
 } // render
@@ -2,9 +2,11 @@
 #define FLAT_RENDER_SPRITEBATCH_H
 
 #include <vector>
-#include <array>
+#include <cstdint>
 
+#include "memory/memorytracker.h"
 #include "video/color.h"
+#include "video/streambuffer.h"
 #include "misc/vector.h"
 #include "misc/matrix4.h"
 
@@ -21,13 +23,42 @@ struct RenderSettings;
 
 class SpriteBatch
 {
+	friend class StaticSpriteLayer;
+
+public:
+	static constexpr size_t DEFAULT_NUM_SPRITES = 1024;
+	static constexpr int NUM_QUAD_VERTICES = 4;
+	static constexpr int NUM_QUAD_INDICES = 6;
+
+	enum class VertexFormat : std::uint8_t
+	{
+		// 6 vertices per sprite with float attributes
+		FULL,
+		// 4 vertices per sprite and a shared index buffer, color as RGBA8, normal as 10-10-10-2 and uvs as
+		// normalized 16 bit integers, the shaders are unchanged as the attributes still reach them as floats
+		// uvs and color components must be in [0, 1]
+		COMPACT
+	};
+
 public:
-	SpriteBatch();
+	// the vertex storage grows as needed, numSprites is only the initial capacity
+	explicit SpriteBatch(VertexFormat vertexFormat = VertexFormat::COMPACT, size_t numSprites = DEFAULT_NUM_SPRITES);
 
+	void reserve(size_t numSprites);
 	void clear();
 	void add(const BaseSprite& sprite);
+	// adds sprites sharing the same texture, their model matrices and vertices are computed in parallel
+	// a sprite must not appear twice as its model matrix could be updated by two threads at once
+	void add(const BaseSprite* const* sprites, size_t numSprites);
+	// copies the vertices to a stream buffer and draws them from there
 	void draw(const RenderSettings& renderSettings, const Matrix4& viewMatrix) const;
 
+	inline VertexFormat getVertexFormat() const { return m_vertexFormat; }
+	inline size_t getNumSprites() const { return m_numSprites; }
+
+	// bytes uploaded per sprite
+	size_t getSpriteSize() const;
+
 	struct Vertex
 	{
 		Vector2 pos;
@@ -39,10 +70,42 @@ public:
 		Vertex() : depth(0.f) {}
 	};
 
+	struct CompactVertex
+	{
+		Vector2 pos;
+		std::uint16_t uv[2];
+		std::uint8_t color[4];
+		std::uint32_t normal;
+		float depth;
+	};
+
+private:
+	void setTexture(const BaseSprite& sprite);
+
+	// write the vertices of a single sprite, safe to call from several threads on different sprites
+	static void writeFullVertices(const BaseSprite& sprite, Vertex* vertices);
+	static void writeCompactVertices(const BaseSprite& sprite, CompactVertex* vertices);
+
+	void drawFull(const RenderSettings& renderSettings) const;
+	void drawCompact(const RenderSettings& renderSettings) const;
+
+	// vertices is the offset of the first vertex in the bound GL_ARRAY_BUFFER
+	static void enableCompactVertexAttributes(const RenderSettings& renderSettings, const char* vertices);
+	static void disableVertexAttributes(const RenderSettings& renderSettings);
+
+	// the same indices work for any batch, the buffer is shared and grown to the largest batch
+	static void bindQuadIndexBuffer(size_t numSprites);
+
 private:
-	std::array<Vertex, 1024 * 1024 * 4> m_vertices;
-	GLsizei m_numVertices;
+	std::vector<Vertex, memory::TaggedAllocator<Vertex, memory::MemoryTag::RENDER>> m_vertices;
+	std::vector<CompactVertex, memory::TaggedAllocator<CompactVertex, memory::MemoryTag::RENDER>> m_compactVertices;
+	size_t m_numSprites;
 	const video::Texture* m_texture;
+	mutable video::StreamBuffer m_vertexBuffer;
+	VertexFormat m_vertexFormat;
+
+	static GLuint quadIndexBufferId;
+	static size_t numIndexedQuads;
 };
 
 } // render
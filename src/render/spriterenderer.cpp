@@ -0,0 +1,237 @@
+#include <cstring>
+#include <algorithm>
+#include <execution>
+
+#include "render/spriterenderer.h"
+#include "render/basesprite.h"
+#include "render/programsettings.h"
+
+#include "video/view.h"
+
+#include "misc/radixsort.h"
+#include "profiler/profiler.h"
+
+namespace flat
+{
+namespace render
+{
+
+namespace
+{
+// key bits: alpha blending (1) | depth (32) | program (8) | texture (16) | unused (7)
+constexpr int ALPHA_BLENDING_SHIFT = 63;
+constexpr int DEPTH_SHIFT = 31;
+constexpr int PROGRAM_SHIFT = 23;
+constexpr int TEXTURE_SHIFT = 7;
+constexpr std::uint32_t MAX_PROGRAMS = 1 << 8;
+constexpr std::uint32_t MAX_TEXTURES = 1 << 16;
+constexpr std::uint64_t STATE_MASK = (std::uint64_t(1) << ALPHA_BLENDING_SHIFT)
+	| (std::uint64_t(MAX_PROGRAMS - 1) << PROGRAM_SHIFT)
+	| (std::uint64_t(MAX_TEXTURES - 1) << TEXTURE_SHIFT);
+}
+
+SpriteRenderer::SpriteRenderer() :
+	m_lastProgramIndex(0),
+	m_lastTextureIndex(0),
+	m_currentProgram(nullptr),
+	m_currentTexture(nullptr),
+	m_blendingEnabled(true)
+{
+
+}
+
+void SpriteRenderer::clear()
+{
+	m_sprites.clear();
+	m_programs.clear();
+	m_textures.clear();
+	m_programIndices.clear();
+	m_textureIndices.clear();
+}
+
+void SpriteRenderer::add(const BaseSprite& sprite, const ProgramSettings& programSettings)
+{
+	const video::Texture* texture = sprite.getTexture().get();
+	FLAT_ASSERT(texture != nullptr);
+
+	// consecutive sprites often share their program and texture, skip the lookups in that case
+	if (m_programs.empty() || m_programs[m_lastProgramIndex] != &programSettings)
+	{
+		std::unordered_map<const ProgramSettings*, std::uint32_t>::iterator it = m_programIndices.find(&programSettings);
+		if (it == m_programIndices.end())
+		{
+			FLAT_ASSERT_MSG(m_programs.size() < MAX_PROGRAMS, "Too many programs in the sprite renderer");
+			it = m_programIndices.emplace(&programSettings, static_cast<std::uint32_t>(m_programs.size())).first;
+			m_programs.push_back(&programSettings);
+		}
+		m_lastProgramIndex = it->second;
+	}
+
+	if (m_textures.empty() || m_textures[m_lastTextureIndex] != texture)
+	{
+		std::unordered_map<const video::Texture*, std::uint32_t>::iterator it = m_textureIndices.find(texture);
+		if (it == m_textureIndices.end())
+		{
+			FLAT_ASSERT_MSG(m_textures.size() < MAX_TEXTURES, "Too many textures in the sprite renderer");
+			it = m_textureIndices.emplace(texture, static_cast<std::uint32_t>(m_textures.size())).first;
+			m_textures.push_back(texture);
+		}
+		m_lastTextureIndex = it->second;
+	}
+
+	const std::uint64_t key = (std::uint64_t(sprite.requiresAlphaBlending() ? 1 : 0) << ALPHA_BLENDING_SHIFT)
+		| (std::uint64_t(getSortableDepth(sprite.getDepth())) << DEPTH_SHIFT)
+		| (std::uint64_t(m_lastProgramIndex) << PROGRAM_SHIFT)
+		| (std::uint64_t(m_lastTextureIndex) << TEXTURE_SHIFT);
+	m_sprites.push_back({ key, &sprite });
+}
+
+void SpriteRenderer::draw(const Matrix4& viewMatrix)
+{
+	m_stats = Stats();
+	drawSprites(viewMatrix);
+}
+
+void SpriteRenderer::draw(const video::View& view)
+{
+	m_stats = Stats();
+	AABB2 visibleAABB;
+	view.getVisibleAABB(visibleAABB);
+	cull(visibleAABB);
+	drawSprites(view.getViewProjectionMatrix());
+}
+
+void SpriteRenderer::cull(const AABB2& visibleAABB)
+{
+	FLAT_PROFILE("Cull sprites");
+
+	// the model matrices updated here are not updated again when filling the batches
+	const size_t numSprites = m_sprites.size();
+	m_spriteAABBs.resize(numSprites);
+	const QueuedSprite* sprites = m_sprites.data();
+	std::for_each(std::execution::par, m_sprites.cbegin(), m_sprites.cend(), [this, sprites](const QueuedSprite& queuedSprite)
+	{
+		AABB2 aabb;
+		queuedSprite.sprite->getAABB(aabb);
+		m_spriteAABBs.set(&queuedSprite - sprites, aabb);
+	});
+
+	m_visibleSprites.resize(numSprites);
+	m_visibleSprites.resetAll();
+	m_spriteAABBs.eachOverlap(visibleAABB, [this](size_t index)
+	{
+		m_visibleSprites.set(index);
+	});
+
+	// set bits come in increasing index order, the visible sprites can be moved to the front in place
+	size_t numVisibleSprites = 0;
+	m_visibleSprites.eachSetBit([this, &numVisibleSprites](size_t index)
+	{
+		m_sprites[numVisibleSprites++] = m_sprites[index];
+	});
+	m_sprites.resize(numVisibleSprites);
+
+	m_stats.numCulledSprites = static_cast<int>(numSprites - numVisibleSprites);
+	FLAT_PROFILE_COUNTER("Visible sprites", static_cast<std::int64_t>(numVisibleSprites));
+	FLAT_PROFILE_COUNTER("Culled sprites", static_cast<std::int64_t>(m_stats.numCulledSprites));
+}
+
+void SpriteRenderer::drawSprites(const Matrix4& viewMatrix)
+{
+	m_stats.numSprites = static_cast<int>(m_sprites.size());
+	if (m_sprites.empty())
+	{
+		return;
+	}
+
+	{
+		FLAT_PROFILE("Sort sprites");
+		// stable, sprites with the same key keep the order they were added in
+		m_sortBuffer.resize(m_sprites.size());
+		radixSort(m_sprites.data(), m_sortBuffer.data(), m_sprites.size(), [](const QueuedSprite& queuedSprite) { return queuedSprite.key; });
+	}
+
+	FLAT_PROFILE("Draw sprites");
+
+	m_currentProgram = nullptr;
+	m_currentTexture = nullptr;
+	m_blendingEnabled = true; // enabled by the window
+
+	// a draw call per range of sprites with the same state, the depth can change inside a range
+	const QueuedSprite* rangeBegin = m_sprites.data();
+	const QueuedSprite* end = rangeBegin + m_sprites.size();
+	for (const QueuedSprite* queuedSprite = rangeBegin + 1; queuedSprite < end; ++queuedSprite)
+	{
+		if ((queuedSprite->key & STATE_MASK) != (rangeBegin->key & STATE_MASK))
+		{
+			drawRange(rangeBegin, queuedSprite, viewMatrix);
+			rangeBegin = queuedSprite;
+		}
+	}
+	drawRange(rangeBegin, end, viewMatrix);
+
+	if (!m_blendingEnabled)
+	{
+		glEnable(GL_BLEND);
+	}
+}
+
+void SpriteRenderer::drawRange(const QueuedSprite* begin, const QueuedSprite* end, const Matrix4& viewMatrix)
+{
+	const std::uint64_t key = begin->key;
+
+	const bool requiresAlphaBlending = (key >> ALPHA_BLENDING_SHIFT) != 0;
+	if (requiresAlphaBlending != m_blendingEnabled)
+	{
+		if (requiresAlphaBlending)
+		{
+			glEnable(GL_BLEND);
+		}
+		else
+		{
+			glDisable(GL_BLEND);
+		}
+		m_blendingEnabled = requiresAlphaBlending;
+		++m_stats.numBlendingChanges;
+	}
+
+	const ProgramSettings* programSettings = m_programs[(key >> PROGRAM_SHIFT) & (MAX_PROGRAMS - 1)];
+	if (programSettings != m_currentProgram)
+	{
+		glUseProgram(programSettings->program.getProgramId());
+		programSettings->settings.viewProjectionMatrixUniform.set(viewMatrix);
+		m_currentProgram = programSettings;
+		++m_stats.numProgramChanges;
+	}
+
+	const video::Texture* texture = m_textures[(key >> TEXTURE_SHIFT) & (MAX_TEXTURES - 1)];
+	if (texture != m_currentTexture)
+	{
+		m_currentTexture = texture;
+		++m_stats.numTextureChanges;
+	}
+
+	m_rangeSprites.clear();
+	for (const QueuedSprite* queuedSprite = begin; queuedSprite < end; ++queuedSprite)
+	{
+		m_rangeSprites.push_back(queuedSprite->sprite);
+	}
+	m_spriteBatch.clear();
+	m_spriteBatch.add(m_rangeSprites.data(), m_rangeSprites.size());
+	m_spriteBatch.draw(programSettings->settings, viewMatrix);
+	++m_stats.numDrawCalls;
+}
+
+std::uint32_t SpriteRenderer::getSortableDepth(float depth)
+{
+	// positive floats sort like their bits, negative ones in reverse: flip all the bits of negative
+	// floats and only the sign bit of positive ones so that the unsigned integers sort like the floats
+	std::uint32_t bits;
+	std::memcpy(&bits, &depth, sizeof(bits));
+	return (bits & 0x80000000u) != 0 ? ~bits : bits | 0x80000000u;
+}
+
+} // render
+} // flat
+
+
@@ -0,0 +1,105 @@
+#ifndef FLAT_RENDER_SPRITERENDERER_H
+#define FLAT_RENDER_SPRITERENDERER_H
+
+#include <vector>
+#include <unordered_map>
+#include <cstdint>
+
+#include "render/spritebatch.h"
+#include "misc/matrix4.h"
+#include "misc/aabb2array.h"
+#include "containers/dynamicbitset.h"
+
+namespace flat
+{
+namespace video
+{
+class Texture;
+class View;
+}
+namespace render
+{
+class BaseSprite;
+struct ProgramSettings;
+
+// queue of sprites using any texture and program: the sprites are sorted by (alpha blending, depth, program, texture)
+// and consecutive sprites sharing the same program and texture are drawn in a single call
+// opaque sprites are drawn first with blending disabled, then the ones requiring alpha blending, both by increasing depth
+class SpriteRenderer
+{
+	public:
+		struct Stats
+		{
+			int numSprites = 0;
+			int numCulledSprites = 0;
+			int numDrawCalls = 0;
+			int numProgramChanges = 0;
+			int numTextureChanges = 0;
+			int numBlendingChanges = 0;
+		};
+
+	public:
+		SpriteRenderer();
+		~SpriteRenderer() = default;
+
+		void clear();
+
+		// the sprite and the program must stay alive until draw(), the depth is read right away
+		// a sprite must be added only once as the sprites are processed in parallel
+		void add(const BaseSprite& sprite, const ProgramSettings& programSettings);
+
+		// sets the view projection matrix of each program used
+		void draw(const Matrix4& viewMatrix);
+
+		// same but only draws the sprites whose AABB overlaps the visible part of the view,
+		// the other ones are removed from the queue
+		void draw(const video::View& view);
+
+		// counters of the last draw()
+		inline const Stats& getStats() const { return m_stats; }
+
+	private:
+		struct QueuedSprite
+		{
+			std::uint64_t key;
+			const BaseSprite* sprite;
+		};
+
+		void cull(const AABB2& visibleAABB);
+		void drawSprites(const Matrix4& viewMatrix);
+		void drawRange(const QueuedSprite* begin, const QueuedSprite* end, const Matrix4& viewMatrix);
+
+		static std::uint32_t getSortableDepth(float depth);
+
+	private:
+		std::vector<QueuedSprite> m_sprites;
+		std::vector<QueuedSprite> m_sortBuffer;
+		AABB2Array m_spriteAABBs;
+		containers::DynamicBitset m_visibleSprites;
+
+		// programs and textures are given a small index in the order they are first added
+		std::vector<const ProgramSettings*> m_programs;
+		std::vector<const video::Texture*> m_textures;
+		std::unordered_map<const ProgramSettings*, std::uint32_t> m_programIndices;
+		std::unordered_map<const video::Texture*, std::uint32_t> m_textureIndices;
+		std::uint32_t m_lastProgramIndex;
+		std::uint32_t m_lastTextureIndex;
+
+		// sprites of the range being drawn, added to the batch at once
+		std::vector<const BaseSprite*> m_rangeSprites;
+		SpriteBatch m_spriteBatch;
+
+		// state of the current draw()
+		const ProgramSettings* m_currentProgram;
+		const video::Texture* m_currentTexture;
+		bool m_blendingEnabled;
+
+		Stats m_stats;
+};
+
+} // render
+} // flat
+
+#endif // FLAT_RENDER_SPRITERENDERER_H
+
+
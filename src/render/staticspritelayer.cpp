@@ -0,0 +1,277 @@
+#include <cmath>
+#include <limits>
+#include <algorithm>
+#include <functional>
+#include <execution>
+
+#include "render/staticspritelayer.h"
+#include "render/basesprite.h"
+#include "render/rendersettings.h"
+
+#include "video/view.h"
+#include "profiler/profiler.h"
+
+namespace flat
+{
+namespace render
+{
+
+StaticSpriteLayer::StaticSpriteLayer(float chunkSize) :
+	m_chunkSize(chunkSize),
+	m_nextSpriteOrder(0)
+{
+	FLAT_ASSERT(chunkSize > 0.f);
+}
+
+StaticSpriteLayer::~StaticSpriteLayer()
+{
+	clear();
+}
+
+void StaticSpriteLayer::add(const BaseSprite& sprite)
+{
+	FLAT_ASSERT_MSG(m_spriteChunkIndices.count(&sprite) == 0, "Sprite already in the static sprite layer");
+	const size_t chunkIndex = getChunkIndex(sprite);
+	addToChunk(sprite, chunkIndex, m_nextSpriteOrder++);
+}
+
+void StaticSpriteLayer::remove(const BaseSprite& sprite)
+{
+	std::unordered_map<const BaseSprite*, size_t>::iterator it = m_spriteChunkIndices.find(&sprite);
+	FLAT_ASSERT_MSG(it != m_spriteChunkIndices.end(), "Sprite not in the static sprite layer");
+	removeFromChunk(sprite, it->second);
+	m_spriteChunkIndices.erase(it);
+}
+
+void StaticSpriteLayer::clear()
+{
+	for (Chunk& chunk : m_chunks)
+	{
+		if (chunk.vertexBufferId != 0)
+		{
+			glDeleteBuffers(1, &chunk.vertexBufferId);
+			FLAT_TRACK_FREE(memory::MemoryTag::RENDER, chunk.vertexBufferSize);
+		}
+	}
+	m_chunks.clear();
+	m_chunkAABBs.clear();
+	m_chunkIndices.clear();
+	m_spriteChunkIndices.clear();
+	m_nextSpriteOrder = 0;
+}
+
+void StaticSpriteLayer::invalidate(const BaseSprite& sprite)
+{
+	std::unordered_map<const BaseSprite*, size_t>::iterator it = m_spriteChunkIndices.find(&sprite);
+	FLAT_ASSERT_MSG(it != m_spriteChunkIndices.end(), "Sprite not in the static sprite layer");
+	m_chunks[it->second].isDirty = true;
+}
+
+void StaticSpriteLayer::draw(const RenderSettings& renderSettings, const video::View& view)
+{
+	FLAT_PROFILE("Draw static sprite layer");
+
+	m_stats = Stats();
+	moveDirtySprites();
+	m_stats.numChunks = static_cast<int>(m_chunks.size());
+
+	size_t maxNumSprites = 0;
+	for (size_t chunkIndex = 0; chunkIndex < m_chunks.size(); ++chunkIndex)
+	{
+		const Chunk& chunk = m_chunks[chunkIndex];
+		if (chunk.isDirty)
+		{
+			uploadChunk(chunkIndex);
+			++m_stats.numUploadedChunks;
+		}
+		maxNumSprites = std::max(maxNumSprites, chunk.sprites.size());
+	}
+
+	if (maxNumSprites == 0)
+	{
+		return;
+	}
+
+	AABB2 visibleAABB;
+	view.getVisibleAABB(visibleAABB);
+
+	m_visibleChunks.clear();
+	m_chunkAABBs.eachOverlap(visibleAABB, [this](size_t chunkIndex)
+	{
+		m_visibleChunks.push_back(chunkIndex);
+	});
+	std::sort(m_visibleChunks.begin(), m_visibleChunks.end(), [this](size_t a, size_t b)
+	{
+		const float minDepthA = m_chunks[a].minDepth;
+		const float minDepthB = m_chunks[b].minDepth;
+		return minDepthA < minDepthB || (minDepthA == minDepthB && a < b);
+	});
+
+	SpriteBatch::bindQuadIndexBuffer(maxNumSprites);
+	for (size_t chunkIndex : m_visibleChunks)
+	{
+		const Chunk& chunk = m_chunks[chunkIndex];
+		renderSettings.textureUniform.set(chunk.texture);
+		glBindBuffer(GL_ARRAY_BUFFER, chunk.vertexBufferId);
+		SpriteBatch::enableCompactVertexAttributes(renderSettings, nullptr);
+		glDrawElements(GL_TRIANGLES, static_cast<GLsizei>(chunk.sprites.size() * SpriteBatch::NUM_QUAD_INDICES), GL_UNSIGNED_INT, nullptr);
+		++m_stats.numDrawnChunks;
+	}
+	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
+	glBindBuffer(GL_ARRAY_BUFFER, 0);
+	SpriteBatch::disableVertexAttributes(renderSettings);
+}
+
+size_t StaticSpriteLayer::ChunkKeyHash::operator()(const ChunkKey& chunkKey) const
+{
+	const size_t hash = std::hash<const video::Texture*>()(chunkKey.texture);
+	return (hash * 31 + std::hash<int>()(chunkKey.x)) * 31 + std::hash<int>()(chunkKey.y);
+}
+
+size_t StaticSpriteLayer::getChunkIndex(const BaseSprite& sprite)
+{
+	AABB2 aabb;
+	sprite.getAABB(aabb);
+	const Vector2 center = aabb.getCenter();
+	const ChunkKey chunkKey {
+		static_cast<int>(std::floor(center.x / m_chunkSize)),
+		static_cast<int>(std::floor(center.y / m_chunkSize)),
+		sprite.getTexture().get()
+	};
+	FLAT_ASSERT(chunkKey.texture != nullptr);
+
+	std::unordered_map<ChunkKey, size_t, ChunkKeyHash>::iterator it = m_chunkIndices.find(chunkKey);
+	if (it != m_chunkIndices.end())
+	{
+		return it->second;
+	}
+
+	// chunks are never removed so that indices stay valid, empty chunks are skipped
+	const size_t chunkIndex = m_chunks.size();
+	m_chunkIndices.emplace(chunkKey, chunkIndex);
+	Chunk& chunk = m_chunks.emplace_back();
+	chunk.texture = chunkKey.texture;
+	chunk.vertexBufferId = 0;
+	chunk.vertexBufferSize = 0;
+	chunk.minDepth = 0.f;
+	chunk.isDirty = true;
+	chunk.hasDirtySprites = false;
+	m_chunkAABBs.add(AABB2());
+	return chunkIndex;
+}
+
+void StaticSpriteLayer::addToChunk(const BaseSprite& sprite, size_t chunkIndex, std::uint64_t order)
+{
+	// a sprite moving from another chunk goes back to its place among the sprites added before and after it
+	Chunk& chunk = m_chunks[chunkIndex];
+	std::vector<ChunkSprite>::iterator it = std::upper_bound(chunk.sprites.begin(), chunk.sprites.end(), order,
+		[](std::uint64_t spriteOrder, const ChunkSprite& chunkSprite) { return spriteOrder < chunkSprite.order; });
+	chunk.sprites.insert(it, { &sprite, order });
+	chunk.isDirty = true;
+	m_spriteChunkIndices[&sprite] = chunkIndex;
+}
+
+std::uint64_t StaticSpriteLayer::removeFromChunk(const BaseSprite& sprite, size_t chunkIndex)
+{
+	// keeps the drawing order of the other sprites
+	Chunk& chunk = m_chunks[chunkIndex];
+	std::vector<ChunkSprite>::iterator it = std::find_if(chunk.sprites.begin(), chunk.sprites.end(),
+		[&sprite](const ChunkSprite& chunkSprite) { return chunkSprite.sprite == &sprite; });
+	FLAT_ASSERT(it != chunk.sprites.end());
+	const std::uint64_t order = it->order;
+	chunk.sprites.erase(it);
+	chunk.isDirty = true;
+	return order;
+}
+
+void StaticSpriteLayer::moveDirtySprites()
+{
+	FLAT_PROFILE("Move dirty static sprites");
+
+	// a single read of a flag per sprite, the matrices are only updated for the sprites that changed
+	std::for_each(std::execution::par, m_chunks.begin(), m_chunks.end(), [](Chunk& chunk)
+	{
+		chunk.hasDirtySprites = std::any_of(chunk.sprites.begin(), chunk.sprites.end(), [](const ChunkSprite& chunkSprite) { return chunkSprite.sprite->isModelMatrixDirty(); });
+	});
+
+	m_movedSprites.clear();
+	for (const Chunk& chunk : m_chunks)
+	{
+		if (!chunk.hasDirtySprites)
+		{
+			continue;
+		}
+		for (const ChunkSprite& chunkSprite : chunk.sprites)
+		{
+			if (chunkSprite.sprite->isModelMatrixDirty())
+			{
+				m_movedSprites.push_back(chunkSprite.sprite);
+			}
+		}
+	}
+
+	for (const BaseSprite* sprite : m_movedSprites)
+	{
+		size_t& spriteChunkIndex = m_spriteChunkIndices[sprite];
+		const size_t chunkIndex = getChunkIndex(*sprite);
+		if (chunkIndex != spriteChunkIndex)
+		{
+			const std::uint64_t order = removeFromChunk(*sprite, spriteChunkIndex);
+			addToChunk(*sprite, chunkIndex, order);
+		}
+		else
+		{
+			m_chunks[chunkIndex].isDirty = true;
+		}
+	}
+}
+
+void StaticSpriteLayer::uploadChunk(size_t chunkIndex)
+{
+	Chunk& chunk = m_chunks[chunkIndex];
+	chunk.isDirty = false;
+
+	// by increasing depth, stable so that sprites at the same depth stay in the order they were added
+	m_sortedSprites.clear();
+	for (const ChunkSprite& chunkSprite : chunk.sprites)
+	{
+		m_sortedSprites.push_back(chunkSprite.sprite);
+	}
+	std::stable_sort(m_sortedSprites.begin(), m_sortedSprites.end(), [](const BaseSprite* a, const BaseSprite* b) { return a->getDepth() < b->getDepth(); });
+	chunk.minDepth = m_sortedSprites.empty() ? 0.f : m_sortedSprites.front()->getDepth();
+
+	// the chunk AABB covers the sprites overflowing the chunk cell
+	constexpr float infinity = std::numeric_limits<float>::infinity();
+	AABB2 chunkAABB(Vector2(infinity, infinity), Vector2(-infinity, -infinity));
+	m_vertices.resize(m_sortedSprites.size() * SpriteBatch::NUM_QUAD_VERTICES);
+	for (size_t i = 0; i < m_sortedSprites.size(); ++i)
+	{
+		SpriteBatch::CompactVertex* vertices = &m_vertices[i * SpriteBatch::NUM_QUAD_VERTICES];
+		SpriteBatch::writeCompactVertices(*m_sortedSprites[i], vertices);
+		for (int j = 0; j < SpriteBatch::NUM_QUAD_VERTICES; ++j)
+		{
+			chunkAABB.min = glm::min(chunkAABB.min, vertices[j].pos);
+			chunkAABB.max = glm::max(chunkAABB.max, vertices[j].pos);
+		}
+	}
+	m_chunkAABBs.set(chunkIndex, chunkAABB);
+
+	if (chunk.vertexBufferId == 0)
+	{
+		glGenBuffers(1, &chunk.vertexBufferId);
+	}
+
+	// a new storage rather than updating the one that may still be used by the previous frame
+	const size_t numBytes = m_vertices.size() * sizeof(SpriteBatch::CompactVertex);
+	glBindBuffer(GL_ARRAY_BUFFER, chunk.vertexBufferId);
+	glBufferData(GL_ARRAY_BUFFER, numBytes, m_vertices.data(), GL_STATIC_DRAW);
+	glBindBuffer(GL_ARRAY_BUFFER, 0);
+	FLAT_TRACK_FREE(memory::MemoryTag::RENDER, chunk.vertexBufferSize);
+	FLAT_TRACK_ALLOCATION(memory::MemoryTag::RENDER, numBytes);
+	chunk.vertexBufferSize = numBytes;
+}
+
+} // render
+} // flat
+
+
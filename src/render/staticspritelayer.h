@@ -0,0 +1,135 @@
+#ifndef FLAT_RENDER_STATICSPRITELAYER_H
+#define FLAT_RENDER_STATICSPRITELAYER_H
+
+#include <vector>
+#include <unordered_map>
+#include <cstdint>
+
+#include "render/spritebatch.h"
+#include "misc/aabb2array.h"
+
+namespace flat
+{
+namespace video
+{
+class Texture;
+class View;
+}
+namespace render
+{
+class BaseSprite;
+struct RenderSettings;
+
+// sprites that rarely change, such as map tiles, kept in vertex buffers across frames
+// the sprites are grouped by texture into square chunks of the world, each chunk is a vertex buffer drawn in a single
+// call when it overlaps the view, and only the chunks whose sprites changed are uploaded again
+// a sprite whose model matrix is dirty when the layer is drawn is moved to its new chunk if needed, other changes
+// (uvs, color, depth...) or a model matrix already updated elsewhere must be reported with invalidate()
+// the visible chunks are drawn by increasing minimum depth, then in the order they were created, and the sprites of a
+// chunk by increasing depth, then in the order they were added even if they moved from another chunk
+// sprites of different chunks are never interleaved: overlapping sprites at different depths are only ordered exactly
+// when they share their texture and chunk, use a layer per depth otherwise
+class StaticSpriteLayer
+{
+	public:
+		static constexpr float DEFAULT_CHUNK_SIZE = 1024.f;
+
+		struct Stats
+		{
+			int numChunks = 0;
+			int numDrawnChunks = 0;
+			int numUploadedChunks = 0;
+		};
+
+	public:
+		explicit StaticSpriteLayer(float chunkSize = DEFAULT_CHUNK_SIZE);
+		StaticSpriteLayer(const StaticSpriteLayer&) = delete;
+		StaticSpriteLayer(StaticSpriteLayer&&) = delete;
+		~StaticSpriteLayer();
+
+		void operator=(const StaticSpriteLayer&) = delete;
+		void operator=(StaticSpriteLayer&&) = delete;
+
+		// the sprite must stay alive until removed or the layer is cleared
+		void add(const BaseSprite& sprite);
+		void remove(const BaseSprite& sprite);
+		void clear();
+
+		// uploads the chunk of the sprite again before the next draw
+		void invalidate(const BaseSprite& sprite);
+
+		// the program and the view projection matrix must be set by the caller, as for SpriteBatch
+		void draw(const RenderSettings& renderSettings, const video::View& view);
+
+		inline size_t getNumSprites() const { return m_spriteChunkIndices.size(); }
+		inline size_t getNumChunks() const { return m_chunks.size(); }
+
+		// counters of the last draw()
+		inline const Stats& getStats() const { return m_stats; }
+
+	private:
+		struct ChunkKey
+		{
+			int x;
+			int y;
+			const video::Texture* texture;
+
+			inline bool operator==(const ChunkKey& other) const { return x == other.x && y == other.y && texture == other.texture; }
+		};
+
+		struct ChunkKeyHash
+		{
+			size_t operator()(const ChunkKey& chunkKey) const;
+		};
+
+		struct ChunkSprite
+		{
+			const BaseSprite* sprite;
+			std::uint64_t order;
+		};
+
+		struct Chunk
+		{
+			// by increasing order
+			std::vector<ChunkSprite> sprites;
+			const video::Texture* texture;
+			GLuint vertexBufferId;
+			size_t vertexBufferSize;
+			float minDepth;
+			bool isDirty;
+			bool hasDirtySprites;
+		};
+
+		size_t getChunkIndex(const BaseSprite& sprite);
+		void addToChunk(const BaseSprite& sprite, size_t chunkIndex, std::uint64_t order);
+		// returns the order of the sprite
+		std::uint64_t removeFromChunk(const BaseSprite& sprite, size_t chunkIndex);
+
+		void moveDirtySprites();
+		void uploadChunk(size_t chunkIndex);
+
+	private:
+		std::vector<Chunk> m_chunks;
+		AABB2Array m_chunkAABBs;
+		std::unordered_map<ChunkKey, size_t, ChunkKeyHash> m_chunkIndices;
+		std::unordered_map<const BaseSprite*, size_t> m_spriteChunkIndices;
+
+		// reused between uploads and draws
+		std::vector<SpriteBatch::CompactVertex, memory::TaggedAllocator<SpriteBatch::CompactVertex, memory::MemoryTag::RENDER>> m_vertices;
+		std::vector<const BaseSprite*> m_sortedSprites;
+		std::vector<const BaseSprite*> m_movedSprites;
+		std::vector<size_t> m_visibleChunks;
+
+		float m_chunkSize;
+		// incremented by add()
+		std::uint64_t m_nextSpriteOrder;
+
+		Stats m_stats;
+};
+
+} // render
+} // flat
+
+#endif // FLAT_RENDER_STATICSPRITELAYER_H
+
+
@@ -52,15 +52,11 @@ void CanvasWidget::drawLine(const video::Color& color, float width, bool smoothL
 void CanvasWidget::drawBezier(const video::Color& color, float width, bool smoothLine, const std::vector<Vector2>& controlPoints)
 {
 	FLAT_ASSERT(controlPoints.size() > 1);
-	std::vector<Vector2> bezierCurve;
-	float length = 0.f;
-	for (int i = 0; i < controlPoints.size() - 1; ++i)
-	{
-		length += flat::length(controlPoints[i] - controlPoints[i + 1]);
-	}
-	int numSteps = std::max(2, static_cast<int>(length / 10.f));
-	geometry::bezier::computeBezier(controlPoints, numSteps, bezierCurve);
-	drawLines(color, width, smoothLine, bezierCurve.data(), static_cast<GLsizei>(bezierCurve.size()));
+	// at most a quarter of a unit away from the actual curve, flattened on the stack to avoid an allocation per curve
+	constexpr int MAX_STEPS = 256;
+	Vector2 bezierCurve[MAX_STEPS];
+	const int numSteps = geometry::bezier::flattenBezier(controlPoints.data(), controlPoints.size(), 0.25f, bezierCurve, MAX_STEPS);
+	drawLines(color, width, smoothLine, bezierCurve, static_cast<GLsizei>(numSteps));
 }
 
 void CanvasWidget::drawLines(const video::Color& color, float width, bool smoothLine, const Vector2* vertices, GLsizei count)
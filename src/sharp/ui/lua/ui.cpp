@@ -7,6 +7,7 @@
 #include "sharp/ui/widgetfactory.h"
 
 #include "flat/game.h"
+#include "geometry/bezier.h"
 #include "lua/lua.h"
 #include "lua/sharedluareference.h"
 #include "lua/sharedcppreference.h"
@@ -938,6 +939,7 @@ int l_CanvasWidget_drawBezier(lua_State * L)
 	bool smoothLine = lua_toboolean(L, 4) == 1;
 	luaL_checktype(L, 5, LUA_TTABLE);
 	size_t numControlPoints = lua_rawlen(L, 5);
+	luaL_argcheck(L, numControlPoints > 1 && numControlPoints <= flat::geometry::bezier::MAX_CONTROL_POINTS, 5, "a bezier curve needs 2 to 16 control points");
 	std::vector<Vector2> controlPoints;
 	controlPoints.reserve(numControlPoints);
 	for (int i = 1; i <= numControlPoints; ++i)
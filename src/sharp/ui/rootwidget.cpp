@@ -455,16 +455,13 @@ void RootWidget::handleMouseWheel()
 	}
 }
 
-std::vector<Widget*> getFocusableChildren(Widget* widget) {
-	std::vector<Widget*> result;
+void getFocusableChildren(Widget* widget, std::pmr::vector<Widget*>& focusables) {
 	if(widget->isFocusable())
-		result.push_back(widget);
+		focusables.push_back(widget);
 	const auto& children = widget->getChildren();
 	for(const auto& child: children) {
-		const auto& focusables = getFocusableChildren(child.get());
-		result.insert(result.end(), focusables.begin(), focusables.end());
+		getFocusableChildren(child.get(), focusables);
 	}
-	return result;
 }
 
 template<class Iterator>
@@ -486,13 +483,15 @@ Widget* getClosestFocusable(Widget* widget, Iterator begin, Iterator end)
 
 Widget* RootWidget::getNextFocusable(Widget* widget)
 {
-	std::vector<Widget*> focusables = getFocusableChildren(this);
+	std::pmr::vector<Widget*> focusables(m_flat.frameArena->getResource());
+	getFocusableChildren(this, focusables);
 	return getClosestFocusable(widget, focusables.begin(), focusables.end());
 }
 
 Widget* RootWidget::getPreviousFocusable(Widget* widget)
 {
-	std::vector<Widget*> focusables = getFocusableChildren(this);
+	std::pmr::vector<Widget*> focusables(m_flat.frameArena->getResource());
+	getFocusableChildren(this, focusables);
 	return getClosestFocusable(widget, focusables.rbegin(), focusables.rend());
 }
 
@@ -10,6 +10,8 @@
 
 #include "flat/game.h"
 
+#include "memory/memorytracker.h"
+
 namespace flat
 {
 namespace sharp
@@ -17,6 +19,16 @@ namespace sharp
 namespace ui
 {
 
+namespace
+{
+// widgets and their shared_ptr control blocks are counted in the UI memory
+template <class T, typename... ConstructorArgs>
+std::shared_ptr<T> makeWidget(ConstructorArgs&&... constructorArgs)
+{
+	return std::allocate_shared<T>(memory::TaggedAllocator<T, memory::MemoryTag::UI>(), std::forward<ConstructorArgs>(constructorArgs)...);
+}
+}
+
 WidgetFactory::WidgetFactory(Flat& flat) :
 	m_flat(flat)
 {
@@ -25,7 +37,7 @@ WidgetFactory::WidgetFactory(Flat& flat) :
 
 std::shared_ptr<RootWidget> WidgetFactory::makeRoot() const
 {
-	std::shared_ptr<RootWidget> rootWidget = std::make_shared<RootWidget>(m_flat);
+	std::shared_ptr<RootWidget> rootWidget = makeWidget<RootWidget>(m_flat);
 	rootWidget->setWeakPtr(rootWidget);
 	return rootWidget;
 }
@@ -40,7 +52,7 @@ std::shared_ptr<Widget> WidgetFactory::makeImage(const std::string& fileName) co
 
 std::shared_ptr<Widget> WidgetFactory::makeFixedSize(const Vector2& size) const
 {
-	std::shared_ptr<Widget> widget = std::make_shared<WidgetImpl<FixedLayout>>();
+	std::shared_ptr<Widget> widget = makeWidget<WidgetImpl<FixedLayout>>();
 	widget->setWeakPtr(widget);
 	widget->setSizePolicy(Widget::SizePolicy::FIXED);
 	widget->setSize(size);
@@ -49,7 +61,7 @@ std::shared_ptr<Widget> WidgetFactory::makeFixedSize(const Vector2& size) const
 
 std::shared_ptr<Widget> WidgetFactory::makeExpand() const
 {
-	std::shared_ptr<Widget> widget = std::make_shared<WidgetImpl<FixedLayout>>();
+	std::shared_ptr<Widget> widget = makeWidget<WidgetImpl<FixedLayout>>();
 	widget->setWeakPtr(widget);
 	widget->setSizePolicy(Widget::SizePolicy::EXPAND);
 	return widget;
@@ -57,7 +69,7 @@ std::shared_ptr<Widget> WidgetFactory::makeExpand() const
 
 std::shared_ptr<Widget> WidgetFactory::makeCompress() const
 {
-	std::shared_ptr<Widget> widget = std::make_shared<WidgetImpl<FixedLayout>>();
+	std::shared_ptr<Widget> widget = makeWidget<WidgetImpl<FixedLayout>>();
 	widget->setWeakPtr(widget);
 	widget->setSizePolicy(Widget::SizePolicy::COMPRESS);
 	return widget;
@@ -65,7 +77,7 @@ std::shared_ptr<Widget> WidgetFactory::makeCompress() const
 
 std::shared_ptr<Widget> WidgetFactory::makeLineFlow() const
 {
-	std::shared_ptr<Widget> widget = std::make_shared<WidgetImpl<LineFlowLayout>>();
+	std::shared_ptr<Widget> widget = makeWidget<WidgetImpl<LineFlowLayout>>();
 	widget->setWeakPtr(widget);
 	widget->setSizePolicy(Widget::SizePolicy::COMPRESS);
 	return widget;
@@ -73,7 +85,7 @@ std::shared_ptr<Widget> WidgetFactory::makeLineFlow() const
 
 std::shared_ptr<Widget> WidgetFactory::makeColumnFlow() const
 {
-	std::shared_ptr<Widget> widget = std::make_shared<WidgetImpl<ColumnFlowLayout>>();
+	std::shared_ptr<Widget> widget = makeWidget<WidgetImpl<ColumnFlowLayout>>();
 	widget->setWeakPtr(widget);
 	widget->setSizePolicy(Widget::SizePolicy::COMPRESS);
 	return widget;
@@ -82,7 +94,7 @@ std::shared_ptr<Widget> WidgetFactory::makeColumnFlow() const
 std::shared_ptr<TextWidget> WidgetFactory::makeText(const std::string& text, const std::string& fileName, int fontSize) const
 {
 	std::shared_ptr<const video::font::Font> font = m_flat.video->getFont(fileName, fontSize);
-	std::shared_ptr<TextWidget> widget = std::make_shared<TextWidget>(font);
+	std::shared_ptr<TextWidget> widget = makeWidget<TextWidget>(font);
 	widget->setWeakPtr(widget);
 	widget->setText(text);
 	return widget;
@@ -91,7 +103,7 @@ std::shared_ptr<TextWidget> WidgetFactory::makeText(const std::string& text, con
 std::shared_ptr<TextInputWidget> WidgetFactory::makeTextInput(const std::string& fileName, int fontSize) const
 {
 	std::shared_ptr<const video::font::Font> font = m_flat.video->getFont(fileName, fontSize);
-	std::shared_ptr<TextInputWidget> widget = std::make_shared<TextInputWidget>(m_flat, font);
+	std::shared_ptr<TextInputWidget> widget = makeWidget<TextInputWidget>(m_flat, font);
 	widget->setWeakPtr(widget);
 	return widget;
 }
@@ -99,14 +111,14 @@ std::shared_ptr<TextInputWidget> WidgetFactory::makeTextInput(const std::string&
 std::shared_ptr<TextInputWidget> WidgetFactory::makeNumberInput(const std::string& fileName, int fontSize) const
 {
 	std::shared_ptr<const video::font::Font> font = m_flat.video->getFont(fileName, fontSize);
-	std::shared_ptr<NumberInputWidget> widget = std::make_shared<NumberInputWidget>(m_flat, font);
+	std::shared_ptr<NumberInputWidget> widget = makeWidget<NumberInputWidget>(m_flat, font);
 	widget->setWeakPtr(widget);
 	return widget;
 }
 
 std::shared_ptr<CanvasWidget> WidgetFactory::makeCanvas(const Vector2& size) const
 {
-	std::shared_ptr<CanvasWidget> widget = std::make_shared<CanvasWidget>(getCanvasRender(), size);
+	std::shared_ptr<CanvasWidget> widget = makeWidget<CanvasWidget>(getCanvasRender(), size);
 	widget->setWeakPtr(widget);
 	return widget;
 }
@@ -0,0 +1,301 @@
+#include <algorithm>
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <SDL2/SDL.h>
+#include <SDL2/SDL_image.h>
+
+#include "video/atlas.h"
+#include "video/atlaspacker.h"
+
+namespace flat
+{
+namespace video
+{
+
+namespace
+{
+constexpr int CACHE_VERSION = 1;
+
+// 0 if the file does not exist, so that a missing image invalidates the cache when it comes back
+std::int64_t getWriteTime(const std::string& fileName)
+{
+	std::error_code error;
+	const std::filesystem::file_time_type writeTime = std::filesystem::last_write_time(fileName, error);
+	return error ? 0 : static_cast<std::int64_t>(writeTime.time_since_epoch().count());
+}
+}
+
+Atlas::Atlas(const std::vector<std::string>& fileNames, const std::string& cacheFileName, int maxSize, int padding) :
+	m_loadedFromCache(false)
+{
+	FLAT_ASSERT(maxSize > 0 && padding >= 0);
+	m_surface = nullptr;
+	m_fileName = cacheFileName;
+
+	if (!cacheFileName.empty() && loadCache(fileNames, cacheFileName, maxSize, padding))
+	{
+		m_loadedFromCache = true;
+	}
+	else if (pack(fileNames, maxSize, padding))
+	{
+		if (!cacheFileName.empty())
+		{
+			saveCache(fileNames, cacheFileName, maxSize, padding);
+		}
+	}
+	else
+	{
+		m_regions.clear();
+		createPlaceholderTexture();
+	}
+
+	for (size_t i = 0; i < m_regions.size(); ++i)
+	{
+		setRegionUvs(m_regions[i]);
+		m_regionIndices[m_regions[i].fileName] = i;
+	}
+
+	load();
+}
+
+const AtlasRegion* Atlas::getRegion(const std::string& fileName) const
+{
+	std::unordered_map<std::string, size_t>::const_iterator it = m_regionIndices.find(fileName);
+	return it != m_regionIndices.end() ? &m_regions[it->second] : nullptr;
+}
+
+float Atlas::getUtilization() const
+{
+	double regionsArea = 0.0;
+	for (const AtlasRegion& region : m_regions)
+	{
+		regionsArea += static_cast<double>(region.size.x) * region.size.y;
+	}
+	return static_cast<float>(regionsArea / (static_cast<double>(m_size.x) * m_size.y));
+}
+
+bool Atlas::pack(const std::vector<std::string>& fileNames, int maxSize, int padding)
+{
+	std::vector<SDL_Surface*> images;
+	images.reserve(fileNames.size());
+	long long totalArea = 0;
+	for (const std::string& fileName : fileNames)
+	{
+		SDL_Surface* image = IMG_Load(fileName.c_str());
+		if (image == nullptr)
+		{
+			std::cerr << "Warning: error in IMG_Load(" << fileName.c_str() << ") : " << IMG_GetError() << std::endl;
+		}
+		else
+		{
+			totalArea += static_cast<long long>(image->w + padding) * (image->h + padding);
+		}
+		images.push_back(image);
+	}
+
+	// large images first, they are the hardest to place
+	std::vector<size_t> order;
+	for (size_t i = 0; i < images.size(); ++i)
+	{
+		if (images[i] != nullptr)
+		{
+			order.push_back(i);
+		}
+	}
+	std::sort(order.begin(), order.end(), [&images](size_t a, size_t b)
+	{
+		const int maxSideA = std::max(images[a]->w, images[a]->h);
+		const int maxSideB = std::max(images[b]->w, images[b]->h);
+		return maxSideA != maxSideB ? maxSideA > maxSideB : images[a]->h > images[b]->h;
+	});
+
+	// smallest power of two sizes that fit, growing the width and the height in turn
+	int width = 1;
+	int height = 1;
+	while (static_cast<long long>(width) * height < totalArea)
+	{
+		(width <= height ? width : height) *= 2;
+	}
+
+	std::vector<AtlasPacker::Rectangle> rectangles(images.size());
+	AtlasPacker packer(width, height);
+	bool packed = false;
+	while (!packed && width <= maxSize && height <= maxSize)
+	{
+		packer.reset(width, height);
+		packed = std::all_of(order.begin(), order.end(), [&images, &rectangles, &packer, padding](size_t i)
+		{
+			return packer.insert(images[i]->w + padding, images[i]->h + padding, rectangles[i]);
+		});
+		if (!packed)
+		{
+			(width <= height ? width : height) *= 2;
+		}
+	}
+
+	if (packed)
+	{
+		// GL 3.3 does not require power of two textures, the unused right and bottom parts are cropped
+		int usedWidth = 0;
+		int usedHeight = 0;
+		for (size_t i : order)
+		{
+			usedWidth = std::max(usedWidth, rectangles[i].x + rectangles[i].width);
+			usedHeight = std::max(usedHeight, rectangles[i].y + rectangles[i].height);
+		}
+		m_surface = createSurface(std::max(usedWidth, 1), std::max(usedHeight, 1));
+		for (size_t i : order)
+		{
+			SDL_Surface* image = images[i];
+			SDL_SetSurfaceBlendMode(image, SDL_BLENDMODE_NONE);
+			SDL_Rect destination { rectangles[i].x, rectangles[i].y, image->w, image->h };
+			SDL_BlitSurface(image, nullptr, m_surface, &destination);
+		}
+
+		for (size_t i = 0; i < images.size(); ++i)
+		{
+			if (images[i] != nullptr)
+			{
+				AtlasRegion& region = m_regions.emplace_back();
+				region.fileName = fileNames[i];
+				region.position = Vector2(static_cast<float>(rectangles[i].x), static_cast<float>(rectangles[i].y));
+				region.size = Vector2(static_cast<float>(images[i]->w), static_cast<float>(images[i]->h));
+			}
+		}
+	}
+	else
+	{
+		std::cerr << "Warning: the images of atlas " << m_fileName << " do not fit in " << maxSize << "x" << maxSize << std::endl;
+	}
+
+	for (SDL_Surface* image : images)
+	{
+		SDL_FreeSurface(image);
+	}
+	return packed;
+}
+
+void Atlas::setRegionUvs(AtlasRegion& region) const
+{
+	const Vector2 atlasSize(static_cast<float>(m_surface->w), static_cast<float>(m_surface->h));
+	region.uvMin = region.position / atlasSize;
+	region.uvMax = (region.position + region.size) / atlasSize;
+
+	const Vector2& uvMin = region.uvMin;
+	const Vector2& uvMax = region.uvMax;
+	region.vertexUvs = {
+		Vector2(uvMin.x, uvMin.y),
+		Vector2(uvMax.x, uvMin.y),
+		Vector2(uvMin.x, uvMax.y),
+		Vector2(uvMax.x, uvMax.y),
+		Vector2(uvMin.x, uvMax.y),
+		Vector2(uvMax.x, uvMin.y)
+	};
+}
+
+bool Atlas::loadCache(const std::vector<std::string>& fileNames, const std::string& cacheFileName, int maxSize, int padding)
+{
+	std::ifstream file(cacheFileName);
+	if (!file.is_open())
+	{
+		return false;
+	}
+
+	// the cache is only valid for the same images, unchanged since, packed with the same settings
+	std::string magic;
+	int version = 0;
+	int cacheMaxSize = 0;
+	int cachePadding = 0;
+	size_t numFileNames = 0;
+	file >> magic >> version >> cacheMaxSize >> cachePadding >> numFileNames;
+	if (!file || magic != "flat-atlas" || version != CACHE_VERSION
+		|| cacheMaxSize != maxSize || cachePadding != padding || numFileNames != fileNames.size())
+	{
+		return false;
+	}
+
+	for (const std::string& fileName : fileNames)
+	{
+		std::int64_t writeTime = 0;
+		std::string cacheFileNameLine;
+		file >> writeTime;
+		file.get();
+		std::getline(file, cacheFileNameLine);
+		if (!file || cacheFileNameLine != fileName || writeTime != getWriteTime(fileName))
+		{
+			return false;
+		}
+	}
+
+	int width = 0;
+	int height = 0;
+	size_t numRegions = 0;
+	file >> width >> height >> numRegions;
+	if (!file || numRegions > fileNames.size())
+	{
+		return false;
+	}
+
+	std::vector<AtlasRegion> regions(numRegions);
+	for (AtlasRegion& region : regions)
+	{
+		file >> region.position.x >> region.position.y >> region.size.x >> region.size.y;
+		file.get();
+		std::getline(file, region.fileName);
+		if (!file)
+		{
+			return false;
+		}
+	}
+
+	SDL_Surface* surface = IMG_Load((cacheFileName + ".png").c_str());
+	if (surface == nullptr || surface->w != width || surface->h != height)
+	{
+		SDL_FreeSurface(surface);
+		return false;
+	}
+
+	m_surface = surface;
+	m_regions = std::move(regions);
+	return true;
+}
+
+void Atlas::saveCache(const std::vector<std::string>& fileNames, const std::string& cacheFileName, int maxSize, int padding) const
+{
+	if (IMG_SavePNG(m_surface, (cacheFileName + ".png").c_str()) != 0)
+	{
+		std::cerr << "Warning: error in IMG_SavePNG(" << cacheFileName.c_str() << ".png) : " << IMG_GetError() << std::endl;
+		return;
+	}
+
+	std::ofstream file(cacheFileName);
+	if (!file.is_open())
+	{
+		std::cerr << "Warning: could not write atlas cache " << cacheFileName << std::endl;
+		return;
+	}
+
+	// file names last on their line as they can contain spaces
+	file << "flat-atlas " << CACHE_VERSION << '\n'
+		<< maxSize << ' ' << padding << '\n'
+		<< fileNames.size() << '\n';
+	for (const std::string& fileName : fileNames)
+	{
+		file << getWriteTime(fileName) << ' ' << fileName << '\n';
+	}
+
+	file << m_surface->w << ' ' << m_surface->h << '\n'
+		<< m_regions.size() << '\n';
+	for (const AtlasRegion& region : m_regions)
+	{
+		file << region.position.x << ' ' << region.position.y << ' '
+			<< region.size.x << ' ' << region.size.y << ' ' << region.fileName << '\n';
+	}
+}
+
+} // video
+} // flat
+
+
@@ -0,0 +1,74 @@
+#ifndef FLAT_VIDEO_ATLAS_H
+#define FLAT_VIDEO_ATLAS_H
+
+#include <array>
+#include <vector>
+#include <string>
+#include <unordered_map>
+
+#include "video/filetexture.h"
+
+namespace flat
+{
+namespace video
+{
+
+// part of an atlas holding one of the packed images
+struct AtlasRegion
+{
+	std::string fileName;
+
+	// in pixels, from the top left corner of the atlas
+	Vector2 position;
+	Vector2 size;
+
+	// the same rectangle in texture coordinates
+	Vector2 uvMin;
+	Vector2 uvMax;
+
+	// uvs of the 6 vertices of a sprite showing the whole region, in the order of render::BaseSprite
+	std::array<Vector2, 6> vertexUvs;
+};
+
+// several images packed in a single texture so that sprites using any of them can be drawn together
+// packing is done with AtlasPacker when the atlas is created, unless a cache built from the same images is found:
+// the cache is the packed image saved as <cacheFileName>.png and the regions saved as text in <cacheFileName>
+class Atlas : public FileTexture
+{
+	public:
+		static constexpr int DEFAULT_MAX_SIZE = 4096;
+		static constexpr int DEFAULT_PADDING = 1;
+
+	public:
+		// an empty cache file name disables the cache
+		Atlas(const std::vector<std::string>& fileNames, const std::string& cacheFileName = "", int maxSize = DEFAULT_MAX_SIZE, int padding = DEFAULT_PADDING);
+		~Atlas() override = default;
+
+		// nullptr if the image is not in the atlas
+		const AtlasRegion* getRegion(const std::string& fileName) const;
+		inline const std::vector<AtlasRegion>& getRegions() const { return m_regions; }
+
+		// ratio of the atlas area covered by the images
+		float getUtilization() const;
+
+		inline bool isLoadedFromCache() const { return m_loadedFromCache; }
+
+	private:
+		bool pack(const std::vector<std::string>& fileNames, int maxSize, int padding);
+		void setRegionUvs(AtlasRegion& region) const;
+
+		bool loadCache(const std::vector<std::string>& fileNames, const std::string& cacheFileName, int maxSize, int padding);
+		void saveCache(const std::vector<std::string>& fileNames, const std::string& cacheFileName, int maxSize, int padding) const;
+
+	private:
+		std::vector<AtlasRegion> m_regions;
+		std::unordered_map<std::string, size_t> m_regionIndices;
+		bool m_loadedFromCache;
+};
+
+} // video
+} // flat
+
+#endif // FLAT_VIDEO_ATLAS_H
+
+
@@ -0,0 +1,166 @@
+#include <algorithm>
+#include <limits>
+
+#include "video/atlaspacker.h"
+
+#include "debug/assert.h"
+
+namespace flat
+{
+namespace video
+{
+
+AtlasPacker::AtlasPacker(int width, int height)
+{
+	reset(width, height);
+}
+
+void AtlasPacker::reset(int width, int height)
+{
+	FLAT_ASSERT(width > 0 && height > 0);
+	m_width = width;
+	m_height = height;
+	m_usedArea = 0;
+	m_freeRectangles.clear();
+	m_freeRectangles.push_back({ 0, 0, width, height });
+}
+
+bool AtlasPacker::insert(int width, int height, Rectangle& rectangle)
+{
+	FLAT_ASSERT(width > 0 && height > 0);
+
+	const Rectangle* bestFreeRectangle = nullptr;
+	int bestShortSide = std::numeric_limits<int>::max();
+	int bestLongSide = std::numeric_limits<int>::max();
+	for (const Rectangle& freeRectangle : m_freeRectangles)
+	{
+		if (freeRectangle.width < width || freeRectangle.height < height)
+		{
+			continue;
+		}
+		const int leftoverWidth = freeRectangle.width - width;
+		const int leftoverHeight = freeRectangle.height - height;
+		const int shortSide = std::min(leftoverWidth, leftoverHeight);
+		const int longSide = std::max(leftoverWidth, leftoverHeight);
+		if (shortSide < bestShortSide || (shortSide == bestShortSide && longSide < bestLongSide))
+		{
+			bestFreeRectangle = &freeRectangle;
+			bestShortSide = shortSide;
+			bestLongSide = longSide;
+		}
+	}
+
+	if (bestFreeRectangle == nullptr)
+	{
+		return false;
+	}
+
+	rectangle = { bestFreeRectangle->x, bestFreeRectangle->y, width, height };
+
+	// every free rectangle intersecting the new one is replaced by its uncovered parts
+	m_newFreeRectangles.clear();
+	for (size_t i = 0; i < m_freeRectangles.size();)
+	{
+		if (splitFreeRectangle(m_freeRectangles[i], rectangle))
+		{
+			m_freeRectangles[i] = m_freeRectangles.back();
+			m_freeRectangles.pop_back();
+		}
+		else
+		{
+			++i;
+		}
+	}
+	m_freeRectangles.insert(m_freeRectangles.end(), m_newFreeRectangles.begin(), m_newFreeRectangles.end());
+	pruneFreeRectangles();
+
+	m_usedArea += static_cast<long long>(width) * height;
+	return true;
+}
+
+float AtlasPacker::getOccupancy() const
+{
+	return static_cast<float>(static_cast<double>(m_usedArea) / (static_cast<double>(m_width) * m_height));
+}
+
+bool AtlasPacker::splitFreeRectangle(const Rectangle& freeRectangle, const Rectangle& usedRectangle)
+{
+	const int freeRight = freeRectangle.x + freeRectangle.width;
+	const int freeBottom = freeRectangle.y + freeRectangle.height;
+	const int usedRight = usedRectangle.x + usedRectangle.width;
+	const int usedBottom = usedRectangle.y + usedRectangle.height;
+
+	if (usedRectangle.x >= freeRight || usedRight <= freeRectangle.x
+		|| usedRectangle.y >= freeBottom || usedBottom <= freeRectangle.y)
+	{
+		return false;
+	}
+
+	// above and below the used rectangle, full width
+	if (usedRectangle.y > freeRectangle.y)
+	{
+		m_newFreeRectangles.push_back({ freeRectangle.x, freeRectangle.y, freeRectangle.width, usedRectangle.y - freeRectangle.y });
+	}
+	if (usedBottom < freeBottom)
+	{
+		m_newFreeRectangles.push_back({ freeRectangle.x, usedBottom, freeRectangle.width, freeBottom - usedBottom });
+	}
+
+	// left and right of the used rectangle, full height
+	if (usedRectangle.x > freeRectangle.x)
+	{
+		m_newFreeRectangles.push_back({ freeRectangle.x, freeRectangle.y, usedRectangle.x - freeRectangle.x, freeRectangle.height });
+	}
+	if (usedRight < freeRight)
+	{
+		m_newFreeRectangles.push_back({ usedRight, freeRectangle.y, freeRight - usedRight, freeRectangle.height });
+	}
+
+	return true;
+}
+
+void AtlasPacker::pruneFreeRectangles()
+{
+	// a free rectangle inside another one is redundant
+	for (size_t i = 0; i < m_freeRectangles.size();)
+	{
+		bool isRedundant = false;
+		for (size_t j = i + 1; j < m_freeRectangles.size();)
+		{
+			if (contains(m_freeRectangles[j], m_freeRectangles[i]))
+			{
+				isRedundant = true;
+				break;
+			}
+			if (contains(m_freeRectangles[i], m_freeRectangles[j]))
+			{
+				m_freeRectangles.erase(m_freeRectangles.begin() + j);
+			}
+			else
+			{
+				++j;
+			}
+		}
+
+		if (isRedundant)
+		{
+			m_freeRectangles.erase(m_freeRectangles.begin() + i);
+		}
+		else
+		{
+			++i;
+		}
+	}
+}
+
+bool AtlasPacker::contains(const Rectangle& a, const Rectangle& b)
+{
+	return b.x >= a.x && b.y >= a.y
+		&& b.x + b.width <= a.x + a.width
+		&& b.y + b.height <= a.y + a.height;
+}
+
+} // video
+} // flat
+
+
@@ -0,0 +1,59 @@
+#ifndef FLAT_VIDEO_ATLASPACKER_H
+#define FLAT_VIDEO_ATLASPACKER_H
+
+#include <vector>
+
+namespace flat
+{
+namespace video
+{
+
+// MaxRects bin packing with the best short side fit heuristic: the free space is kept as the list of the largest
+// free rectangles, which can overlap, and each rectangle goes where it leaves the smallest leftover on its shortest side
+class AtlasPacker
+{
+	public:
+		struct Rectangle
+		{
+			int x;
+			int y;
+			int width;
+			int height;
+		};
+
+	public:
+		AtlasPacker(int width, int height);
+		~AtlasPacker() = default;
+
+		void reset(int width, int height);
+
+		// returns false if the rectangle does not fit anywhere, rectangles are never rotated
+		bool insert(int width, int height, Rectangle& rectangle);
+
+		inline int getWidth() const { return m_width; }
+		inline int getHeight() const { return m_height; }
+
+		// ratio of the area covered by inserted rectangles
+		float getOccupancy() const;
+
+	private:
+		// pushes the parts of freeRectangle not covered by usedRectangle, returns false if they do not intersect
+		bool splitFreeRectangle(const Rectangle& freeRectangle, const Rectangle& usedRectangle);
+		void pruneFreeRectangles();
+
+		static bool contains(const Rectangle& a, const Rectangle& b);
+
+	private:
+		std::vector<Rectangle> m_freeRectangles;
+		std::vector<Rectangle> m_newFreeRectangles;
+		long long m_usedArea;
+		int m_width;
+		int m_height;
+};
+
+} // video
+} // flat
+
+#endif // FLAT_VIDEO_ATLASPACKER_H
+
+
@@ -4,6 +4,7 @@
 #include <GL/glew.h>
 
 #include "video/filetexture.h"
+#include "memory/memorytracker.h"
 
 namespace flat
 {
@@ -82,6 +83,9 @@ void FileTexture::load()
 	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
 	glBindTexture(GL_TEXTURE_2D, 0);
 
+	// the surface is kept for getPixel()
+	FLAT_TRACK_ALLOCATION(memory::MemoryTag::RESOURCE, getSurfaceBytes());
+
 	m_requiresAlphaBlending = false;
 	for (int i = 0; i < m_surface->w * m_surface->h; ++i)
 	{
@@ -98,6 +102,11 @@ void FileTexture::load()
 
 void FileTexture::free()
 {
+	// only loaded surfaces are tracked
+	if (m_surface != nullptr && m_textureId != 0)
+	{
+		FLAT_TRACK_FREE(memory::MemoryTag::RESOURCE, getSurfaceBytes());
+	}
 	glDeleteTextures(1, &m_textureId);
 	SDL_FreeSurface(m_surface);
 	m_surface = nullptr;
@@ -107,6 +116,25 @@ void FileTexture::createPlaceholderTexture()
 {
 	SDL_FreeSurface(m_surface);
 
+	m_surface = createSurface(32, 32);
+
+	if (m_surface != nullptr)
+	{
+		SDL_FillRect(m_surface, nullptr, SDL_MapRGB(m_surface->format, 255, 0, 255));
+	}
+	else
+	{
+		std::cerr << "Warning: error in SDL_CreateRGBSurface() : " << IMG_GetError() << std::endl;
+	}
+}
+
+size_t FileTexture::getSurfaceBytes() const
+{
+	return static_cast<size_t>(m_surface->pitch) * m_surface->h;
+}
+
+SDL_Surface* FileTexture::createSurface(int width, int height)
+{
 #if SDL_BYTEORDER == SDL_BIG_ENDIAN
 	std::uint32_t rmask = 0xff000000;
 	std::uint32_t gmask = 0x00ff0000;
@@ -120,16 +148,7 @@ void FileTexture::createPlaceholderTexture()
 #endif
 
 
-	m_surface = SDL_CreateRGBSurface(0, 32, 32, 32, rmask, gmask, bmask, amask);
-
-	if (m_surface != nullptr)
-	{
-		SDL_FillRect(m_surface, nullptr, SDL_MapRGB(m_surface->format, 255, 0, 255));
-	}
-	else
-	{
-		std::cerr << "Warning: error in SDL_CreateRGBSurface() : " << IMG_GetError() << std::endl;
-	}
+	return SDL_CreateRGBSurface(0, width, height, 32, rmask, gmask, bmask, amask);
 }
 
 } // video
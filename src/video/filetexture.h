@@ -32,6 +32,11 @@ class FileTexture : public Texture
 
 		void createPlaceholderTexture();
 
+		// 32 bits surface with the RGBA byte order expected by load()
+		static SDL_Surface* createSurface(int width, int height);
+
+		size_t getSurfaceBytes() const;
+
 	protected:
 		
 		SDL_Surface* m_surface;
@@ -1,5 +1,7 @@
 #include "video/font/font.h"
 
+#include "memory/memorytracker.h"
+
 namespace flat
 {
 namespace video
@@ -30,6 +32,7 @@ Font::Font(const std::string& font, int size) :
 	glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, static_cast<GLsizei>(m_atlasSize.x), static_cast<GLsizei>(m_atlasSize.y), 0, GL_RGBA, GL_UNSIGNED_BYTE, 0);
 	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
 	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+	FLAT_TRACK_ALLOCATION(memory::MemoryTag::RESOURCE, getAtlasBytes());
 	
 	x = 0;
 	for (char c = ATLAS_FIRST_CHAR; c <= ATLAS_LAST_CHAR; ++c)
@@ -80,6 +83,7 @@ Font::~Font()
 	TTF_CloseFont(m_font);
 	m_font = nullptr;
 	glDeleteTextures(1, &m_atlasId);
+	FLAT_TRACK_FREE(memory::MemoryTag::RESOURCE, getAtlasBytes());
 }
 
 void Font::open()
@@ -107,6 +111,12 @@ Font::CharInfo& Font::getCharInfo(char c)
 	return m_chars[c - ATLAS_FIRST_CHAR];
 }
 
+size_t Font::getAtlasBytes() const
+{
+	// the glyphs only live in the atlas texture
+	return static_cast<size_t>(m_atlasSize.x) * static_cast<size_t>(m_atlasSize.y) * 4;
+}
+
 } // font
 } // video
 } // flat
@@ -53,6 +53,7 @@ class Font
 		
 	protected:
 		CharInfo& getCharInfo(char c);
+		size_t getAtlasBytes() const;
 		
 		enum { ATLAS_FIRST_CHAR = 32, ATLAS_LAST_CHAR = 126, ATLAS_NUM_CHARS = ATLAS_LAST_CHAR - ATLAS_FIRST_CHAR + 1 };
 		
@@ -0,0 +1,183 @@
+#include "video/streambuffer.h"
+
+#include "memory/memorytracker.h"
+#include "profiler/profiler.h"
+#include "debug/assert.h"
+
+namespace flat
+{
+namespace video
+{
+
+namespace
+{
+constexpr size_t MIN_REGION_SIZE = 64 * 1024;
+constexpr size_t ALIGNMENT = 16;
+constexpr GLuint64 WAIT_TIMEOUT = 1000000000; // 1s in ns
+}
+
+StreamBuffer::StreamBuffer(GLenum target, int numRegions) :
+	m_fences(numRegions, nullptr),
+	m_bufferId(0),
+	m_target(target),
+	m_regionSize(0),
+	m_currentRegion(0),
+	m_head(0),
+	m_mappedOffset(0),
+	m_persistentPointer(nullptr),
+	m_isMapped(false)
+{
+	FLAT_ASSERT(numRegions >= 2);
+}
+
+StreamBuffer::~StreamBuffer()
+{
+	destroy();
+}
+
+void* StreamBuffer::map(size_t numBytes)
+{
+	FLAT_ASSERT(!m_isMapped && numBytes > 0);
+
+	if (numBytes > m_regionSize)
+	{
+		// the previous buffer is released by the driver once the pending draws are done
+		destroy();
+		size_t regionSize = MIN_REGION_SIZE;
+		while (regionSize < numBytes)
+		{
+			regionSize *= 2;
+		}
+		create(regionSize);
+	}
+	else
+	{
+		glBindBuffer(m_target, m_bufferId);
+	}
+
+	// a write range never straddles two regions
+	size_t offset = (m_head + ALIGNMENT - 1) & ~(ALIGNMENT - 1);
+	if (offset >= getSize())
+	{
+		offset = 0;
+	}
+	size_t regionIndex = offset / m_regionSize;
+	if (offset + numBytes > (regionIndex + 1) * m_regionSize)
+	{
+		regionIndex = (regionIndex + 1) % m_fences.size();
+		offset = regionIndex * m_regionSize;
+	}
+
+	if (regionIndex != m_currentRegion)
+	{
+		enterRegion(regionIndex);
+	}
+
+	m_head = offset + numBytes;
+	m_mappedOffset = offset;
+	m_isMapped = true;
+
+	if (m_persistentPointer != nullptr)
+	{
+		return static_cast<char*>(m_persistentPointer) + offset;
+	}
+
+	// synchronization is done with the region fences
+	return glMapBufferRange(m_target, offset, numBytes, GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_RANGE_BIT | GL_MAP_UNSYNCHRONIZED_BIT);
+}
+
+void StreamBuffer::unmap()
+{
+	FLAT_ASSERT(m_isMapped);
+	if (m_persistentPointer == nullptr)
+	{
+		glUnmapBuffer(m_target);
+	}
+	m_isMapped = false;
+}
+
+bool StreamBuffer::isPersistentMappingSupported()
+{
+	return GLEW_ARB_buffer_storage != 0;
+}
+
+void StreamBuffer::create(size_t regionSize)
+{
+	FLAT_ASSERT(m_bufferId == 0);
+	m_regionSize = regionSize;
+	m_currentRegion = 0;
+	m_head = 0;
+
+	const size_t size = getSize();
+	glGenBuffers(1, &m_bufferId);
+	glBindBuffer(m_target, m_bufferId);
+	if (isPersistentMappingSupported())
+	{
+		// coherent: writes are visible to the GPU without flushing
+		const GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+		glBufferStorage(m_target, size, nullptr, flags);
+		m_persistentPointer = glMapBufferRange(m_target, 0, size, flags);
+		FLAT_ASSERT(m_persistentPointer != nullptr);
+	}
+	else
+	{
+		glBufferData(m_target, size, nullptr, GL_STREAM_DRAW);
+	}
+	FLAT_TRACK_ALLOCATION(memory::MemoryTag::RENDER, size);
+}
+
+void StreamBuffer::destroy()
+{
+	if (m_bufferId == 0)
+	{
+		return;
+	}
+
+	for (GLsync& fence : m_fences)
+	{
+		if (fence != nullptr)
+		{
+			glDeleteSync(fence);
+			fence = nullptr;
+		}
+	}
+
+	if (m_persistentPointer != nullptr)
+	{
+		glBindBuffer(m_target, m_bufferId);
+		glUnmapBuffer(m_target);
+		m_persistentPointer = nullptr;
+	}
+
+	glDeleteBuffers(1, &m_bufferId);
+	m_bufferId = 0;
+	FLAT_TRACK_FREE(memory::MemoryTag::RENDER, getSize());
+	m_regionSize = 0;
+}
+
+void StreamBuffer::enterRegion(size_t regionIndex)
+{
+	FLAT_ASSERT(m_fences[m_currentRegion] == nullptr);
+	m_fences[m_currentRegion] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+
+	GLsync& fence = m_fences[regionIndex];
+	if (fence != nullptr)
+	{
+		FLAT_PROFILE("Wait stream buffer region");
+		GLenum result;
+		do
+		{
+			result = glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, WAIT_TIMEOUT);
+		}
+		while (result == GL_TIMEOUT_EXPIRED);
+		FLAT_ASSERT(result != GL_WAIT_FAILED);
+		glDeleteSync(fence);
+		fence = nullptr;
+	}
+	m_currentRegion = regionIndex;
+}
+
+} // video
+} // flat
+
+
@@ -0,0 +1,66 @@
+#ifndef FLAT_VIDEO_STREAMBUFFER_H
+#define FLAT_VIDEO_STREAMBUFFER_H
+
+#include <vector>
+#include <GL/glew.h>
+
+namespace flat
+{
+namespace video
+{
+
+// ring buffer for data written by the CPU every frame and read once by the GPU (vertices...)
+// the buffer is split in regions, each region is fenced when the writes move to the next one and is only
+// written again once the GPU is done with it, so that the CPU fills a region while the GPU reads the previous ones
+// the buffer stays persistently mapped when ARB_buffer_storage is available, otherwise each write range is mapped unsynchronized
+class StreamBuffer
+{
+	public:
+		static constexpr int DEFAULT_NUM_REGIONS = 3;
+
+	public:
+		explicit StreamBuffer(GLenum target, int numRegions = DEFAULT_NUM_REGIONS);
+		StreamBuffer(const StreamBuffer&) = delete;
+		StreamBuffer(StreamBuffer&&) = delete;
+		~StreamBuffer();
+
+		void operator=(const StreamBuffer&) = delete;
+		void operator=(StreamBuffer&&) = delete;
+
+		// binds the buffer and returns where to write numBytes, the data is at getMappedOffset() in the buffer
+		// the buffer grows if a region is too small, the commands reading the data must be issued before the next map()
+		void* map(size_t numBytes);
+		void unmap();
+
+		inline GLuint getBufferId() const { return m_bufferId; }
+		inline size_t getMappedOffset() const { return m_mappedOffset; }
+		inline size_t getSize() const { return m_regionSize * m_fences.size(); }
+		inline bool isPersistentlyMapped() const { return m_persistentPointer != nullptr; }
+
+		static bool isPersistentMappingSupported();
+
+	private:
+		void create(size_t regionSize);
+		void destroy();
+
+		// fences the current region and waits until the GPU is done with the given one
+		void enterRegion(size_t regionIndex);
+
+	private:
+		std::vector<GLsync> m_fences;
+		GLuint m_bufferId;
+		GLenum m_target;
+		size_t m_regionSize;
+		size_t m_currentRegion;
+		size_t m_head;
+		size_t m_mappedOffset;
+		void* m_persistentPointer;
+		bool m_isMapped;
+};
+
+} // video
+} // flat
+
+#endif // FLAT_VIDEO_STREAMBUFFER_H
+
+
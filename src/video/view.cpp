@@ -91,6 +91,20 @@ void View::getScreenAABB(flat::AABB2& aabb) const
 	std::swap(aabb.min.y, aabb.max.y);
 }
 
+void View::getVisibleAABB(flat::AABB2& aabb) const
+{
+	const Matrix4 matrix = inverse(getViewProjectionMatrix());
+	const Vector2 corners[] = { Vector2(-1.f, -1.f), Vector2(1.f, -1.f), Vector2(-1.f, 1.f), Vector2(1.f, 1.f) };
+	aabb.min = Vector2(matrix * Vector4(corners[0], 0.f, 1.f));
+	aabb.max = aabb.min;
+	for (int i = 1; i < 4; ++i)
+	{
+		const Vector2 corner(matrix * Vector4(corners[i], 0.f, 1.f));
+		aabb.min = glm::min(aabb.min, corner);
+		aabb.max = glm::max(aabb.max, corner);
+	}
+}
+
 } // video
 } // flat
 
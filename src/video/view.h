@@ -37,6 +37,10 @@ class View
 		void updateProjection();
 
 		void getScreenAABB(flat::AABB2& aabb) const;
+
+		// world rectangle covered by the projection, does not need the window
+		// exact when the view is only rotated around z, otherwise the plane z = 0 is not what is seen
+		void getVisibleAABB(flat::AABB2& aabb) const;
 		
 		inline const Matrix4& getProjectionMatrix() const { return m_projectionMatrix; }
 		inline const Matrix4& getViewMatrix() const { return m_viewMatrix; }
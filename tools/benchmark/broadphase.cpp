@@ -0,0 +1,217 @@
+// correctness check and benchmark for geometry::Broadphase
+// standalone, build from the repository root with:
+//   g++ -std=c++17 -O2 -Isrc tools/benchmark/broadphase.cpp src/geometry/broadphase.cpp -o broadphase
+// usage: broadphase [numProxies] [numFrames]
+// the target is 50k moving AABBs under 2 ms per findPairs on one core, the median frame is compared to it
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstdint>
+#include <set>
+#include <vector>
+
+#include "geometry/broadphase.h"
+
+using flat::AABB2;
+using flat::Vector2;
+using flat::geometry::Broadphase;
+
+namespace
+{
+
+constexpr double TARGET_MS = 2.0;
+constexpr int DEFAULT_NUM_PROXIES = 50000;
+constexpr int DEFAULT_NUM_FRAMES = 100;
+constexpr float WORLD_SIZE = 2000.f;
+
+class Random
+{
+	public:
+		explicit Random(std::uint32_t seed) : m_state(seed) {}
+
+		// in [0, 1)
+		float next()
+		{
+			m_state = m_state * 1103515245u + 12345u;
+			return static_cast<float>((m_state >> 8) % 100000) / 100000.f;
+		}
+
+	private:
+		std::uint32_t m_state;
+};
+
+struct TestProxy
+{
+	AABB2 aabb;
+	std::uint32_t layer;
+	std::uint32_t mask;
+	int id;
+};
+
+std::set<Broadphase::Pair> findPairsBruteForce(const std::vector<TestProxy>& proxies)
+{
+	std::set<Broadphase::Pair> pairs;
+	for (size_t i = 0; i < proxies.size(); ++i)
+	{
+		for (size_t j = i + 1; j < proxies.size(); ++j)
+		{
+			const TestProxy& a = proxies[i];
+			const TestProxy& b = proxies[j];
+			if (a.id >= 0 && b.id >= 0 && AABB2::overlap(a.aabb, b.aabb) && (a.layer & b.mask) != 0 && (b.layer & a.mask) != 0)
+			{
+				pairs.emplace(std::min(a.id, b.id), std::max(a.id, b.id));
+			}
+		}
+	}
+	return pairs;
+}
+
+int checkPairs(Broadphase& broadphase, const std::vector<TestProxy>& proxies, const char* step)
+{
+	std::set<Broadphase::Pair> pairs;
+	int numDuplicates = 0;
+	for (const Broadphase::Pair& pair : broadphase.findPairs())
+	{
+		numDuplicates += pair.first < pair.second && pairs.insert(pair).second ? 0 : 1;
+	}
+	const std::set<Broadphase::Pair> expectedPairs = findPairsBruteForce(proxies);
+	const int numErrors = numDuplicates + (pairs == expectedPairs ? 0 : 1);
+	std::printf("%-28s %5zu pairs, %zu expected: %s\n", step, pairs.size(), expectedPairs.size(), numErrors == 0 ? "ok" : "FAILED");
+	return numErrors;
+}
+
+// mixed sizes, layers and masks, then moves, removals, additions and a change of scale
+int check()
+{
+	Random random(9);
+	Broadphase broadphase;
+	std::vector<TestProxy> proxies;
+	for (int i = 0; i < 3000; ++i)
+	{
+		const Vector2 min(random.next() * 200.f, random.next() * 200.f);
+		// a few tall or wide proxies span many bands
+		const float scale = i % 50 == 0 ? 40.f : 3.f;
+		const AABB2 aabb(min, min + Vector2(random.next() * scale, random.next() * scale));
+		const std::uint32_t layer = 1u << (i % 3);
+		const std::uint32_t mask = i % 3 == 2 ? 1u : Broadphase::ALL_LAYERS;
+		proxies.push_back({ aabb, layer, mask, broadphase.addProxy(aabb, layer, mask) });
+	}
+
+	int numErrors = checkPairs(broadphase, proxies, "added");
+
+	for (TestProxy& proxy : proxies)
+	{
+		const Vector2 move((random.next() - 0.5f) * 4.f, (random.next() - 0.5f) * 4.f);
+		proxy.aabb = AABB2(proxy.aabb.min + move, proxy.aabb.max + move);
+		broadphase.updateProxy(proxy.id, proxy.aabb);
+	}
+	numErrors += checkPairs(broadphase, proxies, "moved");
+
+	for (size_t i = 0; i < proxies.size(); i += 5)
+	{
+		broadphase.removeProxy(proxies[i].id);
+		proxies[i].id = -1;
+	}
+	numErrors += checkPairs(broadphase, proxies, "removed");
+
+	// the removed ids are reused
+	for (size_t i = 0; i < proxies.size(); i += 10)
+	{
+		TestProxy& proxy = proxies[i];
+		proxy.id = broadphase.addProxy(proxy.aabb, proxy.layer, proxy.mask);
+	}
+	numErrors += checkPairs(broadphase, proxies, "added again");
+
+	for (size_t i = 1; i < proxies.size(); i += 7)
+	{
+		TestProxy& proxy = proxies[i];
+		if (proxy.id >= 0)
+		{
+			proxy.layer = 1;
+			proxy.mask = 2;
+			broadphase.setProxyLayer(proxy.id, proxy.layer, proxy.mask);
+		}
+	}
+	numErrors += checkPairs(broadphase, proxies, "layers changed");
+
+	// every proxy gets much bigger, the bands are laid out again
+	for (TestProxy& proxy : proxies)
+	{
+		proxy.aabb = AABB2(proxy.aabb.min * 0.5f, proxy.aabb.min * 0.5f + (proxy.aabb.max - proxy.aabb.min) * 4.f);
+		if (proxy.id >= 0)
+		{
+			broadphase.updateProxy(proxy.id, proxy.aabb);
+		}
+	}
+	numErrors += checkPairs(broadphase, proxies, "scaled");
+
+	// mostly flat proxies, the average height is tiny
+	Broadphase flatBroadphase;
+	std::vector<TestProxy> flatProxies;
+	for (int i = 0; i < 1000; ++i)
+	{
+		const Vector2 min(random.next() * 50.f, random.next() * 50.f);
+		const AABB2 aabb(min, min + Vector2(2.f, i % 20 == 0 ? 5.f : 0.f));
+		flatProxies.push_back({ aabb, 1, Broadphase::ALL_LAYERS, flatBroadphase.addProxy(aabb) });
+	}
+	numErrors += checkPairs(flatBroadphase, flatProxies, "flat");
+
+	return numErrors;
+}
+
+// 4x4 AABBs moving randomly over the world, about 100 proxies share the x range of each one
+void benchmark(int numProxies, int numFrames)
+{
+	Random random(7);
+	Broadphase broadphase;
+	std::vector<AABB2> aabbs;
+	std::vector<Vector2> velocities;
+	std::vector<int> ids;
+	for (int i = 0; i < numProxies; ++i)
+	{
+		const Vector2 min(random.next() * WORLD_SIZE, random.next() * WORLD_SIZE);
+		aabbs.emplace_back(min, min + Vector2(4.f, 4.f));
+		velocities.emplace_back(random.next() - 0.5f, random.next() - 0.5f);
+		ids.push_back(broadphase.addProxy(aabbs.back()));
+	}
+	broadphase.findPairs();
+
+	std::vector<double> frameTimes;
+	size_t numPairs = 0;
+	for (int frame = 0; frame < numFrames; ++frame)
+	{
+		for (int i = 0; i < numProxies; ++i)
+		{
+			aabbs[i] = AABB2(aabbs[i].min + velocities[i], aabbs[i].max + velocities[i]);
+			broadphase.updateProxy(ids[i], aabbs[i]);
+		}
+		const auto start = std::chrono::steady_clock::now();
+		numPairs = broadphase.findPairs().size();
+		frameTimes.push_back(std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count());
+	}
+
+	std::sort(frameTimes.begin(), frameTimes.end());
+	const double medianTime = frameTimes[frameTimes.size() / 2];
+	std::printf("%d moving proxies, %zu pairs: best %.3f ms, median %.3f ms, worst %.3f ms per findPairs\n",
+		numProxies, numPairs, frameTimes.front(), medianTime, frameTimes.back());
+	if (numProxies == DEFAULT_NUM_PROXIES)
+	{
+		std::printf("target %.1f ms: %s\n", TARGET_MS, medianTime <= TARGET_MS ? "met" : "MISSED");
+	}
+}
+
+} // namespace
+
+int main(int argc, char* argv[])
+{
+	const int numProxies = argc > 1 ? std::max(std::atoi(argv[1]), 1) : DEFAULT_NUM_PROXIES;
+	const int numFrames = argc > 2 ? std::max(std::atoi(argv[2]), 1) : DEFAULT_NUM_FRAMES;
+
+	const int numErrors = check();
+	benchmark(numProxies, numFrames);
+	return numErrors == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+
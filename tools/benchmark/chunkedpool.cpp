@@ -0,0 +1,195 @@
+// benchmark of containers::ChunkedPool against new/delete and containers::Pool
+// standalone, build from the repository root with:
+//   g++ -std=c++17 -O2 -pthread -Isrc tools/benchmark/chunkedpool.cpp -o chunkedpool
+// usage: chunkedpool [numLiveObjects] [numSteps]
+// fill: numLiveObjects objects are created then destroyed in a random order, churn: numLiveObjects objects stay alive
+// and at each step a random one is destroyed and a new one created, as timers are, then the live objects are read
+// in creation order, the chunked pool is measured directly and through a ThreadCache on a single thread
+// add -DFLAT_DEBUG to also run the pools' assertions, much slower
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include "containers/chunkedpool.h"
+#include "containers/pool.h"
+
+namespace
+{
+
+constexpr size_t MAX_LIVE_OBJECTS = 1 << 16;
+constexpr size_t DEFAULT_NUM_LIVE_OBJECTS = 10000;
+constexpr int DEFAULT_NUM_STEPS = 2000000;
+constexpr int NUM_FILL_ROUNDS = 20;
+
+// about the size of a timer
+struct Object
+{
+	explicit Object(std::uint32_t serial) :
+		serial(serial),
+		checksum(serial * 2654435761u)
+	{
+
+	}
+
+	bool isIntact() const { return checksum == serial * 2654435761u; }
+
+	std::uint32_t serial;
+	std::uint32_t checksum;
+	char padding[56];
+};
+
+using ChunkedPool = flat::containers::ChunkedPool<Object>;
+using Pool = flat::containers::Pool<Object, MAX_LIVE_OBJECTS>;
+
+class Random
+{
+	public:
+		explicit Random(std::uint32_t seed) : m_state(seed) {}
+
+		// in [0, max)
+		size_t next(size_t max)
+		{
+			m_state = m_state * 1103515245u + 12345u;
+			return (m_state >> 8) % max;
+		}
+
+	private:
+		std::uint32_t m_state;
+};
+
+struct NewDelete
+{
+	Object* create(std::uint32_t serial) { return new Object(serial); }
+	void destroy(Object* object) { delete object; }
+};
+
+struct Result
+{
+	double fillTime;
+	double churnTime;
+	double readTime;
+	int numErrors;
+};
+
+// nanoseconds per creation and destruction pair, and per object read
+template <class Allocator>
+Result benchmark(Allocator& allocator, size_t numLiveObjects, int numSteps)
+{
+	Result result;
+	result.numErrors = 0;
+	std::vector<Object*> objects(numLiveObjects);
+	std::uint32_t serial = 0;
+
+	Random random(3);
+	std::vector<size_t> destroyOrder(numLiveObjects);
+	for (size_t i = 0; i < numLiveObjects; ++i)
+	{
+		destroyOrder[i] = i;
+	}
+	for (size_t i = numLiveObjects - 1; i > 0; --i)
+	{
+		std::swap(destroyOrder[i], destroyOrder[random.next(i + 1)]);
+	}
+
+	auto start = std::chrono::steady_clock::now();
+	for (int round = 0; round < NUM_FILL_ROUNDS; ++round)
+	{
+		for (Object*& object : objects)
+		{
+			object = allocator.create(serial++);
+		}
+		for (size_t i : destroyOrder)
+		{
+			result.numErrors += objects[i]->isIntact() ? 0 : 1;
+			allocator.destroy(objects[i]);
+		}
+	}
+	result.fillTime = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count() / (static_cast<double>(numLiveObjects) * NUM_FILL_ROUNDS);
+
+	for (Object*& object : objects)
+	{
+		object = allocator.create(serial++);
+	}
+	start = std::chrono::steady_clock::now();
+	for (int step = 0; step < numSteps; ++step)
+	{
+		Object*& object = objects[random.next(numLiveObjects)];
+		result.numErrors += object->isIntact() ? 0 : 1;
+		allocator.destroy(object);
+		object = allocator.create(serial++);
+	}
+	result.churnTime = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count() / numSteps;
+
+	// the live objects are scattered after the churn
+	std::vector<Object*> creationOrder = objects;
+	std::sort(creationOrder.begin(), creationOrder.end(), [](const Object* a, const Object* b) { return a->serial < b->serial; });
+	std::uint32_t checksum = 0;
+	start = std::chrono::steady_clock::now();
+	for (int run = 0; run < NUM_FILL_ROUNDS; ++run)
+	{
+		for (const Object* object : creationOrder)
+		{
+			checksum += object->checksum;
+		}
+	}
+	result.readTime = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count() / (static_cast<double>(numLiveObjects) * NUM_FILL_ROUNDS);
+	result.numErrors += checksum == 0 ? 1 : 0;
+
+	for (Object* object : objects)
+	{
+		result.numErrors += object->isIntact() ? 0 : 1;
+		allocator.destroy(object);
+	}
+	return result;
+}
+
+int print(const char* name, const Result& result)
+{
+	std::printf("%-24s fill %7.2f ns, churn %7.2f ns per create and destroy, read %6.2f ns per object\n",
+		name, result.fillTime, result.churnTime, result.readTime);
+	return result.numErrors;
+}
+
+} // namespace
+
+int main(int argc, char* argv[])
+{
+	const size_t numLiveObjects = argc > 1 ? std::min(std::max(static_cast<size_t>(std::atoi(argv[1])), static_cast<size_t>(1)), MAX_LIVE_OBJECTS) : DEFAULT_NUM_LIVE_OBJECTS;
+	const int numSteps = argc > 2 ? std::max(std::atoi(argv[2]), 1) : DEFAULT_NUM_STEPS;
+	std::printf("%zu live objects of %zu bytes, %d churn steps\n", numLiveObjects, sizeof(Object), numSteps);
+
+	int numErrors = 0;
+	{
+		NewDelete newDelete;
+		numErrors += print("new/delete", benchmark(newDelete, numLiveObjects, numSteps));
+	}
+	{
+		// too large for the stack
+		std::unique_ptr<Pool> pool = std::make_unique<Pool>();
+		numErrors += print("Pool", benchmark(*pool, numLiveObjects, numSteps));
+	}
+	{
+		ChunkedPool chunkedPool;
+		numErrors += print("ChunkedPool", benchmark(chunkedPool, numLiveObjects, numSteps));
+		chunkedPool.shrink_to_fit();
+		numErrors += chunkedPool.getNumChunks() == 0 ? 0 : 1;
+	}
+	{
+		ChunkedPool chunkedPool;
+		{
+			ChunkedPool::ThreadCache threadCache(chunkedPool);
+			numErrors += print("ChunkedPool::ThreadCache", benchmark(threadCache, numLiveObjects, numSteps));
+		}
+		numErrors += chunkedPool.getNumAllocatedObjects() == 0 ? 0 : 1;
+	}
+
+	std::printf("objects intact and chunks released: %s\n", numErrors == 0 ? "ok" : "FAILED");
+	return numErrors == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+
@@ -0,0 +1,109 @@
+// benchmark of containers::HybridArray against std::vector for 0 to 16 elements
+// standalone, build from the repository root with:
+//   g++ -std=c++17 -O2 -Isrc tools/benchmark/hybridarray.cpp -o hybridarray
+// usage: hybridarray [numArrays]
+// each array is built with push_back, read once and destroyed, as the temporary lists of a query, the inline
+// capacity is 8 so sizes 9 to 16 show the move to the heap, then arrays are stored in a growing std::vector,
+// which only moves them instead of copying them when their move constructor is noexcept
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstdint>
+#include <type_traits>
+#include <vector>
+
+#include "containers/hybridarray.h"
+
+using flat::containers::HybridArray;
+
+namespace
+{
+
+constexpr int STATIC_SIZE = 8;
+constexpr int MAX_SIZE = 16;
+constexpr int DEFAULT_NUM_ARRAYS = 1000000;
+constexpr int NUM_STORED_ARRAYS = 100000;
+
+using SmallArray = HybridArray<int, STATIC_SIZE>;
+
+static_assert(std::is_nothrow_move_constructible<SmallArray>::value, "stored arrays would be copied");
+static_assert(std::is_nothrow_move_assignable<SmallArray>::value, "stored arrays would be copied");
+
+// nanoseconds per array, the sum of the elements is returned too
+template <class Array, bool Reserve>
+double timeArrays(int size, int numArrays, std::int64_t& checksum)
+{
+	const auto start = std::chrono::steady_clock::now();
+	for (int i = 0; i < numArrays; ++i)
+	{
+		Array array;
+		if (Reserve)
+		{
+			array.reserve(static_cast<unsigned int>(size));
+		}
+		for (int j = 0; j < size; ++j)
+		{
+			array.push_back(i + j);
+		}
+		for (int value : array)
+		{
+			checksum += value;
+		}
+	}
+	return std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count() / numArrays;
+}
+
+// milliseconds to push NUM_STORED_ARRAYS arrays of size elements in a std::vector without reserving it
+template <class Array>
+double timeStoredArrays(int size, std::int64_t& checksum)
+{
+	Array array;
+	for (int j = 0; j < size; ++j)
+	{
+		array.push_back(j);
+	}
+	const auto start = std::chrono::steady_clock::now();
+	std::vector<Array> arrays;
+	for (int i = 0; i < NUM_STORED_ARRAYS; ++i)
+	{
+		arrays.push_back(array);
+	}
+	checksum += static_cast<std::int64_t>(arrays.back().size());
+	return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+} // namespace
+
+int main(int argc, char* argv[])
+{
+	const int numArrays = argc > 1 ? std::max(std::atoi(argv[1]), 1) : DEFAULT_NUM_ARRAYS;
+
+	std::int64_t hybridArrayChecksum = 0;
+	std::int64_t vectorChecksum = 0;
+	std::int64_t reservedVectorChecksum = 0;
+	std::printf("size   HybridArray<int, %d>   std::vector<int>   reserved std::vector<int>   ns per array\n", STATIC_SIZE);
+	for (int size = 0; size <= MAX_SIZE; ++size)
+	{
+		const double hybridArrayTime = timeArrays<SmallArray, false>(size, numArrays, hybridArrayChecksum);
+		const double vectorTime = timeArrays<std::vector<int>, false>(size, numArrays, vectorChecksum);
+		const double reservedVectorTime = timeArrays<std::vector<int>, true>(size, numArrays, reservedVectorChecksum);
+		std::printf("%4d   %20.2f   %16.2f   %25.2f\n", size, hybridArrayTime, vectorTime, reservedVectorTime);
+	}
+
+	std::int64_t storedChecksum = 0;
+	std::printf("%d arrays pushed in a std::vector, ms\n", NUM_STORED_ARRAYS);
+	for (int size : { 4, 16 })
+	{
+		const double hybridArrayTime = timeStoredArrays<SmallArray>(size, storedChecksum);
+		const double vectorTime = timeStoredArrays<std::vector<int>>(size, storedChecksum);
+		std::printf("%4d   %20.2f   %16.2f\n", size, hybridArrayTime, vectorTime);
+	}
+
+	const bool isValid = hybridArrayChecksum == vectorChecksum && vectorChecksum == reservedVectorChecksum;
+	std::printf("same elements read from every array: %s\n", isValid ? "ok" : "FAILED");
+	return isValid ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+
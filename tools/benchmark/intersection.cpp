@@ -0,0 +1,435 @@
+// correctness check and benchmark for the batch versions of geometry::intersection
+// standalone, build from the repository root with:
+//   g++ -std=c++17 -O2 -Isrc tools/benchmark/intersection.cpp src/geometry/intersection.cpp -o intersection
+// usage: intersection [time [count]]
+// every instruction set the CPU supports is compared to the scalar functions, on counts that are not multiples
+// of the lanes, the AVX2 and SSE2 paths are turned off in turn with setMaxInstructionSet
+// with "time", each batch function then runs on count elements (100000 by default) with each instruction set
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include "geometry/intersection.h"
+
+using flat::AABB2;
+using flat::Vector2;
+namespace intersection = flat::geometry::intersection;
+using intersection::InstructionSet;
+
+namespace
+{
+
+constexpr size_t CHECKED_COUNTS[] = { 0, 1, 2, 3, 4, 5, 7, 8, 9, 12, 15, 16, 17, 31, 33, 100, 1001 };
+// written past the count, must be left untouched
+constexpr size_t GUARD_SIZE = 16;
+constexpr float GUARD = 12345.f;
+constexpr size_t DEFAULT_TIMED_COUNT = 100000;
+constexpr int NUM_TIMED_RUNS = 50;
+
+const char* getName(InstructionSet instructionSet)
+{
+	switch (instructionSet)
+	{
+		case InstructionSet::SCALAR: return "scalar";
+		case InstructionSet::SSE2: return "SSE2";
+		case InstructionSet::AVX2: return "AVX2";
+	}
+	return "?";
+}
+
+class Random
+{
+	public:
+		explicit Random(std::uint32_t seed) : m_state(seed) {}
+
+		// in [min, max), snapped to integers one time out of four so that ties, points on edges and
+		// parallel segments happen
+		float next(float min, float max)
+		{
+			m_state = m_state * 1103515245u + 12345u;
+			const float value = min + static_cast<float>((m_state >> 8) % 100000) / 100000.f * (max - min);
+			return (m_state >> 30) == 0 ? std::floor(value) : value;
+		}
+
+	private:
+		std::uint32_t m_state;
+};
+
+// structures of arrays with a guard after the used elements
+struct Vector2Array
+{
+	std::vector<float> x;
+	std::vector<float> y;
+
+	explicit Vector2Array(size_t count) : x(count + GUARD_SIZE, GUARD), y(count + GUARD_SIZE, GUARD) {}
+
+	void set(size_t i, const Vector2& v) { x[i] = v.x; y[i] = v.y; }
+	Vector2 get(size_t i) const { return Vector2(x[i], y[i]); }
+	intersection::Vector2Span span() const { return { x.data(), y.data() }; }
+	intersection::OutputVector2Span outputSpan() { intersection::OutputVector2Span span; span.x = x.data(); span.y = y.data(); return span; }
+};
+
+struct AABB2Array
+{
+	Vector2Array min;
+	Vector2Array max;
+
+	explicit AABB2Array(size_t count) : min(count), max(count) {}
+
+	void set(size_t i, const AABB2& aabb) { min.set(i, aabb.min); max.set(i, aabb.max); }
+	AABB2 get(size_t i) const { return AABB2(min.get(i), max.get(i)); }
+	intersection::AABB2Span span() const { return { min.span(), max.span() }; }
+};
+
+struct Input
+{
+	AABB2Array rectanglesA;
+	AABB2Array rectanglesB;
+	Vector2Array points;
+	std::vector<float> radii;
+	Vector2Array starts1;
+	Vector2Array ends1;
+	Vector2Array starts2;
+	Vector2Array ends2;
+
+	explicit Input(size_t count) :
+		rectanglesA(count),
+		rectanglesB(count),
+		points(count),
+		radii(count + GUARD_SIZE, GUARD),
+		starts1(count),
+		ends1(count),
+		starts2(count),
+		ends2(count)
+	{
+		Random random(static_cast<std::uint32_t>(count) + 1);
+		auto randomRectangle = [&random]()
+		{
+			const Vector2 min(random.next(-10.f, 10.f), random.next(-10.f, 10.f));
+			return AABB2(min, min + Vector2(random.next(0.f, 8.f), random.next(0.f, 8.f)));
+		};
+		auto randomPoint = [&random]()
+		{
+			return Vector2(random.next(-12.f, 12.f), random.next(-12.f, 12.f));
+		};
+		for (size_t i = 0; i < count; ++i)
+		{
+			rectanglesA.set(i, randomRectangle());
+			rectanglesB.set(i, randomRectangle());
+			points.set(i, randomPoint());
+			radii[i] = random.next(0.f, 3.f);
+			starts1.set(i, randomPoint());
+			ends1.set(i, randomPoint());
+			starts2.set(i, randomPoint());
+			// parallel one time out of eight
+			ends2.set(i, i % 8 == 0 ? starts2.get(i) + (ends1.get(i) - starts1.get(i)) * 0.5f : randomPoint());
+		}
+	}
+};
+
+bool nearlyEqual(float a, float b)
+{
+	return std::fabs(a - b) <= 1e-5f * std::max(1.f, std::fabs(b));
+}
+
+class Checker
+{
+	public:
+		Checker(const char* function, size_t count) : m_function(function), m_count(count), m_numErrors(0) {}
+
+		void check(size_t i, bool valid)
+		{
+			if (!valid && m_numErrors++ < 5)
+			{
+				std::printf("  %s, count %zu: wrong element %zu\n", m_function, m_count, i);
+			}
+		}
+
+		void checkGuard(const std::vector<float>& values)
+		{
+			for (size_t i = m_count; i < values.size(); ++i)
+			{
+				check(i, values[i] == GUARD);
+			}
+		}
+
+		void checkGuard(const Vector2Array& values)
+		{
+			checkGuard(values.x);
+			checkGuard(values.y);
+		}
+
+		int getNumErrors() const { return m_numErrors; }
+
+	private:
+		const char* m_function;
+		size_t m_count;
+		int m_numErrors;
+};
+
+int checkRectangleToRectangleDistance(const Input& input, size_t count, bool withDirections)
+{
+	std::vector<float> distances(count + GUARD_SIZE, GUARD);
+	Vector2Array directions(count);
+	intersection::rectangleToRectangleDistance(input.rectanglesA.span(), input.rectanglesB.span(), count, distances.data(),
+		withDirections ? directions.outputSpan() : intersection::OutputVector2Span());
+
+	Checker checker("rectangleToRectangleDistance", count);
+	for (size_t i = 0; i < count; ++i)
+	{
+		Vector2 direction;
+		const float distance = intersection::rectangleToRectangleDistance(input.rectanglesA.get(i), input.rectanglesB.get(i), &direction);
+		checker.check(i, nearlyEqual(distances[i], distance));
+		if (withDirections)
+		{
+			checker.check(i, nearlyEqual(directions.x[i], direction.x) && nearlyEqual(directions.y[i], direction.y));
+		}
+	}
+	checker.checkGuard(distances);
+	checker.checkGuard(directions);
+	return checker.getNumErrors();
+}
+
+int checkClosestPointOnRectangle(const Input& input, size_t count, bool withIsInside)
+{
+	Vector2Array closestPoints(count);
+	std::unique_ptr<bool[]> isInside(new bool[count + GUARD_SIZE]());
+	intersection::closestPointOnRectangle(input.rectanglesA.span(), input.points.span(), count, closestPoints.outputSpan(),
+		withIsInside ? isInside.get() : nullptr);
+
+	Checker checker("closestPointOnRectangle", count);
+	for (size_t i = 0; i < count; ++i)
+	{
+		bool expectedIsInside;
+		const Vector2 closestPoint = intersection::closestPointOnRectangle(input.rectanglesA.get(i), input.points.get(i), &expectedIsInside);
+		checker.check(i, nearlyEqual(closestPoints.x[i], closestPoint.x) && nearlyEqual(closestPoints.y[i], closestPoint.y));
+		if (withIsInside)
+		{
+			checker.check(i, isInside[i] == expectedIsInside);
+		}
+	}
+	for (size_t i = count; i < count + GUARD_SIZE; ++i)
+	{
+		checker.check(i, !isInside[i]);
+	}
+	checker.checkGuard(closestPoints);
+	return checker.getNumErrors();
+}
+
+int checkCircleToRectangleDistance(const Input& input, size_t count, bool withDirections)
+{
+	std::vector<float> distances(count + GUARD_SIZE, GUARD);
+	Vector2Array directions(count);
+	intersection::circleToRectangleDistance(input.rectanglesA.span(), input.points.span(), input.radii.data(), count, distances.data(),
+		withDirections ? directions.outputSpan() : intersection::OutputVector2Span());
+
+	Checker checker("circleToRectangleDistance", count);
+	for (size_t i = 0; i < count; ++i)
+	{
+		Vector2 direction;
+		const float distance = intersection::circleToRectangleDistance(input.rectanglesA.get(i), input.points.get(i), input.radii[i], &direction);
+		checker.check(i, nearlyEqual(distances[i], distance));
+		if (withDirections)
+		{
+			checker.check(i, nearlyEqual(directions.x[i], direction.x) && nearlyEqual(directions.y[i], direction.y));
+		}
+	}
+	checker.checkGuard(distances);
+	checker.checkGuard(directions);
+	return checker.getNumErrors();
+}
+
+int checkTwoLineSegments(const Input& input, size_t count)
+{
+	std::unique_ptr<bool[]> intersects(new bool[count + GUARD_SIZE]());
+	// the intersection is left untouched when there is none
+	Vector2Array intersections(count);
+	intersection::twoLineSegments(input.starts1.span(), input.ends1.span(), input.starts2.span(), input.ends2.span(), count,
+		intersects.get(), intersections.outputSpan());
+
+	Checker checker("twoLineSegments", count);
+	for (size_t i = 0; i < count; ++i)
+	{
+		Vector2 expectedIntersection(GUARD, GUARD);
+		const bool expectedIntersects = intersection::twoLineSegments(input.starts1.get(i), input.ends1.get(i), input.starts2.get(i), input.ends2.get(i), expectedIntersection);
+		checker.check(i, intersects[i] == expectedIntersects);
+		checker.check(i, nearlyEqual(intersections.x[i], expectedIntersection.x) && nearlyEqual(intersections.y[i], expectedIntersection.y));
+	}
+	for (size_t i = count; i < count + GUARD_SIZE; ++i)
+	{
+		checker.check(i, !intersects[i]);
+	}
+	checker.checkGuard(intersections);
+	return checker.getNumErrors();
+}
+
+int check(InstructionSet instructionSet)
+{
+	int numErrors = 0;
+	for (size_t count : CHECKED_COUNTS)
+	{
+		const Input input(count);
+		numErrors += checkRectangleToRectangleDistance(input, count, true);
+		numErrors += checkRectangleToRectangleDistance(input, count, false);
+		numErrors += checkClosestPointOnRectangle(input, count, true);
+		numErrors += checkClosestPointOnRectangle(input, count, false);
+		numErrors += checkCircleToRectangleDistance(input, count, true);
+		numErrors += checkCircleToRectangleDistance(input, count, false);
+		numErrors += checkTwoLineSegments(input, count);
+	}
+	std::printf("%-6s matches the scalar functions: %s\n", getName(instructionSet), numErrors == 0 ? "ok" : "FAILED");
+	return numErrors;
+}
+
+template <class Func>
+double getBestTime(Func func)
+{
+	double bestTime = 0.0;
+	for (int run = 0; run < NUM_TIMED_RUNS; ++run)
+	{
+		const auto start = std::chrono::steady_clock::now();
+		func();
+		const double time = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+		bestTime = run == 0 ? time : std::min(bestTime, time);
+	}
+	return bestTime;
+}
+
+void printTime(const char* function, const char* version, double time, float checksum)
+{
+	// the checksum keeps the results alive
+	std::printf("%-30s %-16s %8.3f ms (%g)\n", function, version, time, checksum);
+}
+
+// the scalar functions called in a loop, then the batch versions with each instruction set
+void benchmark(size_t count, const std::vector<InstructionSet>& instructionSets)
+{
+	const Input input(count);
+	std::vector<float> distances(count + GUARD_SIZE);
+	Vector2Array directions(count);
+	std::unique_ptr<bool[]> flags(new bool[count + GUARD_SIZE]());
+	std::printf("%zu elements, best of %d runs\n", count, NUM_TIMED_RUNS);
+
+	double time = getBestTime([&]()
+	{
+		for (size_t i = 0; i < count; ++i)
+		{
+			Vector2 direction;
+			distances[i] = intersection::rectangleToRectangleDistance(input.rectanglesA.get(i), input.rectanglesB.get(i), &direction);
+			directions.set(i, direction);
+		}
+	});
+	printTime("rectangleToRectangleDistance", "scalar function", time, distances[count / 2]);
+	for (InstructionSet instructionSet : instructionSets)
+	{
+		intersection::setMaxInstructionSet(instructionSet);
+		time = getBestTime([&]()
+		{
+			intersection::rectangleToRectangleDistance(input.rectanglesA.span(), input.rectanglesB.span(), count, distances.data(), directions.outputSpan());
+		});
+		printTime("rectangleToRectangleDistance", getName(instructionSet), time, distances[count / 2]);
+	}
+
+	time = getBestTime([&]()
+	{
+		for (size_t i = 0; i < count; ++i)
+		{
+			directions.set(i, intersection::closestPointOnRectangle(input.rectanglesA.get(i), input.points.get(i), &flags[i]));
+		}
+	});
+	printTime("closestPointOnRectangle", "scalar function", time, directions.x[count / 2]);
+	for (InstructionSet instructionSet : instructionSets)
+	{
+		intersection::setMaxInstructionSet(instructionSet);
+		time = getBestTime([&]()
+		{
+			intersection::closestPointOnRectangle(input.rectanglesA.span(), input.points.span(), count, directions.outputSpan(), flags.get());
+		});
+		printTime("closestPointOnRectangle", getName(instructionSet), time, directions.x[count / 2]);
+	}
+
+	time = getBestTime([&]()
+	{
+		for (size_t i = 0; i < count; ++i)
+		{
+			Vector2 direction;
+			distances[i] = intersection::circleToRectangleDistance(input.rectanglesA.get(i), input.points.get(i), input.radii[i], &direction);
+			directions.set(i, direction);
+		}
+	});
+	printTime("circleToRectangleDistance", "scalar function", time, distances[count / 2]);
+	for (InstructionSet instructionSet : instructionSets)
+	{
+		intersection::setMaxInstructionSet(instructionSet);
+		time = getBestTime([&]()
+		{
+			intersection::circleToRectangleDistance(input.rectanglesA.span(), input.points.span(), input.radii.data(), count, distances.data(), directions.outputSpan());
+		});
+		printTime("circleToRectangleDistance", getName(instructionSet), time, distances[count / 2]);
+	}
+
+	time = getBestTime([&]()
+	{
+		for (size_t i = 0; i < count; ++i)
+		{
+			Vector2 point;
+			flags[i] = intersection::twoLineSegments(input.starts1.get(i), input.ends1.get(i), input.starts2.get(i), input.ends2.get(i), point);
+			directions.set(i, point);
+		}
+	});
+	printTime("twoLineSegments", "scalar function", time, directions.x[count / 2]);
+	for (InstructionSet instructionSet : instructionSets)
+	{
+		intersection::setMaxInstructionSet(instructionSet);
+		time = getBestTime([&]()
+		{
+			intersection::twoLineSegments(input.starts1.span(), input.ends1.span(), input.starts2.span(), input.ends2.span(), count, flags.get(), directions.outputSpan());
+		});
+		printTime("twoLineSegments", getName(instructionSet), time, directions.x[count / 2]);
+	}
+}
+
+} // namespace
+
+int main(int argc, char* argv[])
+{
+	const bool time = argc > 1 && std::strcmp(argv[1], "time") == 0;
+	const size_t timedCount = argc > 2 ? static_cast<size_t>(std::max(std::atoi(argv[2]), 1)) : DEFAULT_TIMED_COUNT;
+
+	// the unsupported instruction sets are skipped
+	std::vector<InstructionSet> instructionSets;
+	for (InstructionSet instructionSet : { InstructionSet::SCALAR, InstructionSet::SSE2, InstructionSet::AVX2 })
+	{
+		intersection::setMaxInstructionSet(instructionSet);
+		if (intersection::getInstructionSet() == instructionSet)
+		{
+			instructionSets.push_back(instructionSet);
+		}
+		else
+		{
+			std::printf("%-6s not supported by this CPU\n", getName(instructionSet));
+		}
+	}
+
+	int numErrors = 0;
+	for (InstructionSet instructionSet : instructionSets)
+	{
+		intersection::setMaxInstructionSet(instructionSet);
+		numErrors += check(instructionSet);
+	}
+
+	if (time)
+	{
+		benchmark(timedCount, instructionSets);
+	}
+	return numErrors == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+
@@ -0,0 +1,176 @@
+// benchmark of loose against tight geometry::QuadTree queries on a realistic distribution of object sizes
+// standalone, build from the repository root with:
+//   g++ -std=c++17 -O2 -Isrc tools/benchmark/quadtreeloose.cpp -o quadtreeloose
+// usage: quadtreeloose [numObjects] [numQueries]
+// sizes are log-uniform from 0.5 to 64 units (many small props, fewer characters and buildings) plus 1% of
+// objects up to 512 units (terrain chunks, triggers), the world is 4096 units wide and leaf cells 16 units
+// queries of a few sizes are timed with eachObject, from a point-like pick to a zoomed out camera, on compacted
+// trees then after moving every object a little with updateObject (also timed), both trees must return the same objects
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstdint>
+#include <vector>
+
+#include "geometry/quadtree.h"
+
+using flat::AABB2;
+using flat::Vector2;
+
+namespace
+{
+
+constexpr int DEPTH = 8;
+constexpr float WORLD_SIZE = 4096.f;
+constexpr float LOOSENESS = 2.f;
+constexpr int DEFAULT_NUM_OBJECTS = 200000;
+constexpr int DEFAULT_NUM_QUERIES = 5000;
+constexpr float QUERY_SIZES[] = { 2.f, 32.f, 256.f, 1024.f };
+constexpr int NUM_TIMED_RUNS = 3;
+
+std::vector<AABB2> objectAABBs;
+
+void getObjectAABB(int object, AABB2& aabb)
+{
+	aabb = objectAABBs[object];
+}
+
+using QuadTree = flat::geometry::QuadTree<int, DEPTH, getObjectAABB>;
+
+class Random
+{
+	public:
+		explicit Random(std::uint32_t seed) : m_state(seed) {}
+
+		// in [min, max)
+		float next(float min, float max)
+		{
+			m_state = m_state * 1103515245u + 12345u;
+			return min + static_cast<float>((m_state >> 8) % 100000) / 100000.f * (max - min);
+		}
+
+	private:
+		std::uint32_t m_state;
+};
+
+float getRandomSize(Random& random)
+{
+	if (random.next(0.f, 1.f) < 0.01f)
+	{
+		return random.next(64.f, 512.f);
+	}
+	return 0.5f * std::exp2(random.next(0.f, 7.f));
+}
+
+AABB2 getRandomAABB(Random& random)
+{
+	// roughly square, some elongated
+	const float size = getRandomSize(random);
+	const Vector2 extents(size * random.next(0.5f, 1.f), size * random.next(0.5f, 1.f));
+	const Vector2 min(random.next(0.f, WORLD_SIZE - extents.x), random.next(0.f, WORLD_SIZE - extents.y));
+	return AABB2(min, min + extents);
+}
+
+AABB2 getQueryAABB(Random& random, float size)
+{
+	const Vector2 min(random.next(0.f, WORLD_SIZE - size), random.next(0.f, WORLD_SIZE - size));
+	return AABB2(min, min + Vector2(size, size));
+}
+
+// best of a few runs, the sum of the objects found is returned too
+double timeQueries(const QuadTree& quadTree, const std::vector<AABB2>& queries, size_t& checksum)
+{
+	double bestTime = 0.0;
+	for (int run = 0; run < NUM_TIMED_RUNS; ++run)
+	{
+		checksum = 0;
+		const auto start = std::chrono::steady_clock::now();
+		for (const AABB2& query : queries)
+		{
+			quadTree.eachObject(query, [&checksum](int object) { checksum += static_cast<size_t>(object) + 1; });
+		}
+		const double time = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count();
+		bestTime = run == 0 ? time : std::min(bestTime, time);
+	}
+	return bestTime / static_cast<double>(queries.size());
+}
+
+double timeUpdates(QuadTree& quadTree, std::vector<int>& cellIndices, const std::vector<AABB2>& movedAABBs)
+{
+	const auto start = std::chrono::steady_clock::now();
+	for (size_t object = 0; object < movedAABBs.size(); ++object)
+	{
+		cellIndices[object] = quadTree.updateObject(static_cast<int>(object), cellIndices[object], movedAABBs[object]);
+	}
+	return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+int compareQueries(const QuadTree& tightQuadTree, const QuadTree& looseQuadTree, Random& random, int numQueries)
+{
+	int numErrors = 0;
+	for (float querySize : QUERY_SIZES)
+	{
+		std::vector<AABB2> queries;
+		for (int i = 0; i < numQueries; ++i)
+		{
+			queries.push_back(getQueryAABB(random, querySize));
+		}
+		size_t tightChecksum;
+		size_t looseChecksum;
+		const double tightTime = timeQueries(tightQuadTree, queries, tightChecksum);
+		const double looseTime = timeQueries(looseQuadTree, queries, looseChecksum);
+		numErrors += tightChecksum == looseChecksum ? 0 : 1;
+		std::printf("query %6.0f units: tight %9.2f us, loose %9.2f us per query, loose / tight %.2f\n",
+			querySize, tightTime, looseTime, looseTime / tightTime);
+	}
+	return numErrors;
+}
+
+} // namespace
+
+int main(int argc, char* argv[])
+{
+	const int numObjects = argc > 1 ? std::max(std::atoi(argv[1]), 1) : DEFAULT_NUM_OBJECTS;
+	const int numQueries = argc > 2 ? std::max(std::atoi(argv[2]), 1) : DEFAULT_NUM_QUERIES;
+
+	Random random(5);
+	const AABB2 worldAABB(Vector2(0.f, 0.f), Vector2(WORLD_SIZE, WORLD_SIZE));
+	QuadTree tightQuadTree(worldAABB);
+	QuadTree looseQuadTree(worldAABB, LOOSENESS);
+	std::vector<int> tightCellIndices;
+	std::vector<int> looseCellIndices;
+	for (int object = 0; object < numObjects; ++object)
+	{
+		objectAABBs.push_back(getRandomAABB(random));
+		tightCellIndices.push_back(tightQuadTree.addObject(object, objectAABBs.back()));
+		looseCellIndices.push_back(looseQuadTree.addObject(object, objectAABBs.back()));
+	}
+	// as after a level load
+	tightQuadTree.compact();
+	looseQuadTree.compact();
+	std::printf("%d objects, looseness %.1f, %d queries per size, compacted\n", numObjects, LOOSENESS, numQueries);
+	int numErrors = compareQueries(tightQuadTree, looseQuadTree, random, numQueries);
+
+	// every object moves by up to 2 units, staying in the world
+	std::vector<AABB2> movedAABBs;
+	for (const AABB2& aabb : objectAABBs)
+	{
+		const Vector2 move(random.next(-2.f, 2.f), random.next(-2.f, 2.f));
+		const AABB2 movedAABB(aabb.min + move, aabb.max + move);
+		const bool isInWorld = movedAABB.min.x >= 0.f && movedAABB.min.y >= 0.f && movedAABB.max.x <= WORLD_SIZE && movedAABB.max.y <= WORLD_SIZE;
+		movedAABBs.push_back(isInWorld ? movedAABB : aabb);
+	}
+	const double tightUpdateTime = timeUpdates(tightQuadTree, tightCellIndices, movedAABBs);
+	const double looseUpdateTime = timeUpdates(looseQuadTree, looseCellIndices, movedAABBs);
+	objectAABBs = movedAABBs;
+	std::printf("update every object: tight %.2f ms, loose %.2f ms, then\n", tightUpdateTime, looseUpdateTime);
+	numErrors += compareQueries(tightQuadTree, looseQuadTree, random, numQueries);
+
+	std::printf("same objects found by both trees: %s\n", numErrors == 0 ? "ok" : "FAILED");
+	return numErrors == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+
@@ -0,0 +1,299 @@
+// correctness check and benchmark for geometry::QuadTree::nearest and geometry::QuadTree::raycast
+// standalone, build from the repository root with:
+//   g++ -std=c++17 -O2 -Isrc tools/benchmark/quadtreenearest.cpp src/geometry/intersection.cpp -o quadtreenearest
+// usage: quadtreenearest [numObjects] [numQueries]
+// the results of tight and loose trees are compared to brute force: the k nearest distances and their order,
+// every ray hit in order, and rays stopped early by the callback, then both queries are timed against brute force
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstdint>
+#include <limits>
+#include <vector>
+
+#include "geometry/quadtree.h"
+
+using flat::AABB2;
+using flat::Vector2;
+namespace intersection = flat::geometry::intersection;
+
+namespace
+{
+
+constexpr int DEPTH = 7;
+constexpr float WORLD_SIZE = 2048.f;
+constexpr int DEFAULT_NUM_OBJECTS = 100000;
+constexpr int DEFAULT_NUM_QUERIES = 2000;
+constexpr int NUM_CHECKED_QUERIES = 200;
+constexpr int CHECKED_KS[] = { 1, 5, 32 };
+constexpr float NO_MAX_DISTANCE = std::numeric_limits<float>::max();
+constexpr float SHORT_DISTANCE = 20.f;
+constexpr int NUM_EARLY_EXIT_HITS = 3;
+
+std::vector<AABB2> objectAABBs;
+
+void getObjectAABB(int object, AABB2& aabb)
+{
+	aabb = objectAABBs[object];
+}
+
+using QuadTree = flat::geometry::QuadTree<int, DEPTH, getObjectAABB>;
+
+class Random
+{
+	public:
+		explicit Random(std::uint32_t seed) : m_state(seed) {}
+
+		// in [min, max)
+		float next(float min, float max)
+		{
+			m_state = m_state * 1103515245u + 12345u;
+			return min + static_cast<float>((m_state >> 8) % 100000) / 100000.f * (max - min);
+		}
+
+	private:
+		std::uint32_t m_state;
+};
+
+struct Ray
+{
+	Vector2 origin;
+	Vector2 direction;
+	float maxDistance;
+};
+
+struct Hit
+{
+	int object;
+	float distance;
+};
+
+// mostly small objects with a few large ones
+AABB2 getRandomAABB(Random& random)
+{
+	const float maxSize = random.next(0.f, 1.f) < 0.02f ? 64.f : 6.f;
+	const Vector2 size(random.next(0.5f, maxSize), random.next(0.5f, maxSize));
+	const Vector2 min(random.next(0.f, WORLD_SIZE - size.x), random.next(0.f, WORLD_SIZE - size.y));
+	return AABB2(min, min + size);
+}
+
+// one ray in eight is axis aligned
+Ray getRandomRay(Random& random, int index)
+{
+	Ray ray;
+	ray.origin = Vector2(random.next(0.f, WORLD_SIZE), random.next(0.f, WORLD_SIZE));
+	if (index % 8 == 0)
+	{
+		ray.direction = (index / 8) % 2 == 0 ? Vector2(1.f, 0.f) : Vector2(0.f, -1.f);
+	}
+	else
+	{
+		const float angle = random.next(0.f, 6.2831853f);
+		ray.direction = Vector2(std::cos(angle), std::sin(angle));
+	}
+	ray.maxDistance = index % 2 == 0 ? NO_MAX_DISTANCE : random.next(10.f, 200.f);
+	return ray;
+}
+
+std::vector<float> nearestBruteForce(const Vector2& point, int k, float maxDistance)
+{
+	std::vector<float> distances;
+	for (const AABB2& aabb : objectAABBs)
+	{
+		const float distance = intersection::pointToRectangleDistance(aabb, point);
+		if (distance <= maxDistance)
+		{
+			distances.push_back(distance);
+		}
+	}
+	const size_t numNearest = std::min(distances.size(), static_cast<size_t>(k));
+	std::partial_sort(distances.begin(), distances.begin() + numNearest, distances.end());
+	distances.resize(numNearest);
+	return distances;
+}
+
+std::vector<Hit> raycastBruteForce(const Ray& ray)
+{
+	std::vector<Hit> hits;
+	for (int object = 0; object < static_cast<int>(objectAABBs.size()); ++object)
+	{
+		float distance;
+		if (intersection::rayToRectangle(ray.origin, ray.direction, ray.maxDistance, objectAABBs[object], &distance))
+		{
+			hits.push_back({ object, distance });
+		}
+	}
+	std::sort(hits.begin(), hits.end(), [](const Hit& a, const Hit& b) { return a.distance < b.distance || (a.distance == b.distance && a.object < b.object); });
+	return hits;
+}
+
+// ties can be reported in any order, the distances must be the same as brute force and the objects the ones at these distances
+int checkNearest(const QuadTree& quadTree, const Vector2& point, int k, float maxDistance)
+{
+	std::vector<int> objects;
+	quadTree.nearest(point, k, maxDistance, objects);
+	const std::vector<float> expectedDistances = nearestBruteForce(point, k, maxDistance);
+	if (objects.size() != expectedDistances.size())
+	{
+		return 1;
+	}
+	int numErrors = 0;
+	for (size_t i = 0; i < objects.size(); ++i)
+	{
+		const float distance = intersection::pointToRectangleDistance(objectAABBs[objects[i]], point);
+		numErrors += distance == expectedDistances[i] ? 0 : 1;
+	}
+	std::vector<int> uniqueObjects = objects;
+	std::sort(uniqueObjects.begin(), uniqueObjects.end());
+	numErrors += std::adjacent_find(uniqueObjects.begin(), uniqueObjects.end()) == uniqueObjects.end() ? 0 : 1;
+	return numErrors;
+}
+
+int checkRaycast(const QuadTree& quadTree, const Ray& ray)
+{
+	const std::vector<Hit> expectedHits = raycastBruteForce(ray);
+
+	std::vector<Hit> hits;
+	quadTree.raycast(ray.origin, ray.direction, ray.maxDistance, [&hits](int object, float distance)
+	{
+		hits.push_back({ object, distance });
+		return true;
+	});
+	int numErrors = hits.size() == expectedHits.size() ? 0 : 1;
+	for (size_t i = 0; i < hits.size() && i < expectedHits.size(); ++i)
+	{
+		// from the closest, with the distance of the slab test
+		numErrors += hits[i].distance == expectedHits[i].distance ? 0 : 1;
+		float distance;
+		numErrors += intersection::rayToRectangle(ray.origin, ray.direction, ray.maxDistance, objectAABBs[hits[i].object], &distance) && distance == hits[i].distance ? 0 : 1;
+	}
+	std::vector<int> hitObjects;
+	for (const Hit& hit : hits)
+	{
+		hitObjects.push_back(hit.object);
+	}
+	std::sort(hitObjects.begin(), hitObjects.end());
+	numErrors += std::adjacent_find(hitObjects.begin(), hitObjects.end()) == hitObjects.end() ? 0 : 1;
+
+	// returning false stops the ray, the callback is not called again
+	int numCalls = 0;
+	float lastDistance = 0.f;
+	quadTree.raycast(ray.origin, ray.direction, ray.maxDistance, [&numCalls, &lastDistance](int, float distance)
+	{
+		++numCalls;
+		lastDistance = distance;
+		return numCalls < NUM_EARLY_EXIT_HITS;
+	});
+	const int expectedNumCalls = std::min(static_cast<int>(expectedHits.size()), NUM_EARLY_EXIT_HITS);
+	numErrors += numCalls == expectedNumCalls ? 0 : 1;
+	if (numCalls > 0 && numCalls == expectedNumCalls)
+	{
+		numErrors += lastDistance == expectedHits[numCalls - 1].distance ? 0 : 1;
+	}
+	return numErrors;
+}
+
+int check(const QuadTree& quadTree, const std::vector<Vector2>& points, const std::vector<Ray>& rays, const char* name)
+{
+	int numNearestErrors = 0;
+	int numRaycastErrors = 0;
+	for (int i = 0; i < NUM_CHECKED_QUERIES; ++i)
+	{
+		for (int k : CHECKED_KS)
+		{
+			numNearestErrors += checkNearest(quadTree, points[i], k, NO_MAX_DISTANCE);
+			numNearestErrors += checkNearest(quadTree, points[i], k, SHORT_DISTANCE);
+		}
+		numRaycastErrors += checkRaycast(quadTree, rays[i]);
+	}
+	std::printf("%-6s nearest matches brute force: %s, raycast matches brute force: %s\n", name,
+		numNearestErrors == 0 ? "ok" : "FAILED", numRaycastErrors == 0 ? "ok" : "FAILED");
+	return numNearestErrors + numRaycastErrors;
+}
+
+template <class Func>
+double getTimePerQuery(size_t numQueries, Func func)
+{
+	const auto start = std::chrono::steady_clock::now();
+	for (size_t i = 0; i < numQueries; ++i)
+	{
+		func(i);
+	}
+	return std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count() / static_cast<double>(numQueries);
+}
+
+void benchmark(const QuadTree& quadTree, const std::vector<Vector2>& points, const std::vector<Ray>& rays, const char* name)
+{
+	size_t checksum = 0;
+	std::vector<int> objects;
+	for (int k : { 1, 16 })
+	{
+		const double time = getTimePerQuery(points.size(), [&](size_t i)
+		{
+			objects.clear();
+			quadTree.nearest(points[i], k, NO_MAX_DISTANCE, objects);
+			checksum += objects.size();
+		});
+		std::printf("%-6s nearest k = %-2d   %9.2f us per query\n", name, k, time);
+	}
+
+	double time = getTimePerQuery(rays.size(), [&](size_t i)
+	{
+		quadTree.raycast(rays[i].origin, rays[i].direction, rays[i].maxDistance, [&checksum](int, float) { ++checksum; return true; });
+	});
+	std::printf("%-6s raycast, all hits %9.2f us per query\n", name, time);
+
+	time = getTimePerQuery(rays.size(), [&](size_t i)
+	{
+		quadTree.raycast(rays[i].origin, rays[i].direction, rays[i].maxDistance, [&checksum](int, float) { ++checksum; return false; });
+	});
+	std::printf("%-6s raycast, first hit %8.2f us per query (%zu)\n", name, time, checksum);
+}
+
+} // namespace
+
+int main(int argc, char* argv[])
+{
+	const int numObjects = argc > 1 ? std::max(std::atoi(argv[1]), 1) : DEFAULT_NUM_OBJECTS;
+	const int numQueries = argc > 2 ? std::max(std::atoi(argv[2]), NUM_CHECKED_QUERIES) : DEFAULT_NUM_QUERIES;
+
+	Random random(11);
+	QuadTree tightQuadTree(AABB2(Vector2(0.f, 0.f), Vector2(WORLD_SIZE, WORLD_SIZE)));
+	QuadTree looseQuadTree(AABB2(Vector2(0.f, 0.f), Vector2(WORLD_SIZE, WORLD_SIZE)), 2.f);
+	for (int object = 0; object < numObjects; ++object)
+	{
+		objectAABBs.push_back(getRandomAABB(random));
+		tightQuadTree.addObject(object, objectAABBs.back());
+		looseQuadTree.addObject(object, objectAABBs.back());
+	}
+
+	std::vector<Vector2> points;
+	std::vector<Ray> rays;
+	for (int i = 0; i < numQueries; ++i)
+	{
+		points.emplace_back(random.next(0.f, WORLD_SIZE), random.next(0.f, WORLD_SIZE));
+		rays.push_back(getRandomRay(random, i));
+	}
+
+	int numErrors = check(tightQuadTree, points, rays, "tight");
+	numErrors += check(looseQuadTree, points, rays, "loose");
+
+	std::printf("%d objects, %d queries\n", numObjects, numQueries);
+	benchmark(tightQuadTree, points, rays, "tight");
+	benchmark(looseQuadTree, points, rays, "loose");
+
+	// brute force on a tenth of the queries
+	const size_t numBruteForceQueries = std::max(points.size() / 10, static_cast<size_t>(1));
+	size_t checksum = 0;
+	double time = getTimePerQuery(numBruteForceQueries, [&](size_t i) { checksum += nearestBruteForce(points[i], 16, NO_MAX_DISTANCE).size(); });
+	std::printf("brute  nearest k = 16   %9.2f us per query\n", time);
+	time = getTimePerQuery(numBruteForceQueries, [&](size_t i) { checksum += raycastBruteForce(rays[i]).size(); });
+	std::printf("brute  raycast, all hits %9.2f us per query (%zu)\n", time, checksum);
+
+	return numErrors == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+
@@ -0,0 +1,187 @@
+// benchmark of geometry::QuadTree::eachObject on 10k, 100k and 1M objects, right after loading them and after
+// moves, removals and additions have fragmented the cell data
+// standalone, build from the repository root with:
+//   g++ -std=c++17 -O2 -Isrc tools/benchmark/quadtreequery.cpp -o quadtreequery
+// usage: quadtreequery [numQueries]
+// only the API older trees also have is used: building against another src directory compares the two versions,
+// the result counts must be the same
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstdint>
+#include <vector>
+
+#include "geometry/quadtree.h"
+
+using flat::AABB2;
+using flat::Vector2;
+
+namespace
+{
+
+constexpr int DEPTH = 8;
+constexpr float WORLD_SIZE = 4096.f;
+constexpr float QUERY_SIZE = 64.f;
+constexpr int DEFAULT_NUM_QUERIES = 10000;
+constexpr int NUM_CHECKED_QUERIES = 100;
+constexpr int NUM_CHURN_ROUNDS = 4;
+constexpr int NUM_TIMED_RUNS = 5;
+constexpr size_t NUM_OBJECTS[] = { 10000, 100000, 1000000 };
+
+std::vector<AABB2> objectAABBs;
+
+void getObjectAABB(int object, AABB2& aabb)
+{
+	aabb = objectAABBs[object];
+}
+
+using QuadTree = flat::geometry::QuadTree<int, DEPTH, getObjectAABB>;
+
+class Random
+{
+	public:
+		explicit Random(std::uint32_t seed) : m_state(seed) {}
+
+		// in [min, max)
+		float next(float min, float max)
+		{
+			m_state = m_state * 1103515245u + 12345u;
+			return min + static_cast<float>((m_state >> 8) % 100000) / 100000.f * (max - min);
+		}
+
+	private:
+		std::uint32_t m_state;
+};
+
+// objects from 1 to 8 units wide, a few straddle the boundaries of the deep cells
+AABB2 getRandomAABB(Random& random)
+{
+	const Vector2 size(random.next(1.f, 8.f), random.next(1.f, 8.f));
+	const Vector2 min(random.next(0.f, WORLD_SIZE - size.x), random.next(0.f, WORLD_SIZE - size.y));
+	return AABB2(min, min + size);
+}
+
+// best of a few runs of all the queries, the total number of results is returned too
+double timeQueries(const QuadTree& quadTree, const std::vector<AABB2>& queries, size_t& numResults)
+{
+	double bestTime = 0.0;
+	for (int run = 0; run < NUM_TIMED_RUNS; ++run)
+	{
+		numResults = 0;
+		const auto start = std::chrono::steady_clock::now();
+		for (const AABB2& query : queries)
+		{
+			quadTree.eachObject(query, [&numResults](int) { ++numResults; });
+		}
+		const double time = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+		bestTime = run == 0 ? time : std::min(bestTime, time);
+	}
+	return bestTime;
+}
+
+int checkQueries(const QuadTree& quadTree, const std::vector<AABB2>& queries)
+{
+	int numErrors = 0;
+	std::vector<int> objects;
+	for (int i = 0; i < NUM_CHECKED_QUERIES && i < static_cast<int>(queries.size()); ++i)
+	{
+		objects.clear();
+		quadTree.eachObject(queries[i], [&objects](int object) { objects.push_back(object); });
+		std::sort(objects.begin(), objects.end());
+		size_t numExpected = 0;
+		for (int object = 0; object < static_cast<int>(objectAABBs.size()); ++object)
+		{
+			if (AABB2::overlap(objectAABBs[object], queries[i]))
+			{
+				numErrors += std::binary_search(objects.begin(), objects.end(), object) ? 0 : 1;
+				++numExpected;
+			}
+		}
+		numErrors += objects.size() == numExpected ? 0 : 1;
+	}
+	return numErrors;
+}
+
+int benchmark(size_t numObjects, const std::vector<AABB2>& queries)
+{
+	Random random(static_cast<std::uint32_t>(numObjects));
+	QuadTree quadTree(AABB2(Vector2(0.f, 0.f), Vector2(WORLD_SIZE, WORLD_SIZE)));
+	objectAABBs.clear();
+	std::vector<int> cellIndices;
+	for (size_t i = 0; i < numObjects; ++i)
+	{
+		objectAABBs.push_back(getRandomAABB(random));
+		cellIndices.push_back(quadTree.addObject(static_cast<int>(i), objectAABBs.back()));
+	}
+
+	size_t numResults;
+	const double loadedTime = timeQueries(quadTree, queries, numResults);
+	std::printf("%8zu objects, loaded:     %9.3f ms for %zu queries, %zu results\n", numObjects, loadedTime, queries.size(), numResults);
+	int numErrors = checkQueries(quadTree, queries);
+
+	// every object moves a little, a quarter of them far away, and one in eight is removed then added back elsewhere
+	for (int round = 0; round < NUM_CHURN_ROUNDS; ++round)
+	{
+		for (size_t i = 0; i < numObjects; ++i)
+		{
+			const int object = static_cast<int>(i);
+			if (i % 8 == static_cast<size_t>(round))
+			{
+				quadTree.removeObject(object, cellIndices[i]);
+				objectAABBs[i] = getRandomAABB(random);
+				cellIndices[i] = quadTree.addObject(object, objectAABBs[i]);
+			}
+			else
+			{
+				AABB2& aabb = objectAABBs[i];
+				if (i % 4 == 0)
+				{
+					aabb = getRandomAABB(random);
+				}
+				else
+				{
+					const Vector2 move(random.next(-4.f, 4.f), random.next(-4.f, 4.f));
+					const AABB2 movedAABB(aabb.min + move, aabb.max + move);
+					if (movedAABB.min.x >= 0.f && movedAABB.min.y >= 0.f && movedAABB.max.x <= WORLD_SIZE && movedAABB.max.y <= WORLD_SIZE)
+					{
+						aabb = movedAABB;
+					}
+				}
+				cellIndices[i] = quadTree.updateObject(object, cellIndices[i], aabb);
+			}
+		}
+	}
+
+	const double churnedTime = timeQueries(quadTree, queries, numResults);
+	std::printf("%8zu objects, fragmented: %9.3f ms for %zu queries, %zu results\n", numObjects, churnedTime, queries.size(), numResults);
+	numErrors += checkQueries(quadTree, queries);
+	return numErrors;
+}
+
+} // namespace
+
+int main(int argc, char* argv[])
+{
+	const int numQueries = argc > 1 ? std::max(std::atoi(argv[1]), 1) : DEFAULT_NUM_QUERIES;
+
+	// about the area seen by a camera
+	Random random(3);
+	std::vector<AABB2> queries;
+	for (int i = 0; i < numQueries; ++i)
+	{
+		const Vector2 min(random.next(0.f, WORLD_SIZE - QUERY_SIZE), random.next(0.f, WORLD_SIZE - QUERY_SIZE));
+		queries.emplace_back(min, min + Vector2(QUERY_SIZE, QUERY_SIZE));
+	}
+
+	int numErrors = 0;
+	for (size_t numObjects : NUM_OBJECTS)
+	{
+		numErrors += benchmark(numObjects, queries);
+	}
+	std::printf("results match brute force: %s\n", numErrors == 0 ? "ok" : "FAILED");
+	return numErrors == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+
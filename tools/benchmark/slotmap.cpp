@@ -0,0 +1,265 @@
+// benchmark of stopping and looking up 10k timers stored in a containers::SlotMap, as lua::timer::TimerContainer
+// does, against the previous storage: a containers::ChunkedPool and std::find in the ordering lists
+// standalone, build from the repository root with:
+//   g++ -std=c++17 -O2 -Isrc tools/benchmark/slotmap.cpp -o slotmap
+// usage: slotmap [numTimers]
+// the timers are replaced by objects of the same size, with the slot map the stopped timers stay in the ordering
+// list until the next update removes them, that cleanup is part of the measured stop time
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstdint>
+#include <deque>
+#include <vector>
+
+#include "containers/slotmap.h"
+#include "containers/chunkedpool.h"
+
+using flat::containers::SlotMap;
+using flat::containers::SlotMapHandle;
+using flat::containers::ChunkedPool;
+
+namespace
+{
+
+constexpr int DEFAULT_NUM_TIMERS = 10000;
+constexpr int NUM_LOOKUP_ROUNDS = 100;
+constexpr int NUM_STOPPED_PER_FRAME = 100;
+constexpr int NUM_FRAMES = 20;
+
+// as large as a timer: a container pointer, two lua references, begin time, duration and loop
+struct Timer
+{
+	explicit Timer(int index) :
+		timeOut(static_cast<float>(index))
+	{
+
+	}
+
+	float timeOut;
+	char padding[52];
+};
+
+static_assert(sizeof(Timer) == 56, "not the size of a timer");
+
+class Random
+{
+	public:
+		explicit Random(std::uint32_t seed) : m_state(seed) {}
+
+		// in [0, max)
+		size_t next(size_t max)
+		{
+			m_state = m_state * 1103515245u + 12345u;
+			return (m_state >> 8) % max;
+		}
+
+	private:
+		std::uint32_t m_state;
+};
+
+template <class Func>
+double getMilliseconds(Func func)
+{
+	const auto start = std::chrono::steady_clock::now();
+	func();
+	return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+// previous TimerContainer: timers sorted by time out in a deque of pointers, stop searches the deque
+class PoolTimers
+{
+	public:
+		explicit PoolTimers(int numTimers)
+		{
+			for (int i = 0; i < numTimers; ++i)
+			{
+				m_timers.push_back(m_timerPool.create(i));
+			}
+		}
+
+		~PoolTimers()
+		{
+			for (Timer* timer : m_timers)
+			{
+				if (timer != nullptr)
+				{
+					m_timerPool.destroy(timer);
+				}
+			}
+		}
+
+		inline Timer* getTimer(int index) const { return m_timers[index]; }
+
+		bool stop(Timer* timer)
+		{
+			std::deque<Timer*>::iterator it = std::find(m_timers.begin(), m_timers.end(), timer);
+			if (it == m_timers.end())
+			{
+				return false;
+			}
+			m_timerPool.destroy(*it);
+			*it = nullptr;
+			return true;
+		}
+
+		void update()
+		{
+			m_timers.erase(std::remove(m_timers.begin(), m_timers.end(), nullptr), m_timers.end());
+		}
+
+		inline size_t getNumTimers() const { return m_timers.size(); }
+
+	private:
+		ChunkedPool<Timer> m_timerPool;
+		std::deque<Timer*> m_timers;
+};
+
+// current TimerContainer: timers in a slot map, the sorted deque holds handles
+class SlotMapTimers
+{
+	public:
+		explicit SlotMapTimers(int numTimers)
+		{
+			for (int i = 0; i < numTimers; ++i)
+			{
+				m_sortedTimers.push_back(m_timers.insert(i));
+			}
+		}
+
+		inline SlotMapHandle getHandle(int index) const { return m_sortedTimers[index]; }
+		inline Timer* getTimer(SlotMapHandle timerHandle) { return m_timers.get(timerHandle); }
+
+		inline bool stop(SlotMapHandle timerHandle) { return m_timers.erase(timerHandle); }
+
+		void update()
+		{
+			m_sortedTimers.erase(std::remove_if(m_sortedTimers.begin(), m_sortedTimers.end(), [this](SlotMapHandle timerHandle) { return !m_timers.isValid(timerHandle); }), m_sortedTimers.end());
+		}
+
+		inline size_t getNumTimers() const { return m_timers.getSize(); }
+
+	private:
+		SlotMap<Timer> m_timers;
+		std::deque<SlotMapHandle> m_sortedTimers;
+};
+
+std::vector<int> getShuffledIndices(int numTimers, Random& random)
+{
+	std::vector<int> indices(numTimers);
+	for (int i = 0; i < numTimers; ++i)
+	{
+		indices[i] = i;
+	}
+	for (size_t i = indices.size() - 1; i > 0; --i)
+	{
+		std::swap(indices[i], indices[random.next(i + 1)]);
+	}
+	return indices;
+}
+
+} // namespace
+
+int main(int argc, char* argv[])
+{
+	const int numTimers = argc > 1 ? std::max(std::atoi(argv[1]), NUM_STOPPED_PER_FRAME * NUM_FRAMES) : DEFAULT_NUM_TIMERS;
+
+	Random random(9);
+	const std::vector<int> order = getShuffledIndices(numTimers, random);
+	int numErrors = 0;
+	double checksum = 0.0;
+
+	std::printf("%d timers\n", numTimers);
+	{
+		PoolTimers poolTimers(numTimers);
+		std::vector<Timer*> timers;
+		for (int index : order)
+		{
+			timers.push_back(poolTimers.getTimer(index));
+		}
+		const double lookupTime = getMilliseconds([&]()
+		{
+			for (int round = 0; round < NUM_LOOKUP_ROUNDS; ++round)
+			{
+				for (const Timer* timer : timers)
+				{
+					checksum += timer->timeOut;
+				}
+			}
+		});
+		const double frameTime = getMilliseconds([&]()
+		{
+			for (int frame = 0; frame < NUM_FRAMES; ++frame)
+			{
+				for (int i = 0; i < NUM_STOPPED_PER_FRAME; ++i)
+				{
+					numErrors += poolTimers.stop(timers[frame * NUM_STOPPED_PER_FRAME + i]) ? 0 : 1;
+				}
+				poolTimers.update();
+			}
+		});
+		const double stopTime = getMilliseconds([&]()
+		{
+			for (size_t i = NUM_STOPPED_PER_FRAME * NUM_FRAMES; i < timers.size(); ++i)
+			{
+				numErrors += poolTimers.stop(timers[i]) ? 0 : 1;
+			}
+			poolTimers.update();
+		});
+		numErrors += poolTimers.getNumTimers() == 0 ? 0 : 1;
+		std::printf("pool + std::find: %d lookups %8.3f ms, %d stopped per frame %8.3f ms per frame, stop the others %8.3f ms\n",
+			numTimers * NUM_LOOKUP_ROUNDS, lookupTime, NUM_STOPPED_PER_FRAME, frameTime / NUM_FRAMES, stopTime);
+	}
+	{
+		SlotMapTimers slotMapTimers(numTimers);
+		std::vector<SlotMapHandle> timerHandles;
+		for (int index : order)
+		{
+			timerHandles.push_back(slotMapTimers.getHandle(index));
+		}
+		const double lookupTime = getMilliseconds([&]()
+		{
+			for (int round = 0; round < NUM_LOOKUP_ROUNDS; ++round)
+			{
+				for (SlotMapHandle timerHandle : timerHandles)
+				{
+					checksum += slotMapTimers.getTimer(timerHandle)->timeOut;
+				}
+			}
+		});
+		const double frameTime = getMilliseconds([&]()
+		{
+			for (int frame = 0; frame < NUM_FRAMES; ++frame)
+			{
+				for (int i = 0; i < NUM_STOPPED_PER_FRAME; ++i)
+				{
+					numErrors += slotMapTimers.stop(timerHandles[frame * NUM_STOPPED_PER_FRAME + i]) ? 0 : 1;
+				}
+				slotMapTimers.update();
+			}
+		});
+		const double stopTime = getMilliseconds([&]()
+		{
+			for (size_t i = NUM_STOPPED_PER_FRAME * NUM_FRAMES; i < timerHandles.size(); ++i)
+			{
+				numErrors += slotMapTimers.stop(timerHandles[i]) ? 0 : 1;
+			}
+			slotMapTimers.update();
+		});
+		numErrors += slotMapTimers.getNumTimers() == 0 ? 0 : 1;
+		// stale handles
+		for (SlotMapHandle timerHandle : timerHandles)
+		{
+			numErrors += slotMapTimers.getTimer(timerHandle) == nullptr && !slotMapTimers.stop(timerHandle) ? 0 : 1;
+		}
+		std::printf("slot map:         %d lookups %8.3f ms, %d stopped per frame %8.3f ms per frame, stop the others %8.3f ms\n",
+			numTimers * NUM_LOOKUP_ROUNDS, lookupTime, NUM_STOPPED_PER_FRAME, frameTime / NUM_FRAMES, stopTime);
+	}
+
+	std::printf("every timer stopped once (%.0f): %s\n", checksum, numErrors == 0 ? "ok" : "FAILED");
+	return numErrors == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+
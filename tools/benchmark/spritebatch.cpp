@@ -0,0 +1,166 @@
+// benchmark of render::SpriteBatch with 100k sprites moved every frame: CPU time per frame and memory
+// standalone, needs SDL2, GLEW and an OpenGL 3.3 driver, linux only for the resident memory, build from the
+// repository root with:
+//   g++ -std=c++17 -O2 -DFLAT_MEMORY_TRACKING_ENABLED -Isrc tools/benchmark/spritebatch.cpp src/render/spritebatch.cpp
+//     src/render/basesprite.cpp src/render/sprite.cpp src/render/rendersettings.cpp src/video/texture.cpp
+//     src/video/filetexture.cpp src/video/color.cpp src/video/streambuffer.cpp src/memory/memorytracker.cpp
+//     -lSDL2 -lSDL2_image -lGLEW -lGL -ltbb -o spritebatch
+// usage: spritebatch [numSprites] [numFrames]
+// each frame every sprite moves, the batch is cleared, filled and drawn, once with each vertex format
+// the CPU time of each frame is measured, glFinish() is called after so that the GPU work does not add to the next frame
+// the resident memory of the process is read from /proc/self/statm, the RENDER tag counts the vertices kept by the
+// batch and the stream buffer, which lives in driver memory
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include <unistd.h>
+
+#include <GL/glew.h>
+#include <SDL2/SDL.h>
+
+#include "render/spritebatch.h"
+#include "render/sprite.h"
+#include "render/rendersettings.h"
+#include "video/texture.h"
+#include "memory/memorytracker.h"
+
+using flat::Vector2;
+namespace render = flat::render;
+namespace video = flat::video;
+namespace memory = flat::memory;
+
+namespace
+{
+
+constexpr int DEFAULT_NUM_SPRITES = 100000;
+constexpr int DEFAULT_NUM_FRAMES = 60;
+constexpr float WORLD_SIZE = 4096.f;
+constexpr double MEGABYTE = 1024.0 * 1024.0;
+
+class Random
+{
+	public:
+		explicit Random(std::uint32_t seed) : m_state(seed) {}
+
+		// in [min, max)
+		float next(float min, float max)
+		{
+			m_state = m_state * 1103515245u + 12345u;
+			return min + static_cast<float>((m_state >> 8) % 100000) / 100000.f * (max - min);
+		}
+
+	private:
+		std::uint32_t m_state;
+};
+
+double getResidentMegabytes()
+{
+	FILE* file = std::fopen("/proc/self/statm", "r");
+	if (file == nullptr)
+	{
+		return 0.0;
+	}
+	long numPages = 0;
+	long numResidentPages = 0;
+	const int numRead = std::fscanf(file, "%ld %ld", &numPages, &numResidentPages);
+	std::fclose(file);
+	return numRead == 2 ? static_cast<double>(numResidentPages) * static_cast<double>(sysconf(_SC_PAGESIZE)) / MEGABYTE : 0.0;
+}
+
+double getRenderMegabytes()
+{
+	return static_cast<double>(memory::MemoryTracker::getStats(memory::MemoryTag::RENDER).liveBytes) / MEGABYTE;
+}
+
+// returns the number of sprites drawn by the last frame
+size_t benchmark(const char* name, render::SpriteBatch::VertexFormat vertexFormat, std::vector<render::Sprite>& sprites, int numFrames)
+{
+	std::vector<const render::BaseSprite*> spritePointers;
+	for (const render::Sprite& sprite : sprites)
+	{
+		spritePointers.push_back(&sprite);
+	}
+	const render::RenderSettings renderSettings;
+	const flat::Matrix4 viewMatrix(1.f);
+
+	const double residentBefore = getResidentMegabytes();
+	const double renderBefore = getRenderMegabytes();
+	size_t numDrawnSprites = 0;
+	std::vector<double> times;
+	{
+		render::SpriteBatch spriteBatch(vertexFormat);
+		for (int frame = 0; frame < numFrames; ++frame)
+		{
+			const auto start = std::chrono::steady_clock::now();
+			const Vector2 move(frame % 2 == 0 ? 1.f : -1.f, 0.f);
+			for (render::Sprite& sprite : sprites)
+			{
+				sprite.moveBy(move);
+			}
+			spriteBatch.clear();
+			spriteBatch.add(spritePointers.data(), spritePointers.size());
+			spriteBatch.draw(renderSettings, viewMatrix);
+			times.push_back(std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count());
+			glFinish();
+			FLAT_TRACK_END_FRAME();
+		}
+		numDrawnSprites = spriteBatch.getNumSprites();
+
+		std::sort(times.begin(), times.end());
+		std::printf("%-8s %8.2f ms per frame (best %.2f), %zu bytes per sprite, resident +%.1f MB, RENDER tag +%.1f MB\n",
+			name, times[times.size() / 2], times.front(), spriteBatch.getSpriteSize(),
+			getResidentMegabytes() - residentBefore, getRenderMegabytes() - renderBefore);
+	}
+	return numDrawnSprites;
+}
+
+} // namespace
+
+int main(int argc, char* argv[])
+{
+	const int numSprites = argc > 1 ? std::max(std::atoi(argv[1]), 1) : DEFAULT_NUM_SPRITES;
+	const int numFrames = argc > 2 ? std::max(std::atoi(argv[2]), 1) : DEFAULT_NUM_FRAMES;
+
+	SDL_Init(SDL_INIT_VIDEO);
+	SDL_GL_SetAttribute(SDL_GL_CONTEXT_MAJOR_VERSION, 3);
+	SDL_GL_SetAttribute(SDL_GL_CONTEXT_MINOR_VERSION, 3);
+	SDL_Window* window = SDL_CreateWindow("spritebatch", SDL_WINDOWPOS_UNDEFINED, SDL_WINDOWPOS_UNDEFINED, 640, 360, SDL_WINDOW_OPENGL | SDL_WINDOW_HIDDEN);
+	SDL_GLContext glContext = window != nullptr ? SDL_GL_CreateContext(window) : nullptr;
+	glewExperimental = GL_TRUE;
+	if (glContext == nullptr || glewInit() != GLEW_OK)
+	{
+		std::printf("could not create an OpenGL context: %s\n", SDL_GetError());
+		return EXIT_FAILURE;
+	}
+
+	int numErrors = 0;
+	{
+		std::shared_ptr<const video::Texture> texture = std::make_shared<video::Texture>(0, Vector2(32.f, 32.f), "sprites");
+		Random random(13);
+		std::vector<render::Sprite> sprites(numSprites);
+		for (render::Sprite& sprite : sprites)
+		{
+			sprite.setTexture(texture);
+			sprite.setPosition(Vector2(random.next(0.f, WORLD_SIZE), random.next(0.f, WORLD_SIZE)));
+		}
+
+		std::printf("%d sprites, %d frames, resident %.1f MB\n", numSprites, numFrames, getResidentMegabytes());
+		const size_t numSpritesPerDraw = static_cast<size_t>(numSprites);
+		numErrors += benchmark("full", render::SpriteBatch::VertexFormat::FULL, sprites, numFrames) == numSpritesPerDraw ? 0 : 1;
+		numErrors += benchmark("compact", render::SpriteBatch::VertexFormat::COMPACT, sprites, numFrames) == numSpritesPerDraw ? 0 : 1;
+		std::printf("every sprite batched: %s\n", numErrors == 0 ? "ok" : "FAILED");
+	}
+
+	SDL_GL_DeleteContext(glContext);
+	SDL_DestroyWindow(window);
+	SDL_Quit();
+	return numErrors == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+
@@ -0,0 +1,205 @@
+// benchmark of render::StaticSpriteLayer against drawing the same map with render::SpriteBatch and render::SpriteRenderer
+// standalone, needs SDL2, GLEW and an OpenGL 3.3 driver, build from the repository root with:
+//   g++ -std=c++17 -O2 -Isrc tools/benchmark/staticspritelayer.cpp src/render/staticspritelayer.cpp
+//     src/render/spritebatch.cpp src/render/spriterenderer.cpp src/render/basesprite.cpp src/render/sprite.cpp
+//     src/render/rendersettings.cpp src/video/texture.cpp src/video/filetexture.cpp src/video/program.cpp
+//     src/video/view.cpp src/video/color.cpp src/video/streambuffer.cpp -lSDL2 -lSDL2_image -lGLEW -lGL -ltbb -o staticspritelayer
+// usage: staticspritelayer [numFrames]
+// a map of 200k 32 units tiles (500 x 400) using 4 tile sets seen through a 1920 units wide view, before: every tile
+// is batched each frame, or queued in a SpriteRenderer culled by the view, after: the tiles are added once to the layer
+// which is drawn without changes, then with 100 tiles moved each frame
+// the CPU time of each frame is measured, glFinish() is called after so that the GPU work does not add to the next frame
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include <GL/glew.h>
+#include <SDL2/SDL.h>
+
+#include "render/staticspritelayer.h"
+#include "render/spriterenderer.h"
+#include "render/sprite.h"
+#include "render/programsettings.h"
+#include "render/rendersettings.h"
+#include "video/texture.h"
+#include "video/view.h"
+
+using flat::Vector2;
+namespace render = flat::render;
+namespace video = flat::video;
+
+namespace
+{
+
+constexpr int MAP_WIDTH = 500;
+constexpr int MAP_HEIGHT = 400;
+constexpr float TILE_SIZE = 32.f;
+constexpr int NUM_TILE_SETS = 4;
+constexpr float VIEW_WIDTH = 1920.f;
+constexpr int NUM_MOVED_TILES = 100;
+constexpr int DEFAULT_NUM_FRAMES = 30;
+
+class Random
+{
+	public:
+		explicit Random(std::uint32_t seed) : m_state(seed) {}
+
+		// in [0, max)
+		int next(int max)
+		{
+			m_state = m_state * 1103515245u + 12345u;
+			return static_cast<int>((m_state >> 8) % static_cast<std::uint32_t>(max));
+		}
+
+	private:
+		std::uint32_t m_state;
+};
+
+double getMilliseconds(std::chrono::steady_clock::time_point start)
+{
+	return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+// median of the frame times
+template <class Func>
+double timeFrames(int numFrames, Func func)
+{
+	std::vector<double> times;
+	for (int frame = 0; frame < numFrames; ++frame)
+	{
+		const auto start = std::chrono::steady_clock::now();
+		func(frame);
+		times.push_back(getMilliseconds(start));
+		glFinish();
+	}
+	std::nth_element(times.begin(), times.begin() + times.size() / 2, times.end());
+	return times[times.size() / 2];
+}
+
+} // namespace
+
+int main(int argc, char* argv[])
+{
+	const int numFrames = argc > 1 ? std::max(std::atoi(argv[1]), 1) : DEFAULT_NUM_FRAMES;
+
+	SDL_Init(SDL_INIT_VIDEO);
+	SDL_GL_SetAttribute(SDL_GL_CONTEXT_MAJOR_VERSION, 3);
+	SDL_GL_SetAttribute(SDL_GL_CONTEXT_MINOR_VERSION, 3);
+	SDL_Window* window = SDL_CreateWindow("staticspritelayer", SDL_WINDOWPOS_UNDEFINED, SDL_WINDOWPOS_UNDEFINED, 640, 360, SDL_WINDOW_OPENGL | SDL_WINDOW_HIDDEN);
+	SDL_GLContext glContext = window != nullptr ? SDL_GL_CreateContext(window) : nullptr;
+	glewExperimental = GL_TRUE;
+	if (glContext == nullptr || glewInit() != GLEW_OK)
+	{
+		std::printf("could not create an OpenGL context: %s\n", SDL_GetError());
+		return EXIT_FAILURE;
+	}
+
+	int numErrors = 0;
+	{
+		std::vector<std::shared_ptr<const video::Texture>> tileSets;
+		for (int i = 0; i < NUM_TILE_SETS; ++i)
+		{
+			tileSets.push_back(std::make_shared<video::Texture>(0, Vector2(TILE_SIZE, TILE_SIZE), "tile set"));
+		}
+		Random random(7);
+		std::vector<render::Sprite> tiles(MAP_WIDTH * MAP_HEIGHT);
+		for (size_t i = 0; i < tiles.size(); ++i)
+		{
+			tiles[i].setTexture(tileSets[random.next(NUM_TILE_SETS)]);
+			tiles[i].setPosition(Vector2(static_cast<float>(i % MAP_WIDTH) * TILE_SIZE, static_cast<float>(i / MAP_WIDTH) * TILE_SIZE));
+		}
+
+		// centered on the map
+		video::View view;
+		view.zoom(2.f / VIEW_WIDTH);
+		view.move(Vector2(MAP_WIDTH * TILE_SIZE / 2.f, MAP_HEIGHT * TILE_SIZE / 2.f));
+		render::RenderSettings renderSettings;
+		render::ProgramSettings programSettings;
+
+		render::SpriteBatch spriteBatch;
+		const double spriteBatchTime = timeFrames(numFrames, [&](int)
+		{
+			for (const std::shared_ptr<const video::Texture>& tileSet : tileSets)
+			{
+				spriteBatch.clear();
+				for (const render::Sprite& tile : tiles)
+				{
+					if (tile.getTexture() == tileSet)
+					{
+						spriteBatch.add(tile);
+					}
+				}
+				spriteBatch.draw(renderSettings, view.getViewProjectionMatrix());
+			}
+		});
+
+		render::SpriteRenderer spriteRenderer;
+		const double spriteRendererTime = timeFrames(numFrames, [&](int)
+		{
+			spriteRenderer.clear();
+			for (const render::Sprite& tile : tiles)
+			{
+				spriteRenderer.add(tile, programSettings);
+			}
+			spriteRenderer.draw(view);
+		});
+
+		render::StaticSpriteLayer staticSpriteLayer;
+		const auto buildStart = std::chrono::steady_clock::now();
+		for (const render::Sprite& tile : tiles)
+		{
+			staticSpriteLayer.add(tile);
+		}
+		staticSpriteLayer.draw(renderSettings, view);
+		glFinish();
+		const double buildTime = getMilliseconds(buildStart);
+		numErrors += staticSpriteLayer.getNumSprites() == tiles.size() ? 0 : 1;
+
+		const double staticTime = timeFrames(numFrames, [&](int)
+		{
+			staticSpriteLayer.draw(renderSettings, view);
+		});
+		const render::StaticSpriteLayer::Stats staticStats = staticSpriteLayer.getStats();
+		numErrors += staticStats.numUploadedChunks == 0 ? 0 : 1;
+
+		// the tiles stay in place, their model matrix is dirty
+		int numUploadedChunks = 0;
+		const double movingTime = timeFrames(numFrames, [&](int)
+		{
+			for (int i = 0; i < NUM_MOVED_TILES; ++i)
+			{
+				tiles[random.next(static_cast<int>(tiles.size()))].moveBy(Vector2(0.f, 0.f));
+			}
+			staticSpriteLayer.draw(renderSettings, view);
+			numUploadedChunks += staticSpriteLayer.getStats().numUploadedChunks;
+		});
+
+		// removing a tile and moving another one to an empty area uploads the 2 chunks they leave and the new one
+		staticSpriteLayer.remove(tiles[0]);
+		tiles[1].setPosition(Vector2(-10000.f, -10000.f));
+		staticSpriteLayer.draw(renderSettings, view);
+		numErrors += staticSpriteLayer.getStats().numUploadedChunks == 3 ? 0 : 1;
+		numErrors += staticSpriteLayer.getNumSprites() == tiles.size() - 1 ? 0 : 1;
+
+		std::printf("%zu tiles, %d frames, median CPU time per frame\n", tiles.size(), numFrames);
+		std::printf("before, SpriteBatch of every tile:   %8.2f ms\n", spriteBatchTime);
+		std::printf("before, SpriteRenderer with culling: %8.2f ms, %d draws\n", spriteRendererTime, spriteRenderer.getStats().numDrawCalls);
+		std::printf("after, StaticSpriteLayer:            %8.2f ms, %d draws of %d chunks, built in %.2f ms\n",
+			staticTime, staticStats.numDrawnChunks, staticStats.numChunks, buildTime);
+		std::printf("after, %d tiles moved per frame:    %8.2f ms, %.1f chunks uploaded per frame\n",
+			NUM_MOVED_TILES, movingTime, static_cast<double>(numUploadedChunks) / numFrames);
+		std::printf("chunks uploaded and sprites counted: %s\n", numErrors == 0 ? "ok" : "FAILED");
+	}
+
+	SDL_GL_DeleteContext(glContext);
+	SDL_DestroyWindow(window);
+	SDL_Quit();
+	return numErrors == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+
@@ -4,6 +4,8 @@ var BinaryReader = {
         PUSH_SECTION:  '\x00',
         POP_SECTION:   '\x01',
         SECTION_NAMES: '\x02',
+        MEMORY_STATS:  '\x03',
+        COUNTER:       '\x04',
     },
 
     fromString: function(string) {
@@ -33,6 +35,34 @@ var BinaryReader = {
             return result;
         }
 
+        // memory tracker counters, one entry per frame, tag names are stored with the section names
+        var memoryStats = [];
+
+        function readMemoryStats() {
+            var time = binaryStringToNumber(readNBytes(8));
+            var numTags = binaryStringToNumber(readNBytes(1));
+            var tags = [];
+            for (var i = 0; i < numTags; ++i) {
+                tags.push({
+                    sectionId:      binaryStringToNumber(readNBytes(2)),
+                    liveBytes:      binaryStringToNumber(readNBytes(8)),
+                    allocatedBytes: binaryStringToNumber(readNBytes(8)),
+                    numAllocations: binaryStringToNumber(readNBytes(8))
+                });
+            }
+            memoryStats.push({ time: time, tags: tags });
+        }
+
+        // named counters, counter names are stored with the section names
+        var counters = [];
+
+        function readCounter() {
+            var sectionId = binaryStringToNumber(readNBytes(2));
+            var time = binaryStringToNumber(readNBytes(8));
+            var value = binaryStringToNumber(readNBytes(8));
+            counters.push({ sectionId: sectionId, time: time, value: value });
+        }
+
         function readEvents(parent) {
             while (true) {
                 var code = readNBytes(1);
@@ -48,6 +78,10 @@ var BinaryReader = {
                     event.sectionId = binaryStringToNumber(sectionId);
                     event.startTime = binaryStringToNumber(startTime);
                     event.endTime   = binaryStringToNumber(endTime);
+                } else if (code == BinaryReader.Codes.MEMORY_STATS) {
+                    readMemoryStats();
+                } else if (code == BinaryReader.Codes.COUNTER) {
+                    readCounter();
                 } else if (code == BinaryReader.Codes.POP_SECTION) {
                     pushBackNBytes(1);
                     break;
@@ -83,6 +117,8 @@ var BinaryReader = {
         return {
             profiledEvents: profiledEvents,
             sectionNames:   sectionNames,
+            memoryStats:    memoryStats,
+            counters:       counters,
             startTime:      startTime,
             endTime:        endTime
         };
@@ -0,0 +1,262 @@
+// stress test and contention benchmark for containers::ConcurrentDynamicPool
+// standalone, build from the repository root with:
+//   g++ -std=c++17 -O2 -pthread -DFLAT_DEBUG -Isrc tools/stress/concurrentdynamicpool.cpp -o concurrentdynamicpool
+// usage: concurrentdynamicpool [maxThreads]
+// the contention numbers only mean something with as many cores as threads, the hardware concurrency is printed first
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "containers/concurrentdynamicpool.h"
+
+using flat::containers::ConcurrentDynamicPool;
+
+namespace
+{
+
+constexpr size_t POOL_SIZE = 1 << 16;
+constexpr int NUM_STRESS_ITERATIONS = 200000;
+constexpr size_t MAX_LIVE_OBJECTS_PER_THREAD = 1000;
+constexpr int NUM_BENCHMARK_PAIRS = 16 * 1000 * 1000;
+
+struct Object
+{
+	Object(int owner, std::uint32_t serial) :
+		owner(owner),
+		serial(serial),
+		checksum(makeChecksum(owner, serial))
+	{
+
+	}
+
+	static std::uint32_t makeChecksum(int owner, std::uint32_t serial)
+	{
+		return (static_cast<std::uint32_t>(owner) * 2654435761u) ^ (serial * 40503u) ^ 0xA5A5A5A5u;
+	}
+
+	bool isIntact() const { return checksum == makeChecksum(owner, serial); }
+
+	int owner;
+	std::uint32_t serial;
+	std::uint32_t checksum;
+	char padding[20];
+};
+
+// objects created by one thread and destroyed by another
+class Handoff
+{
+	public:
+		void give(Object* object)
+		{
+			std::lock_guard<std::mutex> lock(m_mutex);
+			m_objects.push_back(object);
+		}
+
+		Object* take()
+		{
+			std::lock_guard<std::mutex> lock(m_mutex);
+			if (m_objects.empty())
+			{
+				return nullptr;
+			}
+			Object* object = m_objects.back();
+			m_objects.pop_back();
+			return object;
+		}
+
+	private:
+		std::mutex m_mutex;
+		std::vector<Object*> m_objects;
+};
+
+// random creations and destructions from every thread, through the pool or through magazines
+// each live object is checked on every destruction: no two threads may ever get the same entry
+int stress(int numThreads, bool useMagazines)
+{
+	ConcurrentDynamicPool pool;
+	pool.init(sizeof(Object), POOL_SIZE);
+	Handoff handoff;
+	std::atomic<int> numErrors(0);
+
+	std::vector<std::thread> threads;
+	for (int threadIndex = 0; threadIndex < numThreads; ++threadIndex)
+	{
+		threads.emplace_back([&pool, &handoff, &numErrors, threadIndex, useMagazines]()
+		{
+			ConcurrentDynamicPool::Magazine magazine(pool);
+			auto create = [&](std::uint32_t serial) { return useMagazines ? magazine.create<Object>(threadIndex, serial) : pool.create<Object>(threadIndex, serial); };
+			auto destroy = [&](Object* object) { if (useMagazines) magazine.destroy(object); else pool.destroy(object); };
+
+			std::vector<Object*> objects;
+			std::uint32_t random = static_cast<std::uint32_t>(threadIndex) * 7919u + 1u;
+			for (int i = 0; i < NUM_STRESS_ITERATIONS; ++i)
+			{
+				random = random * 1103515245u + 12345u;
+				const std::uint32_t action = (random >> 16) % 8;
+				if (action < 5 && objects.size() < MAX_LIVE_OBJECTS_PER_THREAD)
+				{
+					Object* object = create(static_cast<std::uint32_t>(i));
+					if (object == nullptr)
+					{
+						++numErrors;
+						continue;
+					}
+					objects.push_back(object);
+				}
+				else if (action == 5 && !objects.empty())
+				{
+					handoff.give(objects.back());
+					objects.pop_back();
+				}
+				else if (action == 6)
+				{
+					Object* object = handoff.take();
+					if (object != nullptr)
+					{
+						numErrors += object->isIntact() ? 0 : 1;
+						destroy(object);
+					}
+				}
+				else if (!objects.empty())
+				{
+					const size_t index = (random >> 8) % objects.size();
+					Object* object = objects[index];
+					numErrors += object->owner == threadIndex && object->isIntact() ? 0 : 1;
+					objects[index] = objects.back();
+					objects.pop_back();
+					destroy(object);
+				}
+			}
+
+			for (Object* object : objects)
+			{
+				numErrors += object->owner == threadIndex && object->isIntact() ? 0 : 1;
+				destroy(object);
+			}
+		});
+	}
+	for (std::thread& thread : threads)
+	{
+		thread.join();
+	}
+
+	while (Object* object = handoff.take())
+	{
+		numErrors += object->isIntact() ? 0 : 1;
+		pool.destroy(object);
+	}
+
+	// every entry must be available again, exactly once
+	std::vector<Object*> objects;
+	for (size_t i = 0; i < POOL_SIZE; ++i)
+	{
+		Object* object = pool.create<Object>(0, static_cast<std::uint32_t>(i));
+		if (object == nullptr)
+		{
+			++numErrors;
+			break;
+		}
+		objects.push_back(object);
+	}
+	std::sort(objects.begin(), objects.end());
+	numErrors += std::adjacent_find(objects.begin(), objects.end()) == objects.end() ? 0 : 1;
+	for (Object* object : objects)
+	{
+		pool.destroy(object);
+	}
+
+	std::printf("stress, %2d threads, %s: %d errors\n", numThreads, useMagazines ? "magazines" : "pool     ", numErrors.load());
+	return numErrors.load();
+}
+
+enum class Allocation
+{
+	NEW_DELETE,
+	POOL,
+	MAGAZINE
+};
+
+// each thread creates then destroys batches of 64 objects, the total amount of work does not depend on the number of threads
+double benchmark(int numThreads, Allocation allocation)
+{
+	constexpr int BATCH_SIZE = 64;
+	ConcurrentDynamicPool pool;
+	pool.init(sizeof(Object), POOL_SIZE);
+
+	const auto start = std::chrono::steady_clock::now();
+	std::vector<std::thread> threads;
+	for (int threadIndex = 0; threadIndex < numThreads; ++threadIndex)
+	{
+		threads.emplace_back([&pool, numThreads, threadIndex, allocation]()
+		{
+			ConcurrentDynamicPool::Magazine magazine(pool);
+			Object* objects[BATCH_SIZE];
+			const int numBatches = NUM_BENCHMARK_PAIRS / BATCH_SIZE / numThreads;
+			for (int batch = 0; batch < numBatches; ++batch)
+			{
+				for (int i = 0; i < BATCH_SIZE; ++i)
+				{
+					switch (allocation)
+					{
+						case Allocation::NEW_DELETE: objects[i] = new Object(threadIndex, i); break;
+						case Allocation::POOL:       objects[i] = pool.create<Object>(threadIndex, i); break;
+						case Allocation::MAGAZINE:   objects[i] = magazine.create<Object>(threadIndex, i); break;
+					}
+				}
+				for (int i = 0; i < BATCH_SIZE; ++i)
+				{
+					switch (allocation)
+					{
+						case Allocation::NEW_DELETE: delete objects[i]; break;
+						case Allocation::POOL:       pool.destroy(objects[i]); break;
+						case Allocation::MAGAZINE:   magazine.destroy(objects[i]); break;
+					}
+				}
+			}
+		});
+	}
+	for (std::thread& thread : threads)
+	{
+		thread.join();
+	}
+	return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+} // namespace
+
+int main(int argc, char* argv[])
+{
+	const int numCores = static_cast<int>(std::thread::hardware_concurrency());
+	const int maxThreads = argc > 1 ? std::max(std::atoi(argv[1]), 1) : std::max(numCores, 4);
+	std::printf("hardware concurrency: %d\n", numCores);
+
+	int numErrors = 0;
+	for (int numThreads = 1; numThreads <= maxThreads; numThreads *= 2)
+	{
+		numErrors += stress(numThreads, false);
+		numErrors += stress(numThreads, true);
+	}
+
+	std::printf("%d create/destroy pairs\n", NUM_BENCHMARK_PAIRS);
+	for (int numThreads = 1; numThreads <= maxThreads; numThreads *= 2)
+	{
+		const double newDeleteTime = benchmark(numThreads, Allocation::NEW_DELETE);
+		const double poolTime = benchmark(numThreads, Allocation::POOL);
+		const double magazineTime = benchmark(numThreads, Allocation::MAGAZINE);
+		std::printf("%2d threads: new/delete %7.1f ms, pool %7.1f ms, magazines %7.1f ms%s\n",
+			numThreads, newDeleteTime, poolTime, magazineTime,
+			numThreads > numCores ? " (more threads than cores, no real contention)" : "");
+	}
+
+	return numErrors == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+